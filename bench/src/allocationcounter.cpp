@@ -0,0 +1,145 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file allocationcounter.cpp
+ * @brief Replacements for the global allocation functions that count allocations.
+ */
+
+#include "allocationcounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	std::atomic<std::uint64_t> allocations{0};
+
+	void * countedAllocate(std::size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+
+		// malloc(0) is permitted to return nullptr, operator new is not
+		if(auto * ptr = std::malloc(0 == size ? 1 : size); ptr) {
+			return ptr;
+		}
+
+		throw std::bad_alloc();
+	}
+
+	void * countedAllocate(std::size_t size, std::align_val_t alignment)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		const auto align = static_cast<std::size_t>(alignment);
+
+		// aligned_alloc() requires the size to be a multiple of the alignment
+		if(auto * ptr = std::aligned_alloc(align, ((0 == size ? 1 : size) + align - 1) / align * align); ptr) {
+			return ptr;
+		}
+
+		throw std::bad_alloc();
+	}
+}	// namespace
+
+namespace Qonvince::Bench
+{
+	std::uint64_t allocationCount() noexcept
+	{
+		return allocations.load(std::memory_order_relaxed);
+	}
+}	// namespace Qonvince::Bench
+
+void * operator new(std::size_t size)
+{
+	return countedAllocate(size);
+}
+
+void * operator new[](std::size_t size)
+{
+	return countedAllocate(size);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+	return countedAllocate(size, alignment);
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment)
+{
+	return countedAllocate(size, alignment);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	try {
+		return countedAllocate(size);
+	} catch(const std::bad_alloc &) {
+		return nullptr;
+	}
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	try {
+		return countedAllocate(size);
+	} catch(const std::bad_alloc &) {
+		return nullptr;
+	}
+}
+
+void operator delete(void * ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void * ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void * ptr, std::size_t, std::align_val_t) noexcept
+{
+	std::free(ptr);
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_BENCH_ALLOCATIONCOUNTER_H
+#define QONVINCE_BENCH_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+namespace Qonvince::Bench
+{
+	/**
+	 * The number of calls made to the global operator new since the program started.
+	 *
+	 * The benchmark executable replaces the global allocation functions to maintain this count. Only allocations made
+	 * through operator new are counted - Qt containers such as QByteArray allocate their storage with malloc() directly
+	 * so they don't show up.
+	 */
+	std::uint64_t allocationCount() noexcept;
+}	// namespace Qonvince::Bench
+
+#endif  // QONVINCE_BENCH_ALLOCATIONCOUNTER_H
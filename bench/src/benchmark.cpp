@@ -0,0 +1,102 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file benchmark.cpp
+ * @brief Implementation of the benchmark Runner class.
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <iostream>
+
+using nlohmann::json;
+
+namespace Qonvince::Bench
+{
+	Runner::Runner(std::chrono::nanoseconds minTime, int repetitions, std::string filter)
+	: m_minTime(minTime),
+	  m_repetitions(std::max(1, repetitions)),
+	  m_filter(std::move(filter))
+	{}
+
+	bool Runner::isSelected(const std::string & name) const
+	{
+		return m_filter.empty() || std::string::npos != name.find(m_filter);
+	}
+
+	std::uint64_t Runner::nextIterationCount(std::uint64_t iterations, Clock::duration elapsed) const
+	{
+		const auto elapsedNs = std::max<std::int64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+		// aim a little beyond the minimum time so that calibration usually finishes in one more round, but never grow by
+		// more than 10x in case the first few iterations were unrepresentatively fast
+		const auto target = static_cast<double>(iterations) * 1.2 * static_cast<double>(m_minTime.count()) / static_cast<double>(elapsedNs);
+		const auto next = static_cast<std::uint64_t>(std::min(target, static_cast<double>(iterations) * 10.0));
+		return std::min(MaxIterations, std::max(iterations + 1, next));
+	}
+
+	double Runner::median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		const auto middle = values.size() / 2;
+
+		if(0 == values.size() % 2) {
+			return (values[middle - 1] + values[middle]) / 2.0;
+		}
+
+		return values[middle];
+	}
+
+	void Runner::addResult(Result && result)
+	{
+		// progress goes to stderr so that stdout only ever has the JSON report on it
+		std::cerr << result.name << ": " << result.nsPerOp << " ns/op, " << result.allocationsPerOp << " allocations/op\n";
+		m_results.push_back(std::move(result));
+	}
+
+	json Runner::toJson() const
+	{
+		auto results = json::array();
+
+		for(const auto & result : m_results) {
+			json entry = {
+				{"name", result.name},
+				{"iterations", result.iterations},
+				{"ns_per_op", result.nsPerOp},
+				{"ops_per_second", 0.0 < result.nsPerOp ? 1e9 / result.nsPerOp : 0.0},
+				{"allocations_per_op", result.allocationsPerOp},
+			};
+
+			if(0 < result.bytesPerOp && 0.0 < result.nsPerOp) {
+				entry["bytes_per_op"] = result.bytesPerOp;
+				entry["mb_per_second"] = static_cast<double>(result.bytesPerOp) * 1e3 / result.nsPerOp;
+			}
+
+			results.push_back(std::move(entry));
+		}
+
+		return {
+			{"min_time_ms", std::chrono::duration_cast<std::chrono::milliseconds>(m_minTime).count()},
+			{"repetitions", m_repetitions},
+			{"results", std::move(results)},
+		};
+	}
+}	// namespace Qonvince::Bench
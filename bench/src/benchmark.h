@@ -0,0 +1,145 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_BENCH_BENCHMARK_H
+#define QONVINCE_BENCH_BENCHMARK_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "allocationcounter.h"
+
+namespace Qonvince::Bench
+{
+	/**
+	 * Prevent the compiler from optimising away the computation of a value that is otherwise unused.
+	 */
+	template<typename T>
+	inline void doNotOptimise(const T & value)
+	{
+		asm volatile("" : : "r"(&value) : "memory");
+	}
+
+	/**
+	 * The measurements for one benchmark.
+	 */
+	struct Result
+	{
+		std::string name;
+		std::uint64_t iterations;
+		double nsPerOp;
+		double allocationsPerOp;
+
+		// how much data each operation processes, 0 if throughput in bytes is not meaningful
+		std::size_t bytesPerOp;
+	};
+
+	/**
+	 * Runs benchmarks and collects their results.
+	 *
+	 * Each benchmark is first calibrated to find how many iterations take at least the minimum time. That many iterations
+	 * are then timed for each repetition and the median time is reported, which keeps the occasional descheduled run from
+	 * skewing the result. Allocations are counted over the same iterations.
+	 */
+	class Runner
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		Runner(std::chrono::nanoseconds minTime, int repetitions, std::string filter);
+
+		// benchmarks whose name doesn't contain the filter are skipped
+		[[nodiscard]] bool isSelected(const std::string & name) const;
+
+		template<typename Fn>
+		void run(const std::string & name, std::size_t bytesPerOp, Fn && fn)
+		{
+			if(!isSelected(name)) {
+				return;
+			}
+
+			// warm up caches and any lazily-initialised state before calibrating
+			fn();
+			const auto iterations = calibrate(fn);
+			std::vector<double> nsPerOp;
+			std::uint64_t minAllocations = UINT64_MAX;
+
+			for(int repetition = 0; repetition < m_repetitions; ++repetition) {
+				const auto allocationsBefore = allocationCount();
+				const auto start = Clock::now();
+
+				for(std::uint64_t iteration = 0; iteration < iterations; ++iteration) {
+					fn();
+				}
+
+				const auto elapsed = Clock::now() - start;
+				minAllocations = std::min(minAllocations, allocationCount() - allocationsBefore);
+				nsPerOp.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / static_cast<double>(iterations));
+			}
+
+			addResult({name, iterations, median(nsPerOp), static_cast<double>(minAllocations) / static_cast<double>(iterations), bytesPerOp});
+		}
+
+		[[nodiscard]] const std::vector<Result> & results() const
+		{
+			return m_results;
+		}
+
+		[[nodiscard]] nlohmann::json toJson() const;
+
+	private:
+		template<typename Fn>
+		std::uint64_t calibrate(Fn & fn) const
+		{
+			std::uint64_t iterations = 1;
+
+			while(true) {
+				const auto start = Clock::now();
+
+				for(std::uint64_t iteration = 0; iteration < iterations; ++iteration) {
+					fn();
+				}
+
+				const auto elapsed = Clock::now() - start;
+
+				if(elapsed >= m_minTime || MaxIterations <= iterations) {
+					return iterations;
+				}
+
+				iterations = nextIterationCount(iterations, elapsed);
+			}
+		}
+
+		static constexpr const std::uint64_t MaxIterations = 1'000'000'000;
+
+		[[nodiscard]] std::uint64_t nextIterationCount(std::uint64_t iterations, Clock::duration elapsed) const;
+		static double median(std::vector<double> values);
+		void addResult(Result && result);
+
+		std::chrono::nanoseconds m_minTime;
+		int m_repetitions;
+		std::string m_filter;
+		std::vector<Result> m_results;
+	};
+}	// namespace Qonvince::Bench
+
+#endif  // QONVINCE_BENCH_BENCHMARK_H
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_BENCH_COMMANDLINE_H
+#define QONVINCE_BENCH_COMMANDLINE_H
+
+#include <array>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace Qonvince::Bench
+{
+	// what to do with the value of each option. a handler throws std::logic_error (as std::stoi() does) if the value is
+	// not valid
+	using OptionHandlers = std::unordered_map<std::string, std::function<void(const std::string &)>>;
+
+	/**
+	 * Parse the options of a benchmark tool, all of which take a value.
+	 *
+	 * Problems are reported on stderr; the caller is expected to print its usage if this returns false.
+	 */
+	inline bool parseOptions(int argc, char ** argv, const OptionHandlers & handlers)
+	{
+		for(int idx = 1; idx < argc; ++idx) {
+			const std::string arg = argv[idx];
+			const auto handler = handlers.find(arg);
+
+			if(handlers.cend() == handler) {
+				std::cerr << "unrecognised argument \"" << arg << "\"\n";
+				return false;
+			}
+
+			if(argc <= idx + 1) {
+				std::cerr << "missing argument for " << arg << " option\n";
+				return false;
+			}
+
+			const std::string value = argv[++idx];
+
+			try {
+				handler->second(value);
+			} catch(const std::logic_error &) {
+				std::cerr << "invalid value \"" << value << "\" for " << arg << " option\n";
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// sends anything written to stdout to stderr until it's restored, so that stdout only carries the report
+	class StdoutRedirect final
+	{
+	public:
+		StdoutRedirect()
+		: m_stdoutBuffer(std::cout.rdbuf(std::cerr.rdbuf()))
+		{
+		}
+
+		~StdoutRedirect()
+		{
+			restore();
+		}
+
+		StdoutRedirect(const StdoutRedirect &) = delete;
+		StdoutRedirect(StdoutRedirect &&) = delete;
+		void operator=(const StdoutRedirect &) = delete;
+		void operator=(StdoutRedirect &&) = delete;
+
+		void restore()
+		{
+			if(m_stdoutBuffer) {
+				std::cout.rdbuf(m_stdoutBuffer);
+				m_stdoutBuffer = nullptr;
+			}
+		}
+
+	private:
+		std::streambuf * m_stdoutBuffer;
+	};
+
+	// write a report to the named file, or to stdout if no file is named
+	inline bool writeReport(const nlohmann::json & report, const std::string & fileName)
+	{
+		if(fileName.empty()) {
+			std::cout << report.dump(2) << "\n";
+			return true;
+		}
+
+		std::ofstream out(fileName);
+
+		if(!(out << report.dump(2) << "\n")) {
+			std::cerr << "failed to write the report to \"" << fileName << "\"\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	// the arguments for an Application under test. it only gets the program name, so it doesn't try to act on the tool's
+	// own options. the display plugins the vaults use are built into the application, so it needs no plugin paths
+	class ApplicationArguments final
+	{
+	public:
+		explicit ApplicationArguments(char * programName)
+		: m_args{programName, nullptr},
+		  m_count(1)
+		{
+		}
+
+		int & count()
+		{
+			return m_count;
+		}
+
+		char ** values()
+		{
+			return m_args.data();
+		}
+
+	private:
+		std::array<char *, 2> m_args;
+		int m_count;
+	};
+}	// namespace Qonvince::Bench
+
+#endif  // QONVINCE_BENCH_COMMANDLINE_H
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file main.cpp
+ * @brief Microbenchmarks for the code generation hot path.
+ *
+ * Writes a JSON report to stdout (or the file named with --output) so that results can be tracked across releases.
+ * Progress and plugin loading messages go to stderr.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+#include <QtGlobal>
+#include <QByteArray>
+#include <QDateTime>
+#include <QtEndian>
+#include <nlohmann/json.hpp>
+
+#include "benchmark.h"
+#include "commandline.h"
+#include "otp.h"
+#include "base32.h"
+#include "otpdisplayplugin.h"
+#include "pluginfactory.h"
+#include "securestring.h"
+
+using nlohmann::json;
+using LibQonvince::SecureString;
+using Qonvince::Bench::Runner;
+using Qonvince::Bench::doNotOptimise;
+
+namespace
+{
+	using DisplayPluginFactory = Qonvince::PluginFactory<LibQonvince::OtpDisplayPlugin>;
+
+	// the seed from the RFC 4226 test vectors
+	const SecureString Seed = "12345678901234567890";
+
+	constexpr const std::array<std::size_t, 4> Base32Sizes = {{10, 20, 64, 1024}};
+
+	void printUsage()
+	{
+		std::cerr << "usage: qonvince_bench [--filter <substring>] [--min-time-ms <ms>] [--repetitions <n>] [--output <file>] [--plugin-path <path>]...\n";
+	}
+
+	void benchmarkOtp(Runner & runner)
+	{
+		QByteArray message(8, '\0');
+		qToBigEndian<quint64>(1, message.data());
+
+		runner.run("otp/hmac", static_cast<std::size_t>(message.size()), [&message]() {
+			doNotOptimise(Qonvince::Otp::hmac(Seed, message));
+		});
+
+		std::uint64_t counter = 0;
+
+		runner.run("otp/hotp", 0, [&counter]() {
+			doNotOptimise(Qonvince::Otp::hotp(Seed, counter++));
+		});
+
+		runner.run("otp/totp", 0, []() {
+			doNotOptimise(Qonvince::Otp::totp(Seed));
+		});
+	}
+
+	void benchmarkBase32(Runner & runner)
+	{
+		using namespace LibQonvince::Base32Codec;
+
+		for(const auto size : Base32Sizes) {
+			std::vector<char> plain(size);
+
+			for(std::size_t idx = 0; idx < size; ++idx) {
+				plain[idx] = static_cast<char>(idx * 31 + 7);
+			}
+
+			std::vector<char> encoded(encodedSize(size));
+			encode(std::span<const char>(plain), std::span<char>(encoded));
+
+			runner.run("base32/encode/" + std::to_string(size), size, [&plain, &encoded]() {
+				doNotOptimise(encode(std::span<const char>(plain), std::span<char>(encoded)));
+				doNotOptimise(encoded);
+			});
+
+			std::vector<char> decoded(size);
+
+			runner.run("base32/decode/" + std::to_string(size), encoded.size(), [&encoded, &decoded]() {
+				doNotOptimise(decode(std::span<const char>(encoded), std::span<char>(decoded)));
+				doNotOptimise(decoded);
+			});
+
+			// the path taken for seeds read from otpauth:// URIs and the editor
+			std::vector<char> lenient(encoded.begin(), std::find(encoded.begin(), encoded.end(), '='));
+			std::transform(lenient.begin(), lenient.end(), lenient.begin(), [](char ch) {
+				return static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+			});
+
+			runner.run("base32/decode-lenient/" + std::to_string(size), lenient.size(), [&lenient, &decoded]() {
+				doNotOptimise(decode(std::span<const char>(lenient), std::span<char>(decoded), Normalise::Lenient));
+				doNotOptimise(decoded);
+			});
+		}
+	}
+
+	void benchmarkDisplayPlugins(Runner & runner, DisplayPluginFactory & factory)
+	{
+		using LibQonvince::OtpDisplayPlugin;
+
+		// the HMAC from the first RFC 4226 test vector
+		const auto hmac = Qonvince::Otp::hotp(Seed, 0);
+		const auto digest = OtpDisplayPlugin::Digest(hmac.data(), OtpDisplayPlugin::DigestSize);
+
+		// the digests for a batch of consecutive counters, laid end to end as writeCodes() expects them
+		constexpr const std::size_t BatchSize = 64;
+		std::vector<char> digests(BatchSize * OtpDisplayPlugin::DigestSize);
+
+		for(std::size_t idx = 0; idx < BatchSize; ++idx) {
+			const auto batchHmac = Qonvince::Otp::hotp(Seed, idx);
+			std::copy_n(batchHmac.cbegin(), OtpDisplayPlugin::DigestSize, digests.begin() + static_cast<std::ptrdiff_t>(idx * OtpDisplayPlugin::DigestSize));
+		}
+
+		std::array<char, OtpDisplayPlugin::MaxCodeLength> code = {};
+		std::vector<char> codes(BatchSize * OtpDisplayPlugin::MaxCodeLength);
+		std::vector<std::size_t> lengths(BatchSize);
+
+		for(const auto * plugin : factory.loadedPlugins()) {
+			runner.run("plugin/" + plugin->name(), 0, [plugin, &digest, &code]() {
+				doNotOptimise(plugin->writeCode(digest, code));
+				doNotOptimise(code);
+			});
+
+			// the batch processes BatchSize digests, so divide by BatchSize for the time per code
+			runner.run("plugin/" + plugin->name() + "/batch-" + std::to_string(BatchSize), digests.size(), [plugin, &digests, &codes, &lengths]() {
+				plugin->writeCodes(digests, codes, lengths);
+				doNotOptimise(codes);
+				doNotOptimise(lengths);
+			});
+		}
+	}
+
+	void loadDisplayPlugins(DisplayPluginFactory & factory, const std::vector<std::string> & paths)
+	{
+		for(const auto & path : paths) {
+			factory.addSearchPath(path);
+		}
+
+		factory.loadAllPlugins();
+	}
+}	// namespace
+
+int main(int argc, char * argv[])
+{
+	std::string filter;
+	std::string outputFile;
+	auto minTime = std::chrono::milliseconds(200);
+	int repetitions = 5;
+	// the display plugins built alongside the benchmark
+	std::vector<std::string> pluginPaths = {QONVINCE_BENCH_INTEGER_PLUGIN_DIR, QONVINCE_BENCH_STEAM_PLUGIN_DIR};
+
+	for(int idx = 1; idx < argc; ++idx) {
+		const std::string arg = argv[idx];
+
+		if("--help" == arg) {
+			printUsage();
+			return 0;
+		}
+
+		if(argc <= idx + 1) {
+			std::cerr << "missing argument for " << arg << " option\n";
+			printUsage();
+			return 1;
+		}
+
+		const std::string value = argv[++idx];
+
+		try {
+			if("--filter" == arg) {
+				filter = value;
+			} else if("--min-time-ms" == arg) {
+				minTime = std::chrono::milliseconds(std::stoi(value));
+			} else if("--repetitions" == arg) {
+				repetitions = std::stoi(value);
+			} else if("--output" == arg) {
+				outputFile = value;
+			} else if("--plugin-path" == arg) {
+				pluginPaths.push_back(value);
+			} else {
+				std::cerr << "unrecognised argument \"" << arg << "\"\n";
+				printUsage();
+				return 1;
+			}
+		} catch(const std::logic_error &) {
+			std::cerr << "invalid value \"" << value << "\" for " << arg << " option\n";
+			return 1;
+		}
+	}
+
+	DisplayPluginFactory displayPluginFactory(".displayplugin");
+	loadDisplayPlugins(displayPluginFactory, pluginPaths);
+
+	Runner runner(minTime, repetitions, filter);
+	benchmarkOtp(runner);
+	benchmarkBase32(runner);
+	benchmarkDisplayPlugins(runner, displayPluginFactory);
+
+	auto report = runner.toJson();
+	report["suite"] = "qonvince_bench";
+	report["version"] = QONVINCE_BENCH_VERSION;
+	report["build_type"] = QONVINCE_BENCH_BUILD_TYPE;
+	report["compiler"] = __VERSION__;
+	report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toStdString();
+
+	return (Qonvince::Bench::writeReport(report, outputFile) ? 0 : 1);
+}
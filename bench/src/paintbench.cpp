@@ -0,0 +1,291 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file paintbench.cpp
+ * @brief Benchmark of painting the OTP list with the offscreen platform.
+ *
+ * Fills the list with generated OTPs and measures the frames OtpListView and OtpListItemDelegate produce: the
+ * repaints the view's 1 Hz countdown tick triggers and the repaints while the list is scrolled. Each frame is timed
+ * from the triggering call until the window's pending update has been painted, and the number of allocations made
+ * during the frame is counted. The results are written as JSON.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <QColor>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QIcon>
+#include <QPixmap>
+#include <QScrollBar>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <nlohmann/json.hpp>
+
+#include "application.h"
+#include "otp.h"
+#include "otplistview.h"
+#include "allocationcounter.h"
+#include "commandline.h"
+#include "statistics.h"
+#include "vault.h"
+
+using nlohmann::json;
+using Qonvince::Application;
+using Qonvince::Otp;
+using Qonvince::OtpType;
+using Qonvince::Bench::elapsedMs;
+
+namespace
+{
+	constexpr const int SeedSize = 20;
+	constexpr const int IconCount = 16;
+
+	struct Options
+	{
+		std::string output;
+		int count = 200;
+		int width = 400;
+		int height = 900;
+		int tickSeconds = 10;
+		int scrollFrames = 300;
+		int hotpPercent = 20;
+	};
+
+	// the cost of one frame
+	struct Frame
+	{
+		double ms;
+		double allocations;
+	};
+
+	void printUsage()
+	{
+		std::cerr << "usage: qonvince_paintbench [--count <n>] [--width <px>] [--height <px>] [--tick-seconds <n>] [--scroll-frames <n>] [--hotp-percent <n>] [--output <file>]\n\n"
+					 << "The tick frames are driven at 1 Hz, so they take --tick-seconds in real time.\n";
+	}
+
+	bool parseArguments(int argc, char ** argv, Options & options)
+	{
+		const auto toInt = [](int & option) {
+			return [&option](const std::string & value) {
+				option = std::stoi(value);
+			};
+		};
+
+		const Qonvince::Bench::OptionHandlers handlers = {
+			{"--output", [&options](const std::string & value) { options.output = value; }},
+			{"--count", toInt(options.count)},
+			{"--width", toInt(options.width)},
+			{"--height", toInt(options.height)},
+			{"--tick-seconds", toInt(options.tickSeconds)},
+			{"--scroll-frames", toInt(options.scrollFrames)},
+			{"--hotp-percent", toInt(options.hotpPercent)},
+		};
+
+		if(!Qonvince::Bench::parseOptions(argc, argv, handlers)) {
+			return false;
+		}
+
+		if(0 >= options.count || 0 >= options.width || 0 >= options.height || 0 > options.hotpPercent || 100 < options.hotpPercent) {
+			std::cerr << "--count, --width and --height must be positive and --hotp-percent must be 0 - 100\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	// a deterministic set of OTPs, about half of which have one of a few icons
+	void addOtps(Application & app, const Options & options)
+	{
+		std::mt19937_64 rng(1);
+		std::uniform_int_distribution<int> byte(0, 255);
+		std::vector<QIcon> icons;
+
+		for(int idx = 0; idx < IconCount; ++idx) {
+			QPixmap pixmap(64, 64);
+			pixmap.fill(QColor::fromHsv((idx * 37) % 360, 200, 220));
+			icons.emplace_back(pixmap);
+		}
+
+		for(int idx = 0; idx < options.count; ++idx) {
+			QByteArray seed(SeedSize, '\0');
+
+			for(auto & ch : seed) {
+				ch = static_cast<char>(byte(rng));
+			}
+
+			const auto type = (std::uniform_int_distribution<int>(0, 99)(rng) < options.hotpPercent ? OtpType::Hotp : OtpType::Totp);
+			auto otp = std::make_unique<Otp>(type, QStringLiteral("Issuer %1").arg(idx % 50), QStringLiteral("account%1@example.com").arg(idx), seed);
+			otp->setDisplayPluginName(Qonvince::Bench::displayPluginName(rng));
+
+			if(0 == idx % 2) {
+				otp->setIcon(icons[static_cast<std::size_t>(idx / 2) % icons.size()]);
+			}
+
+			app.addOtp(std::move(otp));
+		}
+	}
+
+	// time something that schedules a repaint of the view, up to the point where the repaint has been done
+	Frame measureFrame(Qonvince::OtpListView & view, const std::function<void()> & trigger)
+	{
+		const auto allocations = Qonvince::Bench::allocationCount();
+		QElapsedTimer timer;
+		timer.start();
+		trigger();
+		QCoreApplication::sendPostedEvents(view.window(), QEvent::UpdateRequest);
+		const auto ms = elapsedMs(timer);
+		return {ms, static_cast<double>(Qonvince::Bench::allocationCount() - allocations)};
+	}
+
+	json summariseFrames(const std::vector<Frame> & frames)
+	{
+		std::vector<double> times;
+		std::vector<double> allocations;
+
+		for(const auto & frame : frames) {
+			times.push_back(frame.ms);
+			allocations.push_back(frame.allocations);
+		}
+
+		std::sort(allocations.begin(), allocations.end());
+		auto report = Qonvince::Bench::summarise(std::move(times));
+
+		report["allocations"] = {
+			{"p50", Qonvince::Bench::percentile(allocations, 50)},
+			{"p95", Qonvince::Bench::percentile(allocations, 95)},
+			{"max", allocations.empty() ? 0.0 : allocations.back()},
+		};
+
+		return report;
+	}
+
+	// the frames the countdown tick produces, at the rate the view produces them
+	json measureTicks(Qonvince::OtpListView & view, int seconds)
+	{
+		std::vector<Frame> frames;
+		QEventLoop loop;
+		QTimer ticker;
+		ticker.setInterval(1000);
+		ticker.setTimerType(Qt::PreciseTimer);
+
+		QObject::connect(&ticker, &QTimer::timeout, &loop, [&view, &frames, &loop, seconds]() {
+			frames.push_back(measureFrame(view, [&view]() {
+				QMetaObject::invokeMethod(&view, "updateCountdowns", Qt::DirectConnection);
+			}));
+
+			if(static_cast<int>(frames.size()) >= seconds) {
+				loop.quit();
+			}
+		});
+
+		if(0 < seconds) {
+			ticker.start();
+			loop.exec();
+		}
+
+		return summariseFrames(frames);
+	}
+
+	// the frames produced scrolling down one step at a time, back to the top when the bottom is reached
+	json measureScrolling(Qonvince::OtpListView & view, int frameCount)
+	{
+		auto * scrollBar = view.verticalScrollBar();
+		std::vector<Frame> frames;
+		frames.reserve(static_cast<std::size_t>(std::max(frameCount, 0)));
+
+		for(int frame = 0; frame < frameCount; ++frame) {
+			frames.push_back(measureFrame(view, [scrollBar]() {
+				const auto next = scrollBar->value() + scrollBar->singleStep();
+				scrollBar->setValue(next > scrollBar->maximum() ? scrollBar->minimum() : next);
+			}));
+		}
+
+		return summariseFrames(frames);
+	}
+}	// namespace
+
+int main(int argc, char * argv[])
+{
+	Options options;
+
+	if(!parseArguments(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+
+	// the application reports progress on stdout, which is reserved for the report
+	Qonvince::Bench::StdoutRedirect stdoutRedirect;
+
+	// the OTPs are never saved, but icons are written as they are set so keep everything away from the real settings
+	QTemporaryDir vault;
+
+	if(!vault.isValid()) {
+		std::cerr << "failed to create a temporary directory for the settings\n";
+		return 1;
+	}
+
+	Qonvince::Bench::useVault(vault.path());
+
+	if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+
+	Qonvince::Bench::ApplicationArguments appArgs(argv[0]);
+	Application app(appArgs.count(), appArgs.values());
+	addOtps(app, options);
+
+	json report = {
+		{"suite", "qonvince_paintbench"},
+		{"version", QONVINCE_BENCH_VERSION},
+		{"build_type", QONVINCE_BENCH_BUILD_TYPE},
+		{"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toStdString()},
+		{"platform", QGuiApplication::platformName().toStdString()},
+		{"codes", app.otpCount()},
+		{"viewport", {{"width", options.width}, {"height", options.height}}},
+	};
+
+	{
+		Qonvince::OtpListView view;
+		view.resize(options.width, options.height);
+		view.show();
+
+		// let the first paint and any layout work happen before anything is measured
+		QEventLoop loop;
+		QTimer::singleShot(100, &loop, &QEventLoop::quit);
+		loop.exec();
+
+		report["tick"] = measureTicks(view, options.tickSeconds);
+		report["scroll"] = measureScrolling(view, options.scrollFrames);
+	}
+
+	report["peak_rss_kib"] = Qonvince::Bench::peakRssKib();
+
+	stdoutRedirect.restore();
+	return (Qonvince::Bench::writeReport(report, options.output) ? 0 : 1);
+}
@@ -0,0 +1,352 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file scalebench.cpp
+ * @brief End-to-end benchmark of Qonvince with a vault created by qonvince_vaultgen.
+ *
+ * Runs the real Application (with the offscreen platform unless QT_QPA_PLATFORM says otherwise) and measures how long
+ * unlocking the vault takes, the peak RSS once it is unlocked, how long the list takes to paint, how long saving takes,
+ * how long each keystroke of a search takes and how much CPU is used around TOTP rollovers. The results are written as
+ * JSON.
+ *
+ * With --virtual-rollovers the application runs on a VirtualClock instead, and each rollover is produced by moving
+ * the clock to the next interval boundary, so the time taken to refresh every code can be measured without waiting.
+ */
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QPixmap>
+#include <QTimer>
+#include <nlohmann/json.hpp>
+
+#include "application.h"
+#include "clock.h"
+#include "commandline.h"
+#include "otp.h"
+#include "otplistview.h"
+#include "otpsearchindex.h"
+#include "settingsunlocker.h"
+#include "statistics.h"
+#include "vault.h"
+
+using nlohmann::json;
+using Qonvince::Application;
+using Qonvince::Otp;
+using Qonvince::Bench::elapsedMs;
+
+namespace
+{
+	// how long each rollover measurement window lasts either side of the boundary
+	constexpr const int RolloverLeadMs = 1000;
+	constexpr const int RolloverWindowMs = 3000;
+
+	struct Options
+	{
+		std::string vault;
+		std::string passphrase = "qonvince-benchmark";
+		std::string output;
+		int paintFrames = 50;
+		int saves = 3;
+		int searches = 10;
+		int rollovers = 1;
+		int virtualRollovers = 0;
+	};
+
+	void printUsage()
+	{
+		std::cerr << "usage: qonvince_scalebench --vault <dir> [--passphrase <passphrase>] [--paint-frames <n>] [--saves <n>] [--searches <n>] [--rollovers <n>] [--virtual-rollovers <n>] [--output <file>]\n\n"
+					 << "Each rollover measurement waits for the next " << Otp::DefaultInterval << "s boundary, so use --rollovers 0 for quick runs.\n"
+					 << "Virtual rollovers don't wait, but can't be combined with real ones.\n"
+					 << "Saving rewrites the vault.\n";
+	}
+
+	bool parseArguments(int argc, char ** argv, Options & options)
+	{
+		const auto toInt = [](int & option) {
+			return [&option](const std::string & value) {
+				option = std::stoi(value);
+			};
+		};
+
+		const Qonvince::Bench::OptionHandlers handlers = {
+			{"--vault", [&options](const std::string & value) { options.vault = value; }},
+			{"--passphrase", [&options](const std::string & value) { options.passphrase = value; }},
+			{"--output", [&options](const std::string & value) { options.output = value; }},
+			{"--paint-frames", toInt(options.paintFrames)},
+			{"--saves", toInt(options.saves)},
+			{"--searches", toInt(options.searches)},
+			{"--rollovers", toInt(options.rollovers)},
+			{"--virtual-rollovers", toInt(options.virtualRollovers)},
+		};
+
+		if(!Qonvince::Bench::parseOptions(argc, argv, handlers)) {
+			return false;
+		}
+
+		if(options.vault.empty()) {
+			std::cerr << "--vault is required\n";
+			return false;
+		}
+
+		// the real rollovers would be measured against a clock that doesn't move
+		if(0 < options.rollovers && 0 < options.virtualRollovers) {
+			std::cerr << "use --rollovers 0 with --virtual-rollovers\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	// keep processing events (timers, repaints) for a while
+	void runEventLoopFor(qint64 ms)
+	{
+		if(0 >= ms) {
+			return;
+		}
+
+		QEventLoop loop;
+		QTimer::singleShot(static_cast<int>(ms), &loop, &QEventLoop::quit);
+		loop.exec();
+	}
+
+	std::optional<json> unlock(Application & app, const QCA::SecureArray & passphrase)
+	{
+		Qonvince::SettingsUnlocker unlocker;
+		QEventLoop loop;
+		bool passphraseCorrect = false;
+
+		QObject::connect(&unlocker, &Qonvince::SettingsUnlocker::finished, &loop, [&loop, &passphraseCorrect](bool correct) {
+			passphraseCorrect = correct;
+			loop.quit();
+		});
+
+		QElapsedTimer timer;
+		timer.start();
+		unlocker.unlock(passphrase);
+		loop.exec();
+		const auto decryptMs = elapsedMs(timer);
+
+		if(!passphraseCorrect) {
+			return {};
+		}
+
+		app.unlockCodeSettings(passphrase, unlocker.takeSeeds());
+		const auto totalMs = elapsedMs(timer);
+
+		// the icons are read in the background and arrive after the OTPs
+		app.iconStore().waitForPendingWork();
+		QCoreApplication::sendPostedEvents();
+		const auto iconsMs = elapsedMs(timer);
+
+		return json{
+			{"decrypt_ms", decryptMs},
+			{"load_ms", totalMs - decryptMs},
+			{"total_ms", totalMs},
+			{"icons_ms", iconsMs - totalMs},
+		};
+	}
+
+	json measurePaint(int frames)
+	{
+		Qonvince::OtpListView view;
+		view.resize(400, 900);
+		view.show();
+		runEventLoopFor(100);
+		std::vector<double> samples;
+
+		for(int frame = 0; frame < frames; ++frame) {
+			QElapsedTimer timer;
+			timer.start();
+			const auto pixmap = view.grab();
+			samples.push_back(elapsedMs(timer));
+		}
+
+		return Qonvince::Bench::summarise(std::move(samples));
+	}
+
+	json measureSave(Application & app, int saves)
+	{
+		std::vector<double> samples;
+
+		for(int save = 0; save < saves; ++save) {
+			QElapsedTimer timer;
+			timer.start();
+			app.writeSettings();
+			samples.push_back(elapsedMs(timer));
+		}
+
+		return Qonvince::Bench::summarise(std::move(samples));
+	}
+
+	// index every OTP, then type the issuer and name of some of them one character at a time, timing each query
+	json measureSearch(Application & app, int searches)
+	{
+		Qonvince::OtpSearchIndex index;
+		QElapsedTimer timer;
+		timer.start();
+
+		for(int idx = 0; idx < app.otpCount(); ++idx) {
+			index.add(app.otp(idx));
+		}
+
+		const auto buildMs = elapsedMs(timer);
+		std::vector<double> samples;
+		std::size_t matches = 0;
+
+		for(int search = 0; search < searches && 0 < app.otpCount(); ++search) {
+			const auto * otp = app.otp(static_cast<int>((static_cast<qint64>(search) * app.otpCount()) / searches));
+			const auto query = otp->issuer() + QLatin1Char(' ') + otp->name();
+
+			for(int length = 1; length <= query.size(); ++length) {
+				timer.restart();
+				matches += index.search(query.left(length)).size();
+				samples.push_back(elapsedMs(timer));
+			}
+		}
+
+		return {
+			{"build_ms", buildMs},
+			{"mean_matches", samples.empty() ? 0.0 : static_cast<double>(matches) / static_cast<double>(samples.size())},
+			{"keystroke", Qonvince::Bench::summarise(std::move(samples))},
+		};
+	}
+
+	// compare the CPU used in an idle window with the CPU used in a window around the next rollover
+	json measureRollover()
+	{
+		using Qonvince::Bench::processCpuMs;
+
+		const qint64 intervalMs = Otp::DefaultInterval * 1000;
+		auto now = QDateTime::currentMSecsSinceEpoch();
+		auto boundary = (now / intervalMs + 1) * intervalMs;
+
+		// there must be time for the idle window before the rollover window
+		if(boundary - now < RolloverLeadMs + RolloverWindowMs) {
+			boundary += intervalMs;
+		}
+
+		runEventLoopFor(boundary - RolloverLeadMs - RolloverWindowMs - now);
+		auto cpu = processCpuMs();
+		runEventLoopFor(RolloverWindowMs);
+		const auto idleCpuMs = processCpuMs() - cpu;
+
+		cpu = processCpuMs();
+		runEventLoopFor(RolloverWindowMs);
+		const auto rolloverCpuMs = processCpuMs() - cpu;
+
+		return {
+			{"window_ms", RolloverWindowMs},
+			{"idle_cpu_ms", idleCpuMs},
+			{"rollover_cpu_ms", rolloverCpuMs},
+		};
+	}
+
+	// move the clock to each of the next few interval boundaries, timing how long it takes the codes to catch up
+	json measureVirtualRollovers(Qonvince::VirtualClock & clock, int rollovers)
+	{
+		const qint64 intervalMs = Otp::DefaultInterval * 1000;
+		std::vector<double> samples;
+
+		for(int rollover = 0; rollover < rollovers; ++rollover) {
+			const auto boundary = (clock.msecsSinceEpoch() / intervalMs + 1) * intervalMs;
+			QElapsedTimer timer;
+			timer.start();
+			clock.setMSecsSinceEpoch(boundary);
+			samples.push_back(elapsedMs(timer));
+		}
+
+		return Qonvince::Bench::summarise(std::move(samples));
+	}
+}	// namespace
+
+int main(int argc, char * argv[])
+{
+	Options options;
+
+	if(!parseArguments(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+
+	// the application reports progress on stdout, which is reserved for the report
+	Qonvince::Bench::StdoutRedirect stdoutRedirect;
+
+	// before the application object so that the locations are read from the vault
+	Qonvince::Bench::useVault(QString::fromStdString(options.vault));
+
+	// before anything that reads the time, so that the OTPs and views follow it
+	Qonvince::VirtualClock virtualClock(QDateTime::currentMSecsSinceEpoch());
+
+	if(0 < options.virtualRollovers) {
+		Qonvince::Clock::setCurrent(&virtualClock);
+	}
+
+	if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+
+	Qonvince::Bench::ApplicationArguments appArgs(argv[0]);
+
+	QElapsedTimer startupTimer;
+	startupTimer.start();
+	Application app(appArgs.count(), appArgs.values());
+	const auto startupMs = elapsedMs(startupTimer);
+
+	json report = {
+		{"suite", "qonvince_scalebench"},
+		{"version", QONVINCE_BENCH_VERSION},
+		{"build_type", QONVINCE_BENCH_BUILD_TYPE},
+		{"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate).toStdString()},
+		{"startup_ms", startupMs},
+	};
+
+	const auto unlockReport = unlock(app, QCA::SecureArray(QByteArray::fromStdString(options.passphrase)));
+
+	if(!unlockReport) {
+		std::cerr << "the passphrase is not correct for the vault\n";
+		return 1;
+	}
+
+	report["codes"] = app.otpCount();
+	report["unlock"] = *unlockReport;
+	report["peak_rss_after_unlock_kib"] = Qonvince::Bench::peakRssKib();
+	report["paint"] = measurePaint(options.paintFrames);
+	report["save"] = measureSave(app, options.saves);
+	report["search"] = measureSearch(app, options.searches);
+	report["rollovers"] = json::array();
+
+	for(int rollover = 0; rollover < options.rollovers; ++rollover) {
+		report["rollovers"].push_back(measureRollover());
+	}
+
+	if(0 < options.virtualRollovers) {
+		report["virtual_rollovers"] = measureVirtualRollovers(virtualClock, options.virtualRollovers);
+	}
+
+	report["peak_rss_kib"] = Qonvince::Bench::peakRssKib();
+
+	stdoutRedirect.restore();
+	return (Qonvince::Bench::writeReport(report, options.output) ? 0 : 1);
+}
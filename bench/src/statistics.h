@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_BENCH_STATISTICS_H
+#define QONVINCE_BENCH_STATISTICS_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <QElapsedTimer>
+#include <nlohmann/json.hpp>
+
+namespace Qonvince::Bench
+{
+	// the time on a running timer, in ms with sub-ms precision
+	inline double elapsedMs(const QElapsedTimer & timer)
+	{
+		return static_cast<double>(timer.nsecsElapsed()) / 1e6;
+	}
+
+	/**
+	 * The nearest-rank percentile of a set of samples.
+	 *
+	 * @param sortedSamples The samples, in ascending order.
+	 * @param percent The percentile, 0 - 100.
+	 */
+	inline double percentile(const std::vector<double> & sortedSamples, double percent)
+	{
+		if(sortedSamples.empty()) {
+			return 0.0;
+		}
+
+		const auto rank = static_cast<std::size_t>(std::ceil(percent / 100.0 * static_cast<double>(sortedSamples.size())));
+		return sortedSamples[std::clamp<std::size_t>(rank, 1, sortedSamples.size()) - 1];
+	}
+
+	// summarise a set of timings (in ms) for a JSON report
+	inline nlohmann::json summarise(std::vector<double> samples)
+	{
+		std::sort(samples.begin(), samples.end());
+
+		return {
+			{"samples", samples.size()},
+			{"p50_ms", percentile(samples, 50)},
+			{"p95_ms", percentile(samples, 95)},
+			{"p99_ms", percentile(samples, 99)},
+			{"max_ms", samples.empty() ? 0.0 : samples.back()},
+		};
+	}
+}	// namespace Qonvince::Bench
+
+#endif  // QONVINCE_BENCH_STATISTICS_H
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file vault.cpp
+ * @brief Helpers shared by the benchmark tools that work with vaults.
+ */
+
+#include "vault.h"
+
+#include <ctime>
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+
+#if defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace Qonvince::Bench
+{
+	void useVault(const QString & directory)
+	{
+		const auto root = QDir(directory).absolutePath();
+		qputenv("XDG_CONFIG_HOME", QFile::encodeName(root + QStringLiteral("/config")));
+		qputenv("XDG_DATA_HOME", QFile::encodeName(root + QStringLiteral("/data")));
+		QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, root + QStringLiteral("/config"));
+	}
+
+	QString displayPluginName(std::mt19937_64 & rng)
+	{
+		const auto choice = std::uniform_int_distribution<int>(0, 9)(rng);
+
+		if(8 > choice) {
+			return QStringLiteral("SixDigitsPlugin");
+		}
+
+		if(8 == choice) {
+			return QStringLiteral("EightDigitsPlugin");
+		}
+
+		return QStringLiteral("SteamOtpDisplayPlugin");
+	}
+
+	long peakRssKib()
+	{
+#if defined(Q_OS_UNIX)
+		rusage usage{};
+
+		if(0 != getrusage(RUSAGE_SELF, &usage)) {
+			return -1;
+		}
+
+#if defined(Q_OS_MACOS)
+		// macOS reports bytes rather than KiB
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+#else
+		return -1;
+#endif
+	}
+
+	double processCpuMs()
+	{
+		return static_cast<double>(std::clock()) * 1000.0 / CLOCKS_PER_SEC;
+	}
+}	// namespace Qonvince::Bench
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_BENCH_VAULT_H
+#define QONVINCE_BENCH_VAULT_H
+
+#include <random>
+#include <QString>
+
+namespace Qonvince::Bench
+{
+	/**
+	 * Point the settings and data locations at a benchmark vault directory instead of the user's real ones.
+	 *
+	 * This must be called before the application object is created. The settings go in "config" and the icons in
+	 * "data" under the vault directory. The data location is redirected with XDG_DATA_HOME so icons are only
+	 * separated from the user's on platforms that follow the XDG base directory specification.
+	 */
+	void useVault(const QString & directory);
+
+	// pick a display plugin for a generated OTP. mostly six digits, as in real vaults
+	QString displayPluginName(std::mt19937_64 & rng);
+
+	// the peak resident set size of the process in KiB, or -1 if it is not available on this platform
+	long peakRssKib();
+
+	// the CPU time used by the process so far
+	double processCpuMs();
+}	// namespace Qonvince::Bench
+
+#endif  // QONVINCE_BENCH_VAULT_H
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file vaultgenerator.cpp
+ * @brief Generates encrypted settings files ("vaults") with any number of OTPs for the scale benchmark.
+ *
+ * The OTPs are derived from a seed for the random number generator so the same arguments always produce the same
+ * names, seeds, types and icons. The encrypted data differs between runs because each encryption uses a random IV.
+ */
+
+#include <iostream>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include <QCoreApplication>
+#include <QColor>
+#include <QImage>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtCrypto>
+
+#include "application.h"
+#include "iconstore.h"
+#include "otp.h"
+#include "base32.h"
+#include "commandline.h"
+#include "vault.h"
+
+using Qonvince::Application;
+using Qonvince::IconStore;
+using Qonvince::Otp;
+
+namespace
+{
+	constexpr const int SeedSize = 20;
+	constexpr const int IconSize = IconStore::RenditionExtents.back();
+	constexpr const int IssuerCount = 100;
+
+	struct Options
+	{
+		QString vault;
+		int count = 0;
+		QString passphrase = QStringLiteral("qonvince-benchmark");
+		std::uint64_t seed = 1;
+		int hotpPercent = 20;
+		int icons = 32;
+	};
+
+	void printUsage()
+	{
+		std::cerr << "usage: qonvince_vaultgen --vault <dir> --count <n> [--passphrase <passphrase>] [--seed <n>] [--hotp-percent <n>] [--icons <n>]\n\n"
+					 << "Writes a settings file with <n> OTPs under <dir>, sharing the number of icons given by --icons (32 by default) between\n"
+					 << "them. Any existing settings in <dir> are replaced. The passphrase defaults to \"qonvince-benchmark\".\n";
+	}
+
+	bool parseArguments(int argc, char ** argv, Options & options)
+	{
+		const auto toQString = [](QString & option) {
+			return [&option](const std::string & value) {
+				option = QString::fromLocal8Bit(value.c_str());
+			};
+		};
+
+		const auto toInt = [](int & option) {
+			return [&option](const std::string & value) {
+				option = std::stoi(value);
+			};
+		};
+
+		const Qonvince::Bench::OptionHandlers handlers = {
+			{"--vault", toQString(options.vault)},
+			{"--count", toInt(options.count)},
+			{"--passphrase", toQString(options.passphrase)},
+			{"--seed", [&options](const std::string & value) { options.seed = std::stoull(value); }},
+			{"--hotp-percent", toInt(options.hotpPercent)},
+			{"--icons", toInt(options.icons)},
+		};
+
+		if(!Qonvince::Bench::parseOptions(argc, argv, handlers)) {
+			return false;
+		}
+
+		if(options.vault.isEmpty() || 0 >= options.count) {
+			std::cerr << "--vault and --count are required\n";
+			return false;
+		}
+
+		if(0 > options.hotpPercent || 100 < options.hotpPercent || 0 > options.icons) {
+			std::cerr << "--hotp-percent must be 0 - 100 and --icons must not be negative\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	// the keys the icons are stored under, in the same way as IconStore::add()
+	std::optional<std::vector<QString>> writeIcons(int count)
+	{
+		std::vector<QString> keys;
+		keys.reserve(static_cast<std::size_t>(count));
+
+		for(int idx = 0; idx < count; ++idx) {
+			// a distinct colour for each icon, split diagonally so that the icons aren't trivially compressible
+			const auto colour = QColor::fromHsv((idx * 37) % 360, 200, 220);
+			const auto background = colour.lighter(150);
+			QImage icon(IconSize, IconSize, QImage::Format_ARGB32);
+
+			for(int y = 0; y < IconSize; ++y) {
+				for(int x = 0; x < IconSize; ++x) {
+					icon.setPixel(x, y, (x > y ? colour : background).rgba());
+				}
+			}
+
+			const auto & key = keys.emplace_back(IconStore::keyFor(icon));
+
+			if(!IconStore::writeRenditions(key, icon)) {
+				std::cerr << "failed to write icon " << idx << "\n";
+				return {};
+			}
+		}
+
+		return keys;
+	}
+
+	QByteArray randomSeed(std::mt19937_64 & rng)
+	{
+		std::uniform_int_distribution<int> byte(0, 255);
+		QByteArray plain(SeedSize, '\0');
+
+		for(auto & ch : plain) {
+			ch = static_cast<char>(byte(rng));
+		}
+
+		QByteArray encoded(static_cast<int>(LibQonvince::Base32Codec::encodedSize(SeedSize)), '\0');
+		LibQonvince::Base32Codec::encode(std::span<const char>(plain.constData(), SeedSize), std::span<char>(encoded.data(), static_cast<std::size_t>(encoded.size())));
+		return encoded;
+	}
+}	// namespace
+
+int main(int argc, char * argv[])
+{
+	Options options;
+
+	if(!parseArguments(argc, argv, options)) {
+		printUsage();
+		return 1;
+	}
+
+	// before the application object so that the locations are read from the vault
+	Qonvince::Bench::useVault(options.vault);
+	QCoreApplication app(argc, argv);
+	Application::setApplicationIdentity();
+	QCA::Initializer qcaInitializer;
+
+	if(!QCA::isSupported("aes256-cbc")) {
+		std::cerr << "AES256 encryption is not available\n";
+		return 1;
+	}
+
+	const QCA::SecureArray passphrase(options.passphrase.toUtf8());
+
+	if(!Application::isValidPassphrase(passphrase)) {
+		std::cerr << "the passphrase is too short\n";
+		return 1;
+	}
+
+	const auto iconKeys = writeIcons(options.icons);
+
+	if(!iconKeys) {
+		return 1;
+	}
+
+	std::mt19937_64 rng(options.seed);
+	QSettings settings;
+	settings.clear();
+	Application::writeCryptCheck(settings, passphrase);
+
+	settings.beginGroup(QStringLiteral("codes"));
+	settings.setValue(QStringLiteral("code_count"), options.count);
+
+	// the same keys as Otp::writeSettings()
+	for(int idx = 0; idx < options.count; ++idx) {
+		const auto encryptedSeed = Otp::encryptSeed(randomSeed(rng), passphrase);
+
+		if(!encryptedSeed) {
+			std::cerr << "failed to encrypt the seed for OTP " << idx << "\n";
+			return 1;
+		}
+
+		settings.beginGroup(QStringLiteral("code-%1").arg(idx));
+		settings.setValue(QStringLiteral("name"), QStringLiteral("user%1@example.com").arg(idx));
+		settings.setValue(QStringLiteral("issuer"), QStringLiteral("Issuer %1").arg(idx % IssuerCount));
+
+		if(0 < options.icons) {
+			settings.setValue(QStringLiteral("icon"), (*iconKeys)[static_cast<std::size_t>(idx % options.icons)]);
+		}
+
+		settings.setValue(QStringLiteral("pluginName"), Qonvince::Bench::displayPluginName(rng));
+		settings.setValue(QStringLiteral("seed"), *encryptedSeed);
+
+		if(std::uniform_int_distribution<int>(0, 99)(rng) < options.hotpPercent) {
+			settings.setValue(QStringLiteral("type"), QStringLiteral("HOTP"));
+			settings.setValue(QStringLiteral("counter"), std::uniform_int_distribution<int>(0, 1000)(rng));
+		}
+		else {
+			settings.setValue(QStringLiteral("type"), QStringLiteral("TOTP"));
+			settings.setValue(QStringLiteral("interval"), 0 == std::uniform_int_distribution<int>(0, 9)(rng) ? 60 : Otp::DefaultInterval);
+			settings.setValue(QStringLiteral("baseline_time"), 0);
+		}
+
+		settings.setValue(QStringLiteral("revealOnDemand"), false);
+		settings.endGroup();
+	}
+
+	settings.endGroup();
+	settings.sync();
+
+	if(QSettings::NoError != settings.status()) {
+		std::cerr << "failed to write the settings file \"" << qPrintable(settings.fileName()) << "\"\n";
+		return 1;
+	}
+
+	std::cerr << "wrote " << options.count << " OTPs to \"" << qPrintable(settings.fileName()) << "\"\n";
+	return 0;
+}
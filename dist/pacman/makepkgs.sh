@@ -55,31 +55,3 @@ fi
 
 cp *.pkg.tar.xz "${BASEDIR}"/
 
-echo Building package qonvince-displayplugins ${PKG_VERSION}-${PKG_RELEASE} ...
-cd "${BASEDIR}"/qonvince-displayplugins
-strip pkg/usr/share/Equit/Qonvince/plugins/otpdisplay/*.displayplugin
-. "${BASEDIR}"/makepkg.sh --pkg-version $PKG_VERSION --pkg-release $PKG_RELEASE --pkg-depends "libqonvince-git qt5-base" --pkg-makedepends "cmake qt5-tools"
-
-if [ 0 -eq $? ]; then
-    echo "OK"
-else
-    echo "failed"
-	exit 1
-fi
-
-cp *.pkg.tar.xz "${BASEDIR}"/
-
-echo Building package qonvince-displayplugins-extra ${PKG_VERSION}-${PKG_RELEASE} ...
-cd "${BASEDIR}"/qonvince-displayplugins-extra
-strip pkg/usr/share/Equit/Qonvince/plugins/otpdisplay/*.displayplugin
-. "${BASEDIR}"/makepkg.sh --pkg-version $PKG_VERSION --pkg-release $PKG_RELEASE --pkg-depends "libqonvince-git qt5-base" --pkg-makedepends "cmake qt5-tools"
-
-if [ 0 -eq $? ]; then
-    echo "OK"
-else
-    echo "failed"
-	exit 1
-fi
-
-cp *.pkg.tar.xz "${BASEDIR}"/
-
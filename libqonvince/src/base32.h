@@ -19,7 +19,7 @@
 
 /**
  * @file base32.h
- * @brief Declaration of the Base32 class template.
+ * @brief Declaration of the Base32 codec functions and the Base32 class template.
  */
 
 #ifndef LIBQONVINCE_BASE32_H
@@ -27,11 +27,637 @@
 
 #include <array>
 #include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include <span>
 #include "securestring.h"
 
 namespace LibQonvince
 {
+    namespace Base32Codec
+    {
+        /**
+         * How leniently Base32 data is interpreted when it is decoded.
+         *
+         * Seeds that are typed, pasted or imported are often not strictly valid RFC 4648 Base32. The policy is applied as
+         * part of the decoding pass, so no normalised copy of the data is made.
+         */
+        enum class Normalise : unsigned int
+        {
+            None = 0x00,
+
+            /** Accept lower case letters. */
+            CaseFold = 0x01,
+
+            /** Ignore spaces, tabs, line breaks and dashes anywhere in the data. */
+            StripSeparators = 0x02,
+
+            /** Accept data that does not have the padding required to make it a multiple of 8 characters. */
+            AllowMissingPadding = 0x04,
+
+            /** Use the RFC 4648 "base32hex" alphabet (0-9, A-V) rather than the standard alphabet. */
+            Base32Hex = 0x08,
+
+            /** What the Base32 class has always accepted. */
+            Default = AllowMissingPadding,
+
+            /** Suitable for seeds entered by users or found in otpauth:// URIs. */
+            Lenient = CaseFold | StripSeparators | AllowMissingPadding,
+        };
+
+        constexpr Normalise operator|(Normalise lhs, Normalise rhs) noexcept
+        {
+            return static_cast<Normalise>(static_cast<unsigned int>(lhs) | static_cast<unsigned int>(rhs));
+        }
+
+        constexpr bool operator&(Normalise lhs, Normalise rhs) noexcept
+        {
+            return 0 != (static_cast<unsigned int>(lhs) & static_cast<unsigned int>(rhs));
+        }
+    }  // namespace Base32Codec
+
+    namespace Detail
+    {
+        using Base32Codec::Normalise;
+
+        /** The Base32 alphabet, indexed by 5-bit value. */
+        static constexpr const std::array<char, 32> Base32Dictionary = {{'A', 'B', 'C', 'D', 'E', 'F',
+                                                                         'G', 'H', 'I', 'J', 'K', 'L',
+                                                                         'M', 'N', 'O', 'P', 'Q', 'R',
+                                                                         'S', 'T', 'U', 'V', 'W', 'X',
+                                                                         'Y', 'Z', '2', '3', '4', '5',
+                                                                         '6', '7'}};
+
+        /** Marker in the reverse lookup tables for bytes that are not in the Base32 alphabet. */
+        static constexpr const std::uint8_t Base32InvalidCharacter = 0xff;
+
+        /** Marker in the reverse lookup tables for separators that are skipped. */
+        static constexpr const std::uint8_t Base32SkipCharacter = 0xfe;
+
+        /** Reverse lookup table mapping each possible byte to its 5-bit Base32 value. */
+        struct Base32DecodeTableT
+        {
+            std::uint8_t values[256];
+        };
+
+        /**
+         * Build the reverse lookup table for a normalisation policy.
+         *
+         * Only the CaseFold, StripSeparators and Base32Hex flags affect the table.
+         */
+        constexpr Base32DecodeTableT makeBase32DecodeTable(Normalise normalise)
+        {
+            Base32DecodeTableT table = {};
+
+            for(auto & value : table.values) {
+                value = Base32InvalidCharacter;
+            }
+
+            const auto setLetters = [&table, normalise](char first, std::uint8_t count, std::uint8_t firstValue) {
+                for(std::uint8_t idx = 0; idx < count; ++idx) {
+                    table.values[first + idx] = static_cast<std::uint8_t>(firstValue + idx);
+
+                    if(normalise & Normalise::CaseFold) {
+                        table.values[first + ('a' - 'A') + idx] = static_cast<std::uint8_t>(firstValue + idx);
+                    }
+                }
+            };
+
+            if(normalise & Normalise::Base32Hex) {
+                for(std::uint8_t idx = 0; idx < 10; ++idx) {
+                    table.values['0' + idx] = idx;
+                }
+
+                setLetters('A', 22, 10);
+            } else {
+                setLetters('A', 26, 0);
+
+                for(std::uint8_t idx = 0; idx < 6; ++idx) {
+                    table.values['2' + idx] = static_cast<std::uint8_t>(26 + idx);
+                }
+            }
+
+            if(normalise & Normalise::StripSeparators) {
+                for(const auto separator : {' ', '\t', '\r', '\n', '-'}) {
+                    table.values[static_cast<unsigned char>(separator)] = Base32SkipCharacter;
+                }
+            }
+
+            return table;
+        }
+
+        /** The tables for every combination of the flags that affect the table. */
+        static constexpr const std::array<Base32DecodeTableT, 8> Base32DecodeTables = {{
+            makeBase32DecodeTable(Normalise::None),
+            makeBase32DecodeTable(Normalise::CaseFold),
+            makeBase32DecodeTable(Normalise::StripSeparators),
+            makeBase32DecodeTable(Normalise::CaseFold | Normalise::StripSeparators),
+            makeBase32DecodeTable(Normalise::Base32Hex),
+            makeBase32DecodeTable(Normalise::Base32Hex | Normalise::CaseFold),
+            makeBase32DecodeTable(Normalise::Base32Hex | Normalise::StripSeparators),
+            makeBase32DecodeTable(Normalise::Base32Hex | Normalise::CaseFold | Normalise::StripSeparators),
+        }};
+
+        constexpr const Base32DecodeTableT & base32DecodeTable(Normalise normalise) noexcept
+        {
+            return Base32DecodeTables[(normalise & Normalise::CaseFold ? 1u : 0u) | (normalise & Normalise::StripSeparators ? 2u : 0u) | (normalise & Normalise::Base32Hex ? 4u : 0u)];
+        }
+
+        template<typename ByteT>
+        constexpr std::uint8_t base32Value(const Base32DecodeTableT & table, ByteT ch) noexcept
+        {
+            static_assert(1 == sizeof(ByteT), "Base32 data must be byte-sized");
+            return table.values[static_cast<unsigned char>(ch)];
+        }
+
+        /** Whether a number of Base32 data characters (excluding padding) is a valid length. */
+        constexpr bool isValidBase32Length(std::size_t characterCount) noexcept
+        {
+            // a final group can only encode 1, 2, 3 or 4 bytes
+            const auto tail = characterCount % 8;
+            return 1 != tail && 3 != tail && 6 != tail;
+        }
+
+        /** Number of characters required for the final 0-4 bytes of plain data. */
+        static constexpr const std::array<std::size_t, 5> Base32TailCharacterCount = {{0, 2, 4, 5, 7}};
+
+        template<typename ByteT>
+        constexpr ByteT base32Character(std::uint64_t bits, unsigned int shift) noexcept
+        {
+            return static_cast<ByteT>(Base32Dictionary[(bits >> shift) & 0x1fu]);
+        }
+
+        // bytes must be widened as unsigned, otherwise bytes >= 0x80 sign-extend over the rest of the group
+        template<typename ByteT>
+        constexpr std::uint64_t plainByte(ByteT byte) noexcept
+        {
+            static_assert(1 == sizeof(ByteT), "Base32 data must be byte-sized");
+            return static_cast<unsigned char>(byte);
+        }
+    }  // namespace Detail
+
+    /**
+     * Base32 encoding and decoding of caller-provided buffers.
+     *
+     * The functions never allocate: output is written directly into the buffer provided, which must be at least the size
+     * given by encodedSize() or decodedSize(). This means secret data can be decoded straight into secure storage.
+     *
+     * Encoder and Decoder do the same for data that arrives in chunks.
+     */
+    namespace Base32Codec
+    {
+        /**
+         * The exact number of characters required to encode some plain data, including padding.
+         */
+        constexpr std::size_t encodedSize(std::size_t plainSize) noexcept
+        {
+            return ((plainSize + 4) / 5) * 8;
+        }
+
+        /**
+         * The maximum number of bytes that some Base32 data can decode to.
+         *
+         * This is exact when the encoded data is unpadded; use decodedSize() to take padding into account.
+         */
+        constexpr std::size_t maxDecodedSize(std::size_t encodedSize) noexcept
+        {
+            return encodedSize * 5 / 8;
+        }
+
+        /**
+         * The exact number of bytes that some Base32 data decodes to.
+         *
+         * Only the length and padding are examined (and, if separators are being stripped, which characters are
+         * separators), so a valid size does not mean the data is valid.
+         *
+         * @return The size, or an empty optional if the data is not a valid length.
+         */
+        template<typename ByteT, std::size_t Extent>
+        constexpr std::optional<std::size_t> decodedSize(std::span<ByteT, Extent> encoded, Normalise normalise = Normalise::Default) noexcept
+        {
+            std::size_t characterCount = 0;
+            std::size_t paddingCount = 0;
+
+            if(normalise & Normalise::StripSeparators) {
+                const auto & table = Detail::base32DecodeTable(normalise);
+
+                for(const auto ch : encoded) {
+                    if('=' == ch) {
+                        ++paddingCount;
+                    } else if(Detail::Base32SkipCharacter != Detail::base32Value(table, ch)) {
+                        ++characterCount;
+                    }
+                }
+            } else {
+                characterCount = encoded.size();
+
+                while(0 < characterCount && '=' == encoded[characterCount - 1]) {
+                    --characterCount;
+                    ++paddingCount;
+                }
+            }
+
+            if(!Detail::isValidBase32Length(characterCount)) {
+                return {};
+            }
+
+            if(!(normalise & Normalise::AllowMissingPadding) && 0 != (characterCount + paddingCount) % 8) {
+                return {};
+            }
+
+            return maxDecodedSize(characterCount);
+        }
+
+        /**
+         * Encode some plain data.
+         *
+         * @param plain The data to encode.
+         * @param out The buffer to receive the encoded data. It must be at least encodedSize(plain.size()) long.
+         *
+         * @return The number of characters written, or an empty optional if the output buffer is too small.
+         */
+        template<typename InByteT, std::size_t InExtent, typename OutByteT, std::size_t OutExtent>
+        std::optional<std::size_t> encode(std::span<InByteT, InExtent> plain, std::span<OutByteT, OutExtent> out) noexcept
+        {
+            static_assert(1 == sizeof(OutByteT), "Base32 data must be byte-sized");
+            const auto len = plain.size();
+            const auto size = encodedSize(len);
+
+            if(out.size() < size) {
+                return {};
+            }
+
+            const auto remainder = len % 5;
+            auto outIt = out.begin();
+            std::size_t pos = 0;
+
+            for(const auto groupsEnd = len - remainder; pos < groupsEnd; pos += 5) {
+                const std::uint64_t bits = (Detail::plainByte(plain[pos]) << 32u) | (Detail::plainByte(plain[pos + 1]) << 24u) |
+                                           (Detail::plainByte(plain[pos + 2]) << 16u) | (Detail::plainByte(plain[pos + 3]) << 8u) |
+                                           Detail::plainByte(plain[pos + 4]);
+
+                for(int shift = 35; 0 <= shift; shift -= 5) {
+                    *outIt++ = Detail::base32Character<std::remove_cv_t<OutByteT>>(bits, static_cast<unsigned int>(shift));
+                }
+            }
+
+            if(0 < remainder) {
+                std::uint64_t bits = 0;
+
+                for(std::size_t idx = 0; idx < 5; ++idx) {
+                    bits = (bits << 8u) | (pos + idx < len ? Detail::plainByte(plain[pos + idx]) : 0u);
+                }
+
+                unsigned int shift = 35;
+
+                for(std::size_t idx = 0; idx < Detail::Base32TailCharacterCount[remainder]; ++idx, shift -= 5) {
+                    *outIt++ = Detail::base32Character<std::remove_cv_t<OutByteT>>(bits, shift);
+                }
+
+                std::fill(outIt, out.begin() + static_cast<std::ptrdiff_t>(size), '=');
+            }
+
+            return size;
+        }
+
+        /**
+         * Decode some Base32 data.
+         *
+         * Every character is validated as it is decoded, and the normalisation policy is applied in the same pass.
+         *
+         * @param encoded The Base32 data to decode.
+         * @param out The buffer to receive the plain data. It must be at least decodedSize(encoded, normalise) long.
+         * @param normalise How leniently to interpret the data.
+         *
+         * @return The number of bytes written, or an empty optional if the data is not valid Base32 or the output buffer is
+         * too small. The content of the output buffer is undefined if decoding fails.
+         */
+        template<typename InByteT, std::size_t InExtent, typename OutByteT, std::size_t OutExtent>
+        std::optional<std::size_t> decode(std::span<InByteT, InExtent> encoded, std::span<OutByteT, OutExtent> out, Normalise normalise = Normalise::Default) noexcept
+        {
+            static_assert(1 == sizeof(OutByteT), "Base32 data must be byte-sized");
+            using OutT = std::remove_cv_t<OutByteT>;
+            const auto size = decodedSize(encoded, normalise);
+
+            if(!size || out.size() < *size) {
+                return {};
+            }
+
+            const auto & table = Detail::base32DecodeTable(normalise);
+            auto outIt = out.begin();
+            std::uint64_t bits = 0;
+            unsigned int bitCount = 0;
+
+            if(normalise & Normalise::StripSeparators) {
+                // separators can be anywhere, so characters are taken one at a time
+                bool padded = false;
+
+                for(const auto ch : encoded) {
+                    if('=' == ch) {
+                        padded = true;
+                        continue;
+                    }
+
+                    const auto value = Detail::base32Value(table, ch);
+
+                    if(Detail::Base32SkipCharacter == value) {
+                        continue;
+                    }
+
+                    if(padded || Detail::Base32InvalidCharacter == value) {
+                        return {};
+                    }
+
+                    bits = (bits << 5u) | value;
+                    bitCount += 5;
+
+                    if(8 <= bitCount) {
+                        bitCount -= 8;
+                        *outIt++ = static_cast<OutT>((bits >> bitCount) & 0xffu);
+                    }
+                }
+
+                return size;
+            }
+
+            auto len = encoded.size();
+
+            while(0 < len && '=' == encoded[len - 1]) {
+                --len;
+            }
+
+            std::size_t pos = 0;
+
+            // complete groups are decoded 40 bits at a time
+            for(const auto groupsEnd = len - (len % 8); pos < groupsEnd; pos += 8) {
+                bits = 0;
+
+                for(std::size_t idx = pos; idx < pos + 8; ++idx) {
+                    const auto value = Detail::base32Value(table, encoded[idx]);
+
+                    if(Detail::Base32InvalidCharacter == value) {
+                        return {};
+                    }
+
+                    bits = (bits << 5u) | value;
+                }
+
+                *outIt++ = static_cast<OutT>((bits >> 32u) & 0xffu);
+                *outIt++ = static_cast<OutT>((bits >> 24u) & 0xffu);
+                *outIt++ = static_cast<OutT>((bits >> 16u) & 0xffu);
+                *outIt++ = static_cast<OutT>((bits >> 8u) & 0xffu);
+                *outIt++ = static_cast<OutT>(bits & 0xffu);
+            }
+
+            bits = 0;
+
+            for(; pos < len; ++pos) {
+                const auto value = Detail::base32Value(table, encoded[pos]);
+
+                if(Detail::Base32InvalidCharacter == value) {
+                    return {};
+                }
+
+                bits = (bits << 5u) | value;
+                bitCount += 5;
+
+                if(8 <= bitCount) {
+                    bitCount -= 8;
+                    *outIt++ = static_cast<OutT>((bits >> bitCount) & 0xffu);
+                }
+            }
+
+            return size;
+        }
+
+        /**
+         * Incremental Base32 encoder for plain data that arrives in chunks.
+         *
+         * Call update() with each chunk and finish() once all the data has been provided. The output is identical to
+         * calling encode() with all the data at once. At most 4 bytes of plain data are held between calls.
+         */
+        class Encoder final
+        {
+        public:
+            /**
+             * The maximum number of characters update() can write for a chunk of plain data.
+             */
+            static constexpr std::size_t maxUpdateSize(std::size_t chunkSize) noexcept
+            {
+                return ((chunkSize + 4) / 5) * 8;
+            }
+
+            /** The maximum number of characters finish() can write. */
+            static constexpr const std::size_t MaxFinishSize = 8;
+
+            Encoder() noexcept = default;
+            Encoder(const Encoder &) = delete;
+            Encoder(Encoder &&) = delete;
+            void operator=(const Encoder &) = delete;
+            void operator=(Encoder &&) = delete;
+
+            ~Encoder()
+            {
+                reset();
+            }
+
+            /**
+             * Encode the next chunk of plain data.
+             *
+             * @return The number of characters written, or an empty optional if the output buffer is smaller than
+             * maxUpdateSize(chunk.size()). Nothing is consumed if the output buffer is too small.
+             */
+            template<typename InByteT, std::size_t InExtent, typename OutByteT, std::size_t OutExtent>
+            std::optional<std::size_t> update(std::span<InByteT, InExtent> chunk, std::span<OutByteT, OutExtent> out) noexcept
+            {
+                if(out.size() < maxUpdateSize(chunk.size())) {
+                    return {};
+                }
+
+                std::size_t written = 0;
+
+                // complete any group left over from the previous chunk
+                if(0 < m_pendingCount) {
+                    const auto count = std::min(chunk.size(), m_pending.size() - m_pendingCount);
+                    std::copy_n(chunk.begin(), count, m_pending.begin() + static_cast<std::ptrdiff_t>(m_pendingCount));
+                    m_pendingCount += count;
+                    chunk = chunk.subspan(count);
+
+                    if(m_pending.size() > m_pendingCount) {
+                        return written;
+                    }
+
+                    written += *encode(std::span<const std::uint8_t>(m_pending), out);
+                    m_pendingCount = 0;
+                }
+
+                const auto whole = chunk.size() - (chunk.size() % 5);
+                written += *encode(chunk.first(whole), out.subspan(written));
+                m_pendingCount = chunk.size() - whole;
+                std::copy(chunk.begin() + static_cast<std::ptrdiff_t>(whole), chunk.end(), m_pending.begin());
+                return written;
+            }
+
+            /**
+             * Encode any remaining plain data, with padding.
+             *
+             * The encoder is ready for new data afterwards.
+             *
+             * @return The number of characters written, or an empty optional if the output buffer is smaller than
+             * MaxFinishSize.
+             */
+            template<typename OutByteT, std::size_t OutExtent>
+            std::optional<std::size_t> finish(std::span<OutByteT, OutExtent> out) noexcept
+            {
+                if(out.size() < MaxFinishSize) {
+                    return {};
+                }
+
+                const auto written = *encode(std::span<const std::uint8_t>(m_pending.data(), m_pendingCount), out);
+                reset();
+                return written;
+            }
+
+            /**
+             * Discard any pending plain data.
+             */
+            void reset() noexcept
+            {
+                // the pending bytes may be secret
+                std::fill(m_pending.begin(), m_pending.end(), 0);
+                m_pendingCount = 0;
+            }
+
+        private:
+            std::array<std::uint8_t, 5> m_pending = {};
+            std::size_t m_pendingCount = 0;
+        };
+
+        /**
+         * Incremental Base32 decoder for encoded data that arrives in chunks.
+         *
+         * Call update() with each chunk and finish() once all the data has been provided. Padding, if present, must come
+         * at the end of the data. The normalisation policy is applied as each chunk is decoded. At most 7 bits of plain
+         * data are held between calls.
+         */
+        class Decoder final
+        {
+        public:
+            /**
+             * The maximum number of bytes update() can write for a chunk of encoded data.
+             */
+            static constexpr std::size_t maxUpdateSize(std::size_t chunkSize) noexcept
+            {
+                return (chunkSize * 5 + 7) / 8;
+            }
+
+            explicit Decoder(Normalise normalise = Normalise::Default) noexcept
+            : m_normalise(normalise),
+              m_table(&Detail::base32DecodeTable(normalise))
+            {
+            }
+
+            Decoder(const Decoder &) = delete;
+            Decoder(Decoder &&) = delete;
+            void operator=(const Decoder &) = delete;
+            void operator=(Decoder &&) = delete;
+
+            ~Decoder()
+            {
+                reset();
+            }
+
+            /**
+             * Decode the next chunk of Base32 data.
+             *
+             * @return The number of bytes written, or an empty optional if the chunk contains invalid data or the output
+             * buffer is smaller than maxUpdateSize(chunk.size()). The decoder must be reset after invalid data.
+             */
+            template<typename InByteT, std::size_t InExtent, typename OutByteT, std::size_t OutExtent>
+            std::optional<std::size_t> update(std::span<InByteT, InExtent> chunk, std::span<OutByteT, OutExtent> out) noexcept
+            {
+                static_assert(1 == sizeof(OutByteT), "Base32 data must be byte-sized");
+
+                if(out.size() < maxUpdateSize(chunk.size())) {
+                    return {};
+                }
+
+                auto outIt = out.begin();
+
+                for(const auto ch : chunk) {
+                    if('=' == ch) {
+                        m_padded = true;
+                        ++m_paddingCount;
+                        continue;
+                    }
+
+                    const auto value = Detail::base32Value(*m_table, ch);
+
+                    if(Detail::Base32SkipCharacter == value) {
+                        continue;
+                    }
+
+                    if(m_padded || Detail::Base32InvalidCharacter == value) {
+                        return {};
+                    }
+
+                    m_bits = (m_bits << 5u) | value;
+                    m_bitCount += 5;
+                    ++m_characterCount;
+
+                    if(8 <= m_bitCount) {
+                        m_bitCount -= 8;
+                        *outIt++ = static_cast<std::remove_cv_t<OutByteT>>((m_bits >> m_bitCount) & 0xffu);
+                    }
+                }
+
+                return static_cast<std::size_t>(outIt - out.begin());
+            }
+
+            /**
+             * Check that the data decoded was a valid length.
+             *
+             * The decoder is ready for new data afterwards.
+             *
+             * @return true if the data decoded was complete (and correctly padded, if the normalisation policy requires
+             * it), false otherwise.
+             */
+            bool finish() noexcept
+            {
+                auto valid = Detail::isValidBase32Length(m_characterCount);
+
+                if(!(m_normalise & Normalise::AllowMissingPadding) && 0 != (m_characterCount + m_paddingCount) % 8) {
+                    valid = false;
+                }
+
+                reset();
+                return valid;
+            }
+
+            /**
+             * Discard any pending data.
+             */
+            void reset() noexcept
+            {
+                m_bits = 0;
+                m_bitCount = 0;
+                m_characterCount = 0;
+                m_paddingCount = 0;
+                m_padded = false;
+            }
+
+        private:
+            Normalise m_normalise;
+            const Detail::Base32DecodeTableT * m_table;
+            std::uint64_t m_bits = 0;
+            unsigned int m_bitCount = 0;
+            std::size_t m_characterCount = 0;
+            std::size_t m_paddingCount = 0;
+            bool m_padded = false;
+        };
+    }  // namespace Base32Codec
+
     /**
      * Codec class for Base32 data.
      *
@@ -40,7 +666,8 @@ namespace LibQonvince
      * using plain() and encoded() respectively. Use isValid() to check whether the encoded data is valid when setEncoded() has been used
      * with data that you can't guarantee is known to be valid Base32.
      *
-     * Encoding/decoding is only performed when required, so the class is relatively lightweight.
+     * Encoded content is decoded as soon as it is set and only the plain data is kept. The encoded form is only generated
+     * when it is requested. Use the Base32Codec functions directly to avoid the internal copies altogether.
      *
      * @tparam ByteArrayT Type of strings of bytes that are encoded/decoded.
      * @tparam ByteT Type of bytes that are encoded/decoded. It must be possible to implicitly cast between the
@@ -60,7 +687,6 @@ namespace LibQonvince
          */
         explicit Base32(const ByteArrayT & plainData = {})
         : m_isValid(true),
-          m_plainInSync(true),
           m_encodedInSync(false),
           m_plain(plainData) {}
 
@@ -84,8 +710,7 @@ namespace LibQonvince
         bool setPlain(const ByteArrayT & data)
         {
             m_plain = data;
-            m_plainInSync = true;
-            m_encodedInSync = false;
+            clearEncoded();
             m_isValid = true;
             return true;
         }
@@ -93,39 +718,39 @@ namespace LibQonvince
         /**
          * Set the Base32 encoded content.
          *
-         * If the provided content is not valid Base32, the state of the object is undefined.
+         * The content is validated, normalised and decoded in a single pass. If the provided content is not valid Base32
+         * the object is invalid until new content is set.
          *
          * @param base32 The Base32 content to decode.
+         * @param normalise How leniently to interpret the content. By default, only trailing padding is optional.
          *
          * @return true if the content was valid Base32, false otherwise.
          */
-        bool setEncoded(const ByteArrayT & base32)
+        bool setEncoded(const ByteArrayT & base32, Base32Codec::Normalise normalise = Base32Codec::Normalise::Default)
         {
-            bool stillTrimmingTrailingEquals = true;
+            const auto in = std::span<const ByteT>(base32.data(), static_cast<std::size_t>(base32.size()));
+            const auto size = Base32Codec::decodedSize(in, normalise);
 
-            for(auto i = static_cast<int>(base32.size()) - 1; 0 <= i; --i) {
-                auto idx = i;
-                unsigned char ch = base32.at(idx);
+            // decoded into a new buffer because base32 might be the cached encoded content
+            ByteArrayT plain;
 
-                if(stillTrimmingTrailingEquals) {
-                    if('=' == ch) {
-                        continue;
-                    }
+            if(size) {
+                plain.resize(static_cast<typename ByteArrayT::size_type>(*size));
+                m_isValid = Base32Codec::decode(in, std::span<ByteT>(plain.data(), *size), normalise).has_value();
+            } else {
+                m_isValid = false;
+            }
 
-                    stillTrimmingTrailingEquals = false;
-                }
+            clearEncoded();
 
-                if(DictEnd == std::find(DictBegin, DictEnd, ch)) {
-                    std::cerr << "invalid base32 character '" << ch << "' found at byte position " << i << "\n";
-                    m_isValid = false;
-                    return false;
-                }
+            if(!m_isValid) {
+                std::cerr << "invalid base32 data\n";
+                std::fill(plain.begin(), plain.end(), 0);
+                m_plain.clear();
+                return false;
             }
 
-            m_encoded = base32;
-            m_plainInSync = false;
-            m_encodedInSync = true;
-            m_isValid = true;
+            m_plain = std::move(plain);
             return true;
         }
 
@@ -136,10 +761,6 @@ namespace LibQonvince
          */
         inline const ByteArrayT & plain() const
         {
-            if(!m_plainInSync) {
-                decode();
-            }
-
             return m_plain;
         }
 
@@ -153,7 +774,10 @@ namespace LibQonvince
         inline const ByteArrayT & encoded() const
         {
             if(!m_encodedInSync) {
-                encode();
+                const auto size = Base32Codec::encodedSize(static_cast<std::size_t>(m_plain.size()));
+                m_encoded.resize(static_cast<typename ByteArrayT::size_type>(size));
+                Base32Codec::encode(std::span<const ByteT>(m_plain.data(), static_cast<std::size_t>(m_plain.size())), std::span<ByteT>(m_encoded.data(), size));
+                m_encodedInSync = true;
             }
 
             return m_encoded;
@@ -161,203 +785,25 @@ namespace LibQonvince
 
     private:
         /**
-         * Internal helper to decode the Base32 encoded content.
-         *
-         * This is called when the plain text content is requested and the internal cache of the plain text content is out of sync.
-         */
-        void decode() const
-        {
-            auto & ba = m_encoded;
-
-            std::transform(ba.begin(), ba.end(), ba.begin(), [](const ByteT & ch) -> ByteT {
-                return static_cast<ByteT>(std::toupper(ch));
-            });
-
-            m_plain.clear();
-
-            // tolerate badly terminated encoded strings by padding with = to appropriate len
-            auto len = ba.size();
-
-            if(0 == len) {
-                return;
-            }
-
-            auto remainder = len % 8;
-
-            if(0 < remainder) {
-                std::fill_n(std::back_inserter(ba), 8 - remainder, '=');
-            }
-
-            int j;
-            auto iLoopEnd = static_cast<int>(ba.size());
-
-            for(int i = 0; i < iLoopEnd; i += 8) {
-                uint64_t out = 0x00;
-
-                for(j = 0; j < 8; ++j) {
-                    if('=' == ba[i + j]) {
-                        break;
-                    }
-
-                    auto pos = std::find(DictBegin, DictEnd, ba[i + j]);
-
-                    if(DictEnd == pos) {
-                        std::cerr << "invalid character in base32 data:" << ba[i + j] << "\n";
-                        m_isValid = false;
-                        m_plain.clear();
-                        return;
-                    }
-
-                    out <<= 5u;
-                    out |= (std::distance(DictBegin, pos) & 0x1f);
-                }
-
-                /* in any chunk we must have processed either 2, 4, 5, 7 or 8 bytes */
-                unsigned int outByteCount;
-
-                switch(j) {
-                    case 8:
-                        outByteCount = 5;
-                        break;
-
-                    case 7:
-                        outByteCount = 4;
-                        out <<= 5u;
-                        break;
-
-                    case 5:
-                        outByteCount = 3;
-                        out <<= 15u;
-                        break;
-
-                    case 4:
-                        outByteCount = 2;
-                        out <<= 20u;
-                        break;
-
-                    case 2:
-                        outByteCount = 1;
-                        out <<= 30u;
-                        break;
-
-                    default:
-                        std::cerr << "invalid base32 sequence at byte " << i << "\n";
-                        m_isValid = false;
-                        m_plain.clear();
-                        return;
-                }
-
-                std::array<ByteT, 5> outBytes;
-                outBytes[4] = static_cast<ByteT>(out & 0xffu);
-                outBytes[3] = static_cast<std::make_unsigned_t<ByteT>>((out >> 8u) & 0xffu);
-                outBytes[2] = static_cast<ByteT>((out >> 16u) & 0xffu);
-                outBytes[1] = static_cast<ByteT>((out >> 24u) & 0xffu);
-                outBytes[0] = static_cast<ByteT>((out >> 32u) & 0xffu);
-
-                const auto begin = outBytes.cbegin();
-                std::copy(begin, begin + outByteCount, std::back_inserter(m_plain));
-            }
-
-            m_isValid = true;
-            m_plainInSync = true;
-        }
-
-        /**
-         * Internal helper to encode the plain text content as Base32 when required.
-         *
-         * This is called when the encoded content is requested and the internal cache of the encoded content is out of sync.
+         * Discard the cached encoded content so that only one copy of the content is held until encoded() is next called.
          */
-        void encode() const
+        void clearEncoded()
         {
+            std::fill(m_encoded.begin(), m_encoded.end(), 0);
             m_encoded.clear();
-            auto len = m_plain.size();
-
-            if(0 == len) {
-                return;
-            }
-
-            auto remainder = len % 5;
-
-            if(0 < remainder) {
-                std::fill_n(std::back_inserter(m_plain), 5 - remainder, 0);
-            }
-
-            unsigned int paddedLen = len + (5 - remainder);
-            unsigned int pos = 0;
-
-            while(pos < paddedLen) {
-                uint64_t bits = 0x00u | (static_cast<uint64_t>(m_plain[pos]) << 32u) |
-                                (static_cast<uint64_t>(m_plain[pos + 1]) << 24u) |
-                                (static_cast<uint64_t>(m_plain[pos + 2]) << 16u) |
-                                (static_cast<uint64_t>(m_plain[pos + 3]) << 8u) |
-                                (static_cast<uint64_t>(m_plain[pos + 4]));
-
-                // TODO do dict lookup directly into m_encoded rather than via out
-                std::array<ByteT, 8> out;
-                auto * bytePtr = std::addressof(out.back());
-
-                for(typename decltype(out)::size_type i = 0; i < out.size(); ++i) {
-                    *bytePtr = Dictionary[bits & 0x1fu];
-                    --bytePtr;
-                    bits = bits >> 5u;
-                }
-
-                std::copy(out.cbegin(), out.cend(), std::back_inserter(m_encoded));
-                pos += 5;
-            }
-
-            switch(remainder) {
-                case 0:
-                    break;
-
-                case 1:
-                    std::fill_n(m_encoded.end() - 6, 6, '=');
-                    m_plain.resize(len);
-                    break;
-
-                case 2:
-                    std::fill_n(m_encoded.end() - 4, 4, '=');
-                    m_plain.resize(len);
-                    break;
-
-                case 3:
-                    std::fill_n(m_encoded.end() - 3, 3, '=');
-                    m_plain.resize(len);
-                    break;
-
-                case 4:
-                    std::fill_n(m_encoded.end() - 1, 1, '=');
-                    m_plain.resize(len);
-                    break;
-            }
-
-            m_encodedInSync = true;
+            m_encodedInSync = false;
         }
 
-        using DictionaryT = std::array<char, 32>;
-        static constexpr const DictionaryT Dictionary = {{'A', 'B', 'C', 'D', 'E', 'F',
-                                                          'G', 'H', 'I', 'J', 'K', 'L',
-                                                          'M', 'N', 'O', 'P', 'Q', 'R',
-                                                          'S', 'T', 'U', 'V', 'W', 'X',
-                                                          'Y', 'Z', '2', '3', '4', '5',
-                                                          '6', '7'}};
-        static constexpr const DictionaryT::const_iterator DictBegin = Dictionary.cbegin();
-        static constexpr const DictionaryT::const_iterator DictEnd = Dictionary.cend();
-
-        mutable bool m_isValid;
-
-        /** Whether or not the plain data member is the plain representation of
-         * the Base32-encoded data member. */
-        mutable bool m_plainInSync;
+        bool m_isValid;
 
         /** Whether or not the Base32-encoded data member is the Base32
          * representation of the plain data member. */
         mutable bool m_encodedInSync;
 
         /** The plain (unencoded) data. */
-        mutable ByteArrayT m_plain;
+        ByteArrayT m_plain;
 
-        /** The Base32-encoded data. */
+        /** The Base32-encoded data, generated on demand. */
         mutable ByteArrayT m_encoded;
     };
 
@@ -2,7 +2,107 @@
 
 namespace LibQonvince
 {
+    namespace
+    {
+        // the interface implemented by plugins built against API version 2. the virtual functions must stay in the same
+        // order as they were in that version, since these are called through the plugin's vtable
+        class OtpDisplayPluginV2
+        {
+        public:
+            virtual ~OtpDisplayPluginV2() = default;
+
+            [[nodiscard]] virtual const std::string & name() const = 0;
+            [[nodiscard]] virtual const std::string & displayName() const = 0;
+            [[nodiscard]] virtual const std::string & description() const = 0;
+            [[nodiscard]] virtual const std::string & author() const = 0;
+            [[nodiscard]] virtual const std::string & versionString() const = 0;
+            [[nodiscard]] virtual SecureString codeDisplayString(const SecureString & hmac) const = 0;
+        };
+
+        class OtpDisplayPluginV2Adapter final
+                : public OtpDisplayPlugin
+        {
+        public:
+            explicit OtpDisplayPluginV2Adapter(std::unique_ptr<OtpDisplayPluginV2> plugin)
+                    : m_plugin(std::move(plugin))
+            {
+            }
+
+            const std::string & name() const override
+            {
+                return m_plugin->name();
+            }
+
+            const std::string & displayName() const override
+            {
+                return m_plugin->displayName();
+            }
+
+            const std::string & description() const override
+            {
+                return m_plugin->description();
+            }
+
+            const std::string & author() const override
+            {
+                return m_plugin->author();
+            }
+
+            const std::string & versionString() const override
+            {
+                return m_plugin->versionString();
+            }
+
+            std::size_t writeCode(Digest digest, CodeBuffer code) const override
+            {
+                // the old interface still costs a SecureString each way
+                const auto display = m_plugin->codeDisplayString(SecureString(digest.data(), digest.size()));
+                const auto length = std::min(display.size(), code.size());
+                std::copy_n(display.cbegin(), length, code.begin());
+                return length;
+            }
+
+        private:
+            std::unique_ptr<OtpDisplayPluginV2> m_plugin;
+        };
+    }  // namespace
+
     const std::string OtpDisplayPlugin::PluginTypeName = LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_TYPE;
 
     OtpDisplayPlugin::~OtpDisplayPlugin() = default;
+
+    void OtpDisplayPlugin::writeCodes(std::span<const char> digests, std::span<char> codes, std::span<std::size_t> lengths) const
+    {
+        forEachCode(digests, codes, lengths, [this](Digest digest, CodeBuffer code) {
+            return writeCode(digest, code);
+        });
+    }
+
+    SecureString OtpDisplayPlugin::codeDisplayString(const SecureString & hmac) const
+    {
+        const DisplayCode code(*this, hmac);
+        return {code.view().data(), code.view().size()};
+    }
+
+    DisplayCode::DisplayCode(const OtpDisplayPlugin & plugin, const SecureString & hmac)
+            : m_length(0)
+    {
+        if (OtpDisplayPlugin::DigestSize <= hmac.size()) {
+            m_length = std::min(plugin.writeCode(OtpDisplayPlugin::Digest(hmac.data(), OtpDisplayPlugin::DigestSize), m_code), m_code.size());
+        }
+    }
+
+    DisplayCode::~DisplayCode()
+    {
+        secureWipe(m_code.data(), m_code.size());
+    }
+
+    std::unique_ptr<OtpDisplayPlugin> OtpDisplayPlugin::fromLegacyInstance(int apiVersion, void * instance)
+    {
+        if (2 != apiVersion || !instance) {
+            return nullptr;
+        }
+
+        return std::make_unique<OtpDisplayPluginV2Adapter>(std::unique_ptr<OtpDisplayPluginV2>(static_cast<OtpDisplayPluginV2 *>(instance)));
+    }
 }  // namespace LibQonvince
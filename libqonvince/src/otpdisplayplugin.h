@@ -1,12 +1,19 @@
 #ifndef QONVINCE_OTPDISPLAYPLUGIN_H
 #define QONVINCE_OTPDISPLAYPLUGIN_H
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
 #include <string>
+#include <string_view>
 
 #include "plugininfo.h"
 #include "securestring.h"
 
-#define LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_API_VERSION 2
+// version 3 writes codes into caller-supplied buffers; version 2 returned a new SecureString for each code
+#define LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_API_VERSION 3
 #define LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_TYPE "OtpDisplayPlugin"
 
 namespace LibQonvince
@@ -17,6 +24,18 @@ namespace LibQonvince
         static const std::string PluginTypeName;
         static constexpr const int ApiVersion = LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_API_VERSION;
 
+        // plugins built against this or any later version are loaded; the older ones through an adapter (see fromLegacyInstance())
+        static constexpr const int OldestSupportedApiVersion = 2;
+
+        // codes are made from HMAC-SHA1 digests
+        static constexpr const std::size_t DigestSize = 20;
+
+        // the longest code a plugin can write
+        static constexpr const std::size_t MaxCodeLength = 16;
+
+        using Digest = std::span<const char, DigestSize>;
+        using CodeBuffer = std::span<char, MaxCodeLength>;
+
         OtpDisplayPlugin() = default;
         OtpDisplayPlugin(const OtpDisplayPlugin &) = delete;
         OtpDisplayPlugin(OtpDisplayPlugin &&) = delete;
@@ -32,8 +51,63 @@ namespace LibQonvince
         [[nodiscard]] virtual const std::string & author() const = 0;
         [[nodiscard]] virtual const std::string & versionString() const = 0;
 
-        // plugin classes must implement this
-        [[nodiscard]] virtual SecureString codeDisplayString(const SecureString & hmac) const = 0;
+        // plugin classes must implement this. it writes the code for a digest at the start of the buffer and returns its
+        // length
+        [[nodiscard]] virtual std::size_t writeCode(Digest digest, CodeBuffer code) const = 0;
+
+        // write the codes for a run of digests laid end to end. the code for digest n is written to the MaxCodeLength bytes
+        // of codes that start at n * MaxCodeLength, and its length to lengths[n]. the batch is as long as the shortest of
+        // the three spans allows. the default calls writeCode() for each digest
+        virtual void writeCodes(std::span<const char> digests, std::span<char> codes, std::span<std::size_t> lengths) const;
+
+        // the code for a digest as a SecureString, for callers that aren't generating codes in bulk. the hmac must be at
+        // least DigestSize bytes
+        [[nodiscard]] SecureString codeDisplayString(const SecureString & hmac) const;
+
+        // wrap the instance created by a plugin built against an older API version. returns null if the version is not
+        // supported
+        static std::unique_ptr<OtpDisplayPlugin> fromLegacyInstance(int apiVersion, void * instance);
+
+    protected:
+        // call write(digest, code) for each digest in a batch, as described for writeCodes()
+        template<class WriteFunction>
+        static void forEachCode(std::span<const char> digests, std::span<char> codes, std::span<std::size_t> lengths, WriteFunction && write)
+        {
+            const auto count = std::min({digests.size() / DigestSize, codes.size() / MaxCodeLength, lengths.size()});
+
+            for (std::size_t idx = 0; idx < count; ++idx) {
+                lengths[idx] = write(digests.subspan(idx * DigestSize).template first<DigestSize>(),
+                                     codes.subspan(idx * MaxCodeLength).template first<MaxCodeLength>());
+            }
+        }
+    };
+
+    // a code written by a display plugin into a buffer of its own, which is wiped when it goes out of scope
+    class DisplayCode final
+    {
+    public:
+        // the code is empty if the hmac is shorter than OtpDisplayPlugin::DigestSize
+        DisplayCode(const OtpDisplayPlugin & plugin, const SecureString & hmac);
+        ~DisplayCode();
+
+        DisplayCode(const DisplayCode &) = delete;
+        DisplayCode(DisplayCode &&) = delete;
+        DisplayCode & operator=(const DisplayCode &) = delete;
+        DisplayCode & operator=(DisplayCode &&) = delete;
+
+        [[nodiscard]] std::string_view view() const
+        {
+            return {m_code.data(), m_length};
+        }
+
+        [[nodiscard]] bool empty() const
+        {
+            return 0 == m_length;
+        }
+
+    private:
+        std::array<char, OtpDisplayPlugin::MaxCodeLength> m_code;
+        std::size_t m_length;
     };
 
     extern "C"
@@ -52,27 +126,35 @@ public:                                               \
     // use the macros for the api version and plugin type name because we want the
     // content set at compile time not resolved at runtime (otherwise the checks in
     // PluginFactory would be circumventable)
+#if defined(LIBQONVINCE_BUILTIN_PLUGIN)
+    // plugins compiled into the application are created directly, so they export nothing that could clash
+#define LIBQONVINCE_OTPDISPLAYPLUGIN_EXPORTS(className_, displayName_, description_, author_, version_)
+#else
+#define LIBQONVINCE_OTPDISPLAYPLUGIN_EXPORTS(className_, displayName_, description_, author_, version_) \
+    extern LibQonvince::PluginInfo pluginInfo;                                                       \
+    extern "C"                                                                                       \
+    {                                                                                                \
+        LibQonvince::OtpDisplayPlugin * createInstance()                                             \
+        {                                                                                            \
+            return new className_();                                                                 \
+        }                                                                                            \
+    }                                                                                                \
+                                                                                                     \
+    LibQonvince::PluginInfo pluginInfo = {                                                           \
+      LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_API_VERSION, /* apiVersion */                              \
+      LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_TYPE,        /* pluginType (i.e. base class name)*/        \
+      __FILE__,                                        /* fileName */                                \
+      #className_,                                     /* className */                               \
+      #className_,                                     /* pluginName */                              \
+      displayName_,                                    /* displayName */                             \
+      description_,                                    /* description */                             \
+      author_,                                         /* authorName */                              \
+      version_,                                        /* versionString */                           \
+    };
+#endif
+
 #define DECLARE_LIBQONVINCE_OTPDISPLAYPLUGIN(className_, displayName_, description_, author_, version_) \
-    extern LibQonvince::PluginInfo pluginInfo;                                                          \
-    extern "C"                                                                                          \
-    {                                                                                                   \
-        LibQonvince::OtpDisplayPlugin * createInstance()                                                \
-        {                                                                                               \
-            return new className_();                                                                    \
-        }                                                                                               \
-    }                                                                                                   \
-                                                                                                        \
-    LibQonvince::PluginInfo pluginInfo = {                                                              \
-      LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_API_VERSION, /* apiVersion */                                 \
-      LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_TYPE,        /* pluginType (i.e. base class name)*/           \
-      __FILE__,                                        /* fileName */                                   \
-      #className_,                                     /* className */                                  \
-      #className_,                                     /* pluginName */                                 \
-      displayName_,                                    /* displayName */                                \
-      description_,                                    /* description */                                \
-      author_,                                         /* authorName */                                 \
-      version_,                                        /* versionString */                              \
-    };                                                                                                  \
+    LIBQONVINCE_OTPDISPLAYPLUGIN_EXPORTS(className_, displayName_, description_, author_, version_)     \
                                                                                                         \
     const std::string & className_::name() const                                                        \
     {                                                                                                   \
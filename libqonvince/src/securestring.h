@@ -187,4 +187,19 @@ namespace LibQonvince
      * Convenience alias for std::string, using the secure allocator.
      */
     using SecureString = SecureBasicString<char>;
+
+    /**
+     * Overwrite memory that is not owned by a SecureAllocator (e.g. a buffer on the stack) with 0 bytes.
+     *
+     * As with SecureAllocator::deallocate(), the memory is written through a volatile pointer so that the compiler doesn't
+     * optimise the writes away.
+     */
+    inline void secureWipe(void * data, std::size_t size) noexcept
+    {
+        auto * bytes = static_cast<volatile char *>(data);
+
+        for(std::size_t idx = 0; idx < size; ++idx) {
+            bytes[idx] = 0;
+        }
+    }
 }  // namespace LibQonvince
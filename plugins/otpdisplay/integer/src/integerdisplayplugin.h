@@ -19,41 +19,79 @@
 #ifndef QONVINCE_OTPDISPLAYPLUGIN_INTEGER_H
 #define QONVINCE_OTPDISPLAYPLUGIN_INTEGER_H
 
-#include <cmath>
+#include <array>
+#include <cstdint>
 #include "otpdisplayplugin.h"
-#include "securestring.h"
-
-using LibQonvince::SecureString;
 
 template<int Digits>
 class IntegerDisplayPlugin
         : public LibQonvince::OtpDisplayPlugin
 {
 	static_assert(0 < Digits, "The number of digits must be > 0");
+	static_assert(static_cast<std::size_t>(Digits) <= MaxCodeLength, "The number of digits must fit in a code buffer");
+
+public:
+	std::size_t writeCode(Digest digest, CodeBuffer code) const override
+	{
+		return format(digest, code);
+	}
+
+	// formats the whole batch without a virtual call per code
+	void writeCodes(std::span<const char> digests, std::span<char> codes, std::span<std::size_t> lengths) const override
+	{
+		forEachCode(digests, codes, lengths, &IntegerDisplayPlugin::format);
+	}
+
+private:
+	static constexpr const std::uint64_t Modulus = []() {
+		std::uint64_t modulus = 1;
+
+		for (int digit = 0; digit < Digits; ++digit) {
+			modulus *= 10;
+		}
+
+		return modulus;
+	}();
+
+	// the two characters for each value from 00 to 99, so that the digits can be written a pair at a time
+	static constexpr const std::array<char, 200> DigitPairs = []() {
+		std::array<char, 200> pairs = {};
+
+		for (int value = 0; value < 100; ++value) {
+			pairs[2 * value] = static_cast<char>('0' + value / 10);
+			pairs[2 * value + 1] = static_cast<char>('0' + value % 10);
+		}
+
+		return pairs;
+	}();
+
+	static std::size_t format(Digest hmac, CodeBuffer code)
+	{
+		// calculate offset and read value from 4 bytes at offset
+		const auto offset = static_cast<std::size_t>(hmac[19] & 0xf);
+		auto value = static_cast<std::uint64_t>((hmac[offset] & 0x7f) << 24 | (hmac[offset + 1] & 0xff) << 16 | (hmac[offset + 2] & 0xff) << 8 |
+														  (hmac[offset + 3] & 0xff));
+
+		// convert value to requested number of digits
+		value %= Modulus;
+
+		// insert the digits from the value from right to left, including any leading 0s
+		auto pos = static_cast<std::size_t>(Digits);
+
+		while (1 < pos) {
+			const auto pair = 2 * (value % 100);
+			code[pos - 1] = DigitPairs[pair + 1];
+			code[pos - 2] = DigitPairs[pair];
+			pos -= 2;
+			value /= 100;
+		}
+
+		if (1 == pos) {
+			code[0] = static_cast<char>('0' + value % 10);
+		}
 
-	SecureString codeDisplayString(const SecureString & hmac) const override
-    {
-        // calculate offset and read value from 4 bytes at offset
-        int offset = static_cast<char>(hmac[19]) & 0xf;
-        auto value = static_cast<uint32_t>((hmac[offset] & 0x7f) << 24 | (hmac[offset + 1] & 0xff) << 16 | (hmac[offset + 2] & 0xff) << 8 |
-                                        (hmac[offset + 3] & 0xff));
-
-        // convert value to requested number of digits
-		  value = value % static_cast<int>(pow(10.0, Digits));
-
-        // initialise the returned string to all 0s so we don't need to pad it later
-		  auto ret = SecureString(Digits, '0');
-		  auto pos = Digits - 1;
-
-		  // insert the digits from the value from right to left
-		  while (0 < value) {
-			  ret[pos] = static_cast<char>('0' + (value % 10));
-			  --pos;
-			  value /= 10;
-		  }
-
-		  return ret;
-    }
+		return static_cast<std::size_t>(Digits);
+	}
 };
 
 #endif  // QONVINCE_OTPDISPLAYPLUGIN_INTEGER_H
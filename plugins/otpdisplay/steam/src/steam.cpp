@@ -1,9 +1,8 @@
 #include "steam.h"
 
 #include <array>
-#include "securestring.h"
-
-using LibQonvince::SecureString;
+#include <cstdint>
+#include <cstring>
 
 DECLARE_LIBQONVINCE_OTPDISPLAYPLUGIN(SteamOtpDisplayPlugin, "Steam code", "Display the code as a Steam-type 5-character code.", "Darren Edale", "1.0.0")
 
@@ -15,25 +14,24 @@ namespace
 }  // namespace
 
 // heavily influenced by WinAuth's Steam code generator
-SecureString SteamOtpDisplayPlugin::codeDisplayString(const SecureString & hmac) const
+std::size_t SteamOtpDisplayPlugin::writeCode(Digest hmac, CodeBuffer code) const
 {
     // the last 4 bits of the mac say where the code starts
     // (e.g. if last 4 bit are 1100, we start at byte 12)
-    int i = hmac[19] & 0x0f;
+    const auto offset = static_cast<std::size_t>(hmac[19] & 0x0f);
 
     // TODO check endianness and reverse if necessary
 
     // extract those 4 bytes
-    std::array<char, 4> bytes = {{hmac[i], hmac[i + 1], hmac[i + 2], hmac[i + 3]}};
-    uint32_t fullcode = *(reinterpret_cast<uint32_t *>(&bytes[0])) & 0x7fffffff;
+    std::uint32_t fullcode;
+    std::memcpy(&fullcode, hmac.data() + offset, sizeof(fullcode));
+    fullcode &= 0x7fffffff;
 
     // build the alphanumeric code
-    SecureString code(CodeDigits, '\0');
-
-    for (i = 0; i < CodeDigits; ++i) {
-        code[i] = Alphabet[fullcode % Alphabet.size()];
+    for (int idx = 0; idx < CodeDigits; ++idx) {
+        code[static_cast<std::size_t>(idx)] = Alphabet[fullcode % Alphabet.size()];
         fullcode /= Alphabet.size();
     }
 
-    return code;
+    return CodeDigits;
 }
@@ -2,9 +2,6 @@
 #define QONVINCE_OTPDISPLAYPLUGIN_STEAM_H
 
 #include "otpdisplayplugin.h"
-#include "securestring.h"
-
-using LibQonvince::SecureString;
 
 class SteamOtpDisplayPlugin
         : public LibQonvince::OtpDisplayPlugin
@@ -12,7 +9,7 @@ class SteamOtpDisplayPlugin
 public:
 LIBQONVINCE_OTPDISPLAYPLUGIN
 
-	SecureString codeDisplayString(const SecureString & hmac) const override;
+	std::size_t writeCode(Digest digest, CodeBuffer code) const override;
 };
 
 #endif  // QONVINCE_OTPDISPLAYPLUGIN_STEAM_H
@@ -34,6 +34,7 @@
  */
 
 #include "application.h"
+#include <algorithm>
 #include <array>
 #include <iostream>
 #include <iterator>
@@ -41,13 +42,13 @@
 #include <QString>
 #include <QStringBuilder>
 #include <QChar>
-#include <QThread>
 #include <QSystemTrayIcon>
 #include <QMenu>
 #include <QAction>
 #include <QClipboard>
 #include <QSettings>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QCryptographicHash>
 #include <QScreen>
@@ -63,18 +64,44 @@
 #include "mainwindow.h"
 #include "changepassphrasedialogue.h"
 #include "passphrasedialogue.h"
+#include "settingsunlocker.h"
 #include "settingswidget.h"
 #include "aboutdialogue.h"
 #include "otplistview.h"
 #include "otp.h"
 #include "otpqrcodereader.h"
+#include "functions.h"
+#include "instanceclient.h"
+
+#if defined(WITH_DBUS_SERVICE)
+#include "dbusservice.h"
+#endif
 #include "pluginfactory.h"
 #include "qtiostream.h"
 
+// the display plugins built into the application
+#include "sixdigits.h"
+#include "eightdigits.h"
+#include "steam.h"
+
 namespace Qonvince
 {
 	namespace
 	{
+		// a compile-time list of plugin classes, each of which is created and added to a plugin factory
+		template<class... PluginTypes>
+		struct PluginRegistry
+		{
+			template<class PluginType>
+			static void addTo(PluginFactory<PluginType> & factory)
+			{
+				(factory.template addBuiltInPlugin<PluginTypes>(), ...);
+			}
+		};
+
+		// to build another plugin in, add it here and link its _builtin object library into qonvince_core
+		using BuiltInDisplayPlugins = PluginRegistry<SixDigitsPlugin, EightDigitsPlugin, SteamOtpDisplayPlugin>;
+
 		// Based on RunGuard code from
 		// http://stackoverflow.com/questions/5006547/qt-best-practice-for-a-single-instance-app-protection
 		class SingleInstanceGuard final
@@ -170,6 +197,9 @@ namespace Qonvince
 		};
 
 		static constexpr const int MininumPassphraseLength = 8;
+
+		// how long to wait after an incorrect passphrase before another can be entered
+		static constexpr const int IncorrectPassphraseDelay = 1000;
 	}	// namespace
 
 	Application::Application(int & argc, char ** argv)
@@ -182,17 +212,16 @@ namespace Qonvince
 	  m_notificationsInterface(QStringLiteral("org.freedesktop.Notifications"),
 										QStringLiteral("/org/freedesktop/Notifications"),
 										QStringLiteral("org.freedesktop.Notifications")),
-	  m_displayPluginFactory(".displayplugin")
+	  m_displayPluginFactory(".displayplugin"),
+	  m_startupRequest({{"request", InstanceServer::ShowRequest}}),
+	  m_codeServerRequested(false),
+	  m_dbusServiceRequested(false)
 	{
 		m_clipboardClearTimer.setSingleShot(true);
 
-		setOrganizationName(QStringLiteral("Equit"));
-		setOrganizationDomain(QStringLiteral("equit.dev"));
-		setApplicationName(QStringLiteral("Qonvince"));
+		setApplicationIdentity();
 		setApplicationDisplayName(QStringLiteral("Qonvince"));
-		setApplicationVersion(QStringLiteral("1.11.1"));
 		setQuitOnLastWindowClosed(false);
-		QSettings::setDefaultFormat(QSettings::IniFormat);
 
 		processCommandLineArguments();
 		loadPlugins();
@@ -252,7 +281,16 @@ namespace Qonvince
 		return ret;
 	}
 
-	bool Application::checkSettingsPassphrase(const QCA::SecureArray & passphrase) const
+	void Application::setApplicationIdentity()
+	{
+		setOrganizationName(QStringLiteral("Equit"));
+		setOrganizationDomain(QStringLiteral("equit.dev"));
+		setApplicationName(QStringLiteral("Qonvince"));
+		setApplicationVersion(QStringLiteral("1.11.1"));
+		QSettings::setDefaultFormat(QSettings::IniFormat);
+	}
+
+	bool Application::checkSettingsPassphrase(const QCA::SecureArray & passphrase)
 	{
 		QSettings settings;
 
@@ -275,18 +313,49 @@ namespace Qonvince
 		QCA::SecureArray value = QCA::hexToArray(settings.value(QStringLiteral("crypt_check")).toString());
 
 		QCA::Cipher cipher(QStringLiteral("aes256"), QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Decode,
-									QCA::SymmetricKey(m_cryptPassphrase),
+									QCA::SymmetricKey(passphrase),
 									QCA::InitializationVector(value.toByteArray().left(16)));
 		cipher.process(value.toByteArray().mid(16));
 
 		return cipher.ok();
 	}
 
+	void Application::writeCryptCheck(QSettings & settings, const QCA::SecureArray & passphrase)
+	{
+		// this "random" string in the settings will, when read, indicate whether the crypt key is correct. use length of
+		// passphrase so that a truncated passphrase can never pass the check
+		int l = (2 * passphrase.size()) + (std::random_device()() % 20);
+		QByteArray random(l, 0);
+
+		while(0 < l) {
+			l--;
+			random[l] = 'a' + (std::random_device()() % 26);
+		}
+
+		QCA::SymmetricKey key(passphrase);
+		QCA::InitializationVector initVec(16);
+		QCA::Cipher cipher(QStringLiteral("aes256"), QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Encode,
+								 key, initVec);
+		settings.setValue(QStringLiteral("crypt_check"),
+								QCA::arrayToHex(initVec.toByteArray() + cipher.process(random).toByteArray()));
+	}
+
 	bool Application::isValidPassphrase(const QCA::SecureArray & passphrase)
 	{
 		return MininumPassphraseLength < passphrase.size();
 	}
 
+	Otp * Application::otpByIdentifier(const QString & identifier) const
+	{
+		const auto end = m_otpList.cend();
+
+		const auto otp = std::find_if(m_otpList.cbegin(), end, [&identifier](const auto & listOtp) {
+			return identifier == otpIdentifier(listOtp.get());
+		});
+
+		return (end == otp ? nullptr : otp->get());
+	}
+
 	int Application::addOtp(std::unique_ptr<Otp> && otp)
 	{
 		if(!otp || contains(m_otpList, otp)) {
@@ -436,6 +505,8 @@ namespace Qonvince
 		if(settings().clearClipboardAfterInterval() && 0 < settings().clipboardClearInterval()) {
 			m_clipboardClearTimer.start(1000 * settings().clipboardClearInterval());
 		}
+
+		Q_EMIT otpCodeCopied(otp);
 	}
 
 	bool Application::ensureDirectory(QStandardPaths::StandardLocation location, const QString & path)
@@ -492,6 +563,19 @@ namespace Qonvince
 	int Application::exec()
 	{
 		Application * app = qonvinceApp;
+		const bool hasStartupAction = (InstanceServer::ShowRequest != app->m_startupRequest.value("request", std::string()));
+
+		// an unlocked instance can carry out the request without the passphrase being entered again
+		if(hasStartupAction || app->m_settings.singleInstance()) {
+			if(const auto response = InstanceClient::send(app->m_startupRequest); response) {
+				if(!response->value("ok", false)) {
+					std::cerr << "the running instance of Qonvince could not carry out the request: " << response->value("error", std::string()) << "\n";
+					return 1;
+				}
+
+				return 0;
+			}
+		}
 
 		if(app->m_settings.singleInstance()) {
 			if(!SingleInstanceGuard{QStringLiteral("blarglefangledungle")}.tryToRun()) {
@@ -513,44 +597,75 @@ namespace Qonvince
 		// TODO if settings file does not exist, ask user for passphrase to create a new one
 		{
 			PassphraseDialogue dlg(tr("Enter the passphrase used to encrypt your settings."));
+			SettingsUnlocker unlocker;
+			QCA::SecureArray passphrase;
 
-			while(true) {
-				if(QDialog::Accepted != dlg.exec()) {
-					/* if the user refuses to enter his/her passphrase, exit the app */
-					return 0;
-				}
+			// the dialogue stays open and responsive while the unlocker checks the passphrase and decrypts the seeds
+			dlg.setVerifiesPassphrase(true);
+			connect(&unlocker, &SettingsUnlocker::progress, &dlg, &PassphraseDialogue::setProgress);
+
+			const auto rejectPassphrase = [&dlg]() {
+				dlg.setMessage(tr("The passphrase you entered is not correct. Enter the passphrase used to encrypt your settings."));
+
+				// the delay slows down guessing without freezing the UI
+				QTimer::singleShot(IncorrectPassphraseDelay, &dlg, [&dlg]() {
+					dlg.setBusy(false);
+				});
+			};
 
-				QCA::SecureArray passphrase = dlg.passphrase().toUtf8();
+			connect(&dlg, &PassphraseDialogue::passphraseSubmitted, &unlocker, [&unlocker, &passphrase, &rejectPassphrase](const QString & entered) {
+				passphrase = entered.toUtf8();
 
 				if(passphrase.isEmpty()) {
 					std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: passphrase is empty\n";
+					rejectPassphrase();
 				}
 				else if(MininumPassphraseLength > passphrase.size()) {
 					std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: passphrase is too short\n";
+					rejectPassphrase();
 				}
 				else {
-					qonvinceApp->m_cryptPassphrase = passphrase;
-
-					if(app->readCodeSettings()) {
-						// if reading succeeds, passphrase was correct, so
-						// exit loop and continue app execution
-						break;
-					}
+					unlocker.unlock(passphrase);
+				}
+			});
 
-					qonvinceApp->m_cryptPassphrase.clear();
-					std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__
-								 << "]: failed to read code settings - likely incorrect passphrase\n";
+			connect(&unlocker, &SettingsUnlocker::finished, &dlg, [&dlg, &rejectPassphrase](bool passphraseCorrect) {
+				if(passphraseCorrect) {
+					dlg.passphraseVerified();
+					return;
 				}
 
-				// we can only get here if the passphrase was not correct
-				QThread::msleep(1000);
-				dlg.setMessage(
-				  tr("The passphrase you entered is not correct. Enter the passphrase used to encrypt your settings."));
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to read code settings - likely incorrect passphrase\n";
+				rejectPassphrase();
+			});
+
+			if(QDialog::Accepted != dlg.exec()) {
+				/* if the user refuses to enter his/her passphrase, exit the app */
+				return 0;
 			}
+
+			app->unlockCodeSettings(passphrase, unlocker.takeSeeds());
 		}
 
 		app->onSettingsChanged();
 		app->m_trayIcon.show();
+		app->m_instanceServer.listen();
+
+		if(app->m_codeServerRequested) {
+			app->m_codeServer = std::make_unique<CodeServer>();
+
+			if(!app->m_codeServer->start()) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to start the code server\n";
+				app->m_codeServer.reset();
+			}
+		}
+
+#if defined(WITH_DBUS_SERVICE)
+		if(app->m_dbusServiceRequested) {
+			// the service is owned by the application
+			(new DBusService(app))->registerService();
+		}
+#endif
 
 		if(!OtpQrCodeReader::isAvailable()) {
 			qonvinceApp->showNotification(tr("%1 message").arg(Application::applicationDisplayName()),
@@ -560,6 +675,12 @@ namespace Qonvince
 		if(!forceStartMinimised && !app->m_settings.startMinimised()) {
 			app->m_mainWindow.show();
 		}
+
+		if(hasStartupAction) {
+			if(const auto response = InstanceServer::handleRequest(app->m_startupRequest); !response.value("ok", false)) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: " << response.value("error", std::string()) << "\n";
+			}
+		}
 		//	else if(QX11Info::isPlatformX11()){
 		//		/* haven't mapped a main window, so manually inform the system that
 		//		 * we're up and running */
@@ -614,16 +735,16 @@ namespace Qonvince
 		readQrCodeFrom(fileName);
 	}
 
-	void Application::readQrCodeFrom(const QString & fileName)
+	bool Application::readQrCodeFrom(const QString & fileName)
 	{
 		OtpQrCodeReader reader(fileName);
 
 		if(!reader.decode()) {
-			showNotification(tr("The file <strong>%1</strong> could not be read as a QR code."));
-			return;
+			showNotification(tr("The file <strong>%1</strong> could not be read as a QR code.").arg(fileName));
+			return false;
 		}
 
-		addOtp(reader.createOtp());
+		return -1 != addOtp(reader.createOtp());
 	}
 
 	bool Application::readApplicationSettings()
@@ -647,15 +768,33 @@ namespace Qonvince
 			return false;
 		}
 
+		QSettings settings;
+		settings.beginGroup(QStringLiteral("codes"));
+		int n = settings.value(QStringLiteral("code_count"), 0).toInt();
+		SettingsUnlocker::Seeds seeds;
+		seeds.reserve(static_cast<SettingsUnlocker::Seeds::size_type>(std::max(0, n)));
+
+		for(int i = 0; i < n; ++i) {
+			settings.beginGroup(QStringLiteral("code-%1").arg(i));
+			seeds.push_back(Otp::decryptSeed(settings, m_cryptPassphrase));
+			settings.endGroup();
+		}
+
+		readCodeSettings(std::move(seeds));
+		return true;
+	}
+
+	void Application::readCodeSettings(SettingsUnlocker::Seeds seeds)
+	{
 		QSettings settings;
 		m_otpList.clear();
 
 		settings.beginGroup(QStringLiteral("codes"));
-		int n = settings.value(QStringLiteral("code_count"), 0).toInt();
+		int n = std::min(settings.value(QStringLiteral("code_count"), 0).toInt(), static_cast<int>(seeds.size()));
 
 		for(int i = 0; i < n; ++i) {
 			settings.beginGroup(QStringLiteral("code-%1").arg(i));
-			std::unique_ptr<Otp> otp = Otp::fromSettings(settings, m_cryptPassphrase);
+			std::unique_ptr<Otp> otp = Otp::fromSettings(settings, seeds[static_cast<std::size_t>(i)]);
 
 			if(otp) {
 				connect(otp.get(), &Otp::changed, this, &Application::writeSettings);
@@ -667,8 +806,12 @@ namespace Qonvince
 
 			settings.endGroup();
 		}
+	}
 
-		return true;
+	void Application::unlockCodeSettings(const QCA::SecureArray & passphrase, SettingsUnlocker::Seeds seeds)
+	{
+		m_cryptPassphrase = passphrase;
+		readCodeSettings(std::move(seeds));
 	}
 
 	void Application::writeSettings()
@@ -682,40 +825,23 @@ namespace Qonvince
 			  tr("AES256 encryption is required to keep your OTP seeds safe. This encryption algorithm is not available, therefore your OTP settings cannot be saved."));
 		}
 		else {
-			// this "random" string in the settings will, when read, indicate whether the crypt key is correct
-			{
-				// use length of passphrase so that a truncated passphrase can never pass the check
-				int l = (2 * m_cryptPassphrase.size()) + (std::random_device()() % 20);
-				QByteArray random(l, 0);
-
-				while(0 < l) {
-					l--;
-					random[l] = 'a' + (std::random_device()() % 26);
-				}
-
-				QCA::SymmetricKey key(m_cryptPassphrase);
-				QCA::InitializationVector initVec(16);
-				QCA::Cipher cipher(QStringLiteral("aes256"), QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Encode,
-										 key, initVec);
-				settings.setValue(QStringLiteral("crypt_check"),
-										QCA::arrayToHex(initVec.toByteArray() + cipher.process(random).toByteArray()));
-
-				settings.beginGroup(QStringLiteral("codes"));
-				settings.remove(QStringLiteral(
-				  ""));	// remove all settings in "codes" group to ensure file doesn't contain lingering old codes
-				settings.setValue(QStringLiteral("code_count"), static_cast<int>(m_otpList.size()));
-
-				auto i = 0;
-				for(const auto & otp : m_otpList) {
-					Q_ASSERT_X(otp, __PRETTY_FUNCTION__, "found null OTP in OTP list");
-					settings.beginGroup(QStringLiteral("code-%1").arg(i));
-					otp->writeSettings(settings, m_cryptPassphrase);
-					settings.endGroup();
-					++i;
-				}
-
+			writeCryptCheck(settings, m_cryptPassphrase);
+
+			settings.beginGroup(QStringLiteral("codes"));
+			settings.remove(QStringLiteral(
+			  ""));	// remove all settings in "codes" group to ensure file doesn't contain lingering old codes
+			settings.setValue(QStringLiteral("code_count"), static_cast<int>(m_otpList.size()));
+
+			auto i = 0;
+			for(const auto & otp : m_otpList) {
+				Q_ASSERT_X(otp, __PRETTY_FUNCTION__, "found null OTP in OTP list");
+				settings.beginGroup(QStringLiteral("code-%1").arg(i));
+				otp->writeSettings(settings, m_cryptPassphrase);
 				settings.endGroup();
+				++i;
 			}
+
+			settings.endGroup();
 		}
 
 		settings.beginGroup(QStringLiteral("application"));
@@ -725,15 +851,29 @@ namespace Qonvince
 		settings.beginGroup(QStringLiteral("mainwindow"));
 		m_mainWindow.writeSettings(settings);
 		settings.endGroup();
+
+		// once the settings no longer name them, the files for icons that are no longer used can go
+		if(writeOtpDetails) {
+			settings.sync();
+
+			if(QSettings::NoError == settings.status()) {
+				m_iconStore.removeUnreferenced();
+			}
+		}
+	}
+
+	void Application::showMainWindow()
+	{
+		m_mainWindow.show();
+		m_mainWindow.raise();
+		m_mainWindow.activateWindow();
 	}
 
 	void Application::onTrayIconActivated(QSystemTrayIcon::ActivationReason reason)
 	{
 		if(QSystemTrayIcon::Trigger == reason) {
 			if(m_mainWindow.isHidden() || !m_mainWindow.isActiveWindow()) {
-				m_mainWindow.show();
-				m_mainWindow.raise();
-				m_mainWindow.activateWindow();
+				showMainWindow();
 			}
 			else {
 				m_mainWindow.hide();
@@ -827,28 +967,52 @@ namespace Qonvince
 				}
 
 				m_displayPluginFactory.addSearchPath(args[idx].toStdString());
-				break;
+			}
+			else if("--code-server" == arg) {
+				m_codeServerRequested = true;
+			}
+			else if("--dbus-service" == arg) {
+				m_dbusServiceRequested = true;
+			}
+			else if("--copy" == arg || "--import" == arg) {
+				++idx;
+
+				if(argCount <= idx) {
+					std::cerr << "missing argument for " << qPrintable(arg) << " option\n";
+					break;
+				}
+
+				if("--copy" == arg) {
+					m_startupRequest = {{"request", InstanceServer::CopyRequest}, {"otp", args[idx].toStdString()}};
+				}
+				else {
+					// the running instance may have a different working directory
+					m_startupRequest = {{"request", InstanceServer::ImportRequest}, {"file", QFileInfo(args[idx]).absoluteFilePath().toStdString()}};
+				}
 			}
 		}
 	}
 
-	void Application::loadPlugins()
+	void Application::addDisplayPluginSearchPaths(DisplayPluginFactory & factory)
 	{
-		// set the search paths for the display plugin factory
 		const auto locations = QStandardPaths::standardLocations(QStandardPaths::AppDataLocation);
 
 		for (const auto & pathRoot : locations) {
-			m_displayPluginFactory.addSearchPath(pathRoot.toStdString() + "/plugins/otpdisplay");
+			factory.addSearchPath(pathRoot.toStdString() + "/plugins/otpdisplay");
 		}
+	}
 
-#ifndef NDEBUG
-		// search in the build dir
-		m_displayPluginFactory.addSearchPath("../plugins/otpdisplay/integer/sixdigits");
-		m_displayPluginFactory.addSearchPath("../plugins/otpdisplay/integer/eightdigits");
-		m_displayPluginFactory.addSearchPath("../plugins/otpdisplay/steam");
-#endif
+	void Application::addBuiltInDisplayPlugins(DisplayPluginFactory & factory)
+	{
+		BuiltInDisplayPlugins::addTo(factory);
+	}
 
-		m_displayPluginFactory.loadAllPlugins();
+	void Application::loadPlugins()
+	{
+		// the bundled plugins are built in, so the plugin files are only opened once something asks for a plugin that
+		// isn't one of them
+		addBuiltInDisplayPlugins(m_displayPluginFactory);
+		addDisplayPluginSearchPaths(m_displayPluginFactory);
 	}
 
 	void Application::setUpTrayIcon()
@@ -20,11 +20,13 @@
 #ifndef QONVINCE_APPLICATION_H
 #define QONVINCE_APPLICATION_H
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 #include <QtCore/QString>
 #include <QtCore/QObject>
+#include <QtCore/QSettings>
 #include <QtCore/QStandardPaths>
 #include <QtCore/QTimer>
 #include <QtDBus/QDBusInterface>
@@ -41,6 +43,10 @@
 #include "settingswidget.h"
 #include "aboutdialogue.h"
 #include "otpdisplayplugin.h"
+#include "instanceserver.h"
+#include "codeserver.h"
+#include "iconstore.h"
+#include "settingsunlocker.h"
 #include "pluginfactory.h"
 #include "securestring.h"
 #include "qtstdhash.h"
@@ -57,6 +63,8 @@ namespace Qonvince
 		Q_OBJECT
 
 	public:
+		using DisplayPluginFactory = PluginFactory<LibQonvince::OtpDisplayPlugin>;
+
 		// globally-accessible constant to assist with UI adaptation to screens with different DPIs
 		static constexpr const auto ReferencePixelDensity = 96;
 
@@ -65,6 +73,16 @@ namespace Qonvince
 
 		static DesktopEnvironment desktopEnvironment();
 
+		// sets the organisation/application names that determine where settings are stored. this only requires a
+		// QCoreApplication so that the command-line client can find the same settings as the GUI
+		static void setApplicationIdentity();
+
+		// adds the standard locations for display plugins to a plugin factory
+		static void addDisplayPluginSearchPaths(DisplayPluginFactory & factory);
+
+		// adds the display plugins that are compiled into the application to a plugin factory
+		static void addBuiltInDisplayPlugins(DisplayPluginFactory & factory);
+
 		inline static bool ensureDataDirectory(const QString & path)
 		{
 			return ensureDirectory(QStandardPaths::AppLocalDataLocation, path);
@@ -80,7 +98,10 @@ namespace Qonvince
 			return static_cast<Application *>(QApplication::instance());
 		}
 
-		bool checkSettingsPassphrase(const QCA::SecureArray & passphrase) const;
+		static bool checkSettingsPassphrase(const QCA::SecureArray & passphrase);
+
+		// write the value checkSettingsPassphrase() uses to verify the passphrase
+		static void writeCryptCheck(QSettings & settings, const QCA::SecureArray & passphrase);
 
 		/**
 		 * Check whether a passphrase is valid for use (i.e. is it strong enough).
@@ -107,6 +128,11 @@ namespace Qonvince
 			return m_settings;
 		}
 
+		inline IconStore & iconStore()
+		{
+			return m_iconStore;
+		}
+
 		inline int otpCount() const
 		{
 			return static_cast<int>(m_otpList.size());
@@ -121,6 +147,9 @@ namespace Qonvince
 			return m_otpList[static_cast<std::size_t>(index)].get();
 		}
 
+		// find an OTP by its issuer:name identifier (see otpIdentifier())
+		Otp * otpByIdentifier(const QString & identifier) const;
+
 		int addOtp(std::unique_ptr<Otp> &&);
 
 		// Application takes ownership of otp
@@ -154,13 +183,38 @@ namespace Qonvince
 			return m_displayPluginFactory.pluginByName(name.toStdString());
 		}
 
+		// resolve a plugin name once, then use the handle to fetch the plugin each time it's needed
+		inline DisplayPluginFactory::Handle otpDisplayPluginHandle(const QString & name)
+		{
+			return m_displayPluginFactory.handleByName(name.toStdString());
+		}
+
+		inline LibQonvince::OtpDisplayPlugin * otpDisplayPlugin(DisplayPluginFactory::Handle handle) const
+		{
+			return m_displayPluginFactory.plugin(handle);
+		}
+
+		// changes when a display plugin is loaded, which is the only time a handle for a name can change
+		inline std::uint64_t otpDisplayPluginGeneration() const
+		{
+			return m_displayPluginFactory.generation();
+		}
+
 		inline std::vector<LibQonvince::OtpDisplayPlugin *> otpDisplayPlugins()
 		{
+			// the plugin files are otherwise only searched for when an OTP uses a plugin that isn't loaded
+			m_displayPluginFactory.loadAllPlugins();
 			return m_displayPluginFactory.loadedPlugins();
 		}
 
 		void copyOtpToClipboard(Otp *);
 
+		// create the OTPs from seeds that have already been decrypted with the settings passphrase
+		void readCodeSettings(SettingsUnlocker::Seeds seeds);
+
+		// use a passphrase that has been verified (e.g. by SettingsUnlocker) and create the OTPs from the seeds it decrypted
+		void unlockCodeSettings(const QCA::SecureArray & passphrase, SettingsUnlocker::Seeds seeds);
+
 		static int exec();
 
 	Q_SIGNALS:
@@ -176,6 +230,9 @@ namespace Qonvince
 		void otpChanged(Otp *);
 		void otpChanged(int);
 
+		// the OTP's current code has been put on the clipboard
+		void otpCodeCopied(Otp *);
+
 	public Q_SLOTS:
 		void showNotification(const QString & title, const QString & message, int timeout = 10000);
 		void showNotification(const QString & message, int timeout = 10000);
@@ -183,10 +240,11 @@ namespace Qonvince
 		// TODO requires DBus interface to listen for response call
 		//		void askQuestion(const QString & question, const QStringList & options, int timeout = 10000);
 		void readQrCode();
-		void readQrCodeFrom(const QString & fileName);
+		bool readQrCodeFrom(const QString & fileName);
 		bool readApplicationSettings();
 		bool readCodeSettings();
 		void writeSettings();
+		void showMainWindow();
 		void showAboutDialogue();
 		void showSettingsWidget();
 		void showChangePassphraseWidget();
@@ -197,8 +255,6 @@ namespace Qonvince
 		void onSettingsChanged();
 
 	private:
-		using DisplayPluginFactory = PluginFactory<LibQonvince::OtpDisplayPlugin>;
-
 		static bool ensureDirectory(QStandardPaths::StandardLocation location, const QString & path);
 		void processCommandLineArguments();
 		void loadPlugins();
@@ -212,12 +268,28 @@ namespace Qonvince
 		SecureString m_clipboardContent;
 		QDBusInterface m_notificationsInterface;
 		QMetaObject::Connection m_quitOnMainWindowClosedConnection;
+
+		// declared before the OTPs so that it's still there when they're destroyed
+		IconStore m_iconStore;
 		std::vector<std::unique_ptr<Otp>> m_otpList;
 
 		DisplayPluginFactory m_displayPluginFactory;
 
 		QCA::SecureArray m_cryptPassphrase;
 
+		// serves requests from later invocations once the settings are unlocked
+		InstanceServer m_instanceServer;
+
+		// the request made by the command-line, forwarded to a running instance if there is one
+		nlohmann::json m_startupRequest;
+
+		// only created when requested on the command-line (--code-server)
+		bool m_codeServerRequested;
+		std::unique_ptr<CodeServer> m_codeServer;
+
+		// only registered when requested on the command-line (--dbus-service), and only if built WITH_DBUS_SERVICE
+		bool m_dbusServiceRequested;
+
 		void setUpTrayIcon();
 	};
 
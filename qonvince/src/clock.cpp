@@ -0,0 +1,89 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file clock.cpp
+ * @brief Implementation of the Clock classes.
+ */
+
+#include "clock.h"
+
+#include <atomic>
+#include <QDateTime>
+
+namespace Qonvince
+{
+	namespace
+	{
+		SystemClock & systemClock()
+		{
+			static SystemClock clock;
+			return clock;
+		}
+
+		std::atomic<Clock *> currentClock = nullptr;
+	}	// namespace
+
+	Clock::Clock(QObject * parent)
+	: QObject(parent)
+	{
+	}
+
+	Clock::~Clock()
+	{
+		Clock * self = this;
+		currentClock.compare_exchange_strong(self, nullptr);
+	}
+
+	Clock & Clock::current()
+	{
+		auto * clock = currentClock.load();
+
+		if(!clock) {
+			return systemClock();
+		}
+
+		return *clock;
+	}
+
+	void Clock::setCurrent(Clock * clock)
+	{
+		currentClock = clock;
+	}
+
+	qint64 SystemClock::msecsSinceEpoch() const
+	{
+		return QDateTime::currentMSecsSinceEpoch();
+	}
+
+	VirtualClock::VirtualClock(qint64 msecsSinceEpoch, QObject * parent)
+	: Clock(parent),
+	  m_msecsSinceEpoch(msecsSinceEpoch)
+	{
+	}
+
+	void VirtualClock::setMSecsSinceEpoch(qint64 msecs)
+	{
+		if(msecs == m_msecsSinceEpoch.exchange(msecs)) {
+			return;
+		}
+
+		Q_EMIT adjusted();
+	}
+}	// namespace Qonvince
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_CLOCK_H
+#define QONVINCE_CLOCK_H
+
+#include <atomic>
+#include <QObject>
+#include <QtGlobal>
+
+namespace Qonvince
+{
+	/**
+	 * The source of the current time for code generation and for scheduling code refreshes and countdown repaints.
+	 *
+	 * Everything that needs the current time asks Clock::current() for it rather than the system, so that a
+	 * VirtualClock can be installed to control time in benchmarks and tests. The clock must be installed before any
+	 * Otp or OtpListView is created because they connect to the adjusted() signal of the clock that is current when
+	 * they are constructed.
+	 */
+	class Clock
+	: public QObject
+	{
+		Q_OBJECT
+
+	public:
+		explicit Clock(QObject * parent = nullptr);
+		~Clock() override;
+
+		// UTC
+		[[nodiscard]] virtual qint64 msecsSinceEpoch() const = 0;
+
+		[[nodiscard]] inline qint64 secsSinceEpoch() const
+		{
+			return msecsSinceEpoch() / 1000;
+		}
+
+		// the clock in use, which is the system clock unless another has been installed. this is safe to call from any thread
+		static Clock & current();
+
+		// the caller retains ownership of the clock; nullptr reinstates the system clock
+		static void setCurrent(Clock * clock);
+
+	Q_SIGNALS:
+		// the time has jumped rather than passed, so anything scheduled against the clock must be rescheduled
+		void adjusted();
+	};
+
+	// the real time
+	class SystemClock final
+	: public Clock
+	{
+		Q_OBJECT
+
+	public:
+		using Clock::Clock;
+
+		[[nodiscard]] qint64 msecsSinceEpoch() const override;
+	};
+
+	/**
+	 * A clock that only moves when it is told to.
+	 *
+	 * Moving the clock emits adjusted() so that code refreshes and countdowns catch up immediately, which means hours
+	 * of TOTP rollovers can be replayed in milliseconds by advancing the clock one interval at a time. Timers are still
+	 * driven by real time, so between adjustments they fire late relative to the virtual clock.
+	 */
+	class VirtualClock final
+	: public Clock
+	{
+		Q_OBJECT
+
+	public:
+		explicit VirtualClock(qint64 msecsSinceEpoch = 0, QObject * parent = nullptr);
+
+		[[nodiscard]] qint64 msecsSinceEpoch() const override
+		{
+			return m_msecsSinceEpoch.load(std::memory_order_relaxed);
+		}
+
+		void setMSecsSinceEpoch(qint64 msecs);
+
+		inline void advance(qint64 msecs)
+		{
+			setMSecsSinceEpoch(msecsSinceEpoch() + msecs);
+		}
+
+	private:
+		// the code server reads the time on its own thread
+		std::atomic<qint64> m_msecsSinceEpoch;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_CLOCK_H
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file codebatch.cpp
+ * @brief Implementation of the CodeBatch class.
+ */
+
+#include "codebatch.h"
+
+#include <algorithm>
+#include <numeric>
+#include <span>
+
+using LibQonvince::OtpDisplayPlugin;
+
+namespace Qonvince
+{
+	CodeBatch::~CodeBatch()
+	{
+		LibQonvince::secureWipe(m_digests.data(), m_digests.size());
+		LibQonvince::secureWipe(m_codes.data(), m_codes.size());
+	}
+
+	void CodeBatch::reserve(std::size_t count)
+	{
+		m_plugins.reserve(count);
+		m_digests.reserve(count * OtpDisplayPlugin::DigestSize);
+	}
+
+	std::size_t CodeBatch::add(const OtpDisplayPlugin & plugin, const SecureString & hmac)
+	{
+		const auto index = m_plugins.size();
+
+		// growing the buffers could leave copies of the digests behind, so wipe them before they're released
+		if(m_digests.capacity() < m_digests.size() + OtpDisplayPlugin::DigestSize) {
+			std::vector<char> digests;
+			digests.reserve(std::max(m_digests.capacity() * 2, m_digests.size() + OtpDisplayPlugin::DigestSize));
+			digests.assign(m_digests.cbegin(), m_digests.cend());
+			LibQonvince::secureWipe(m_digests.data(), m_digests.size());
+			m_digests.swap(digests);
+		}
+
+		if(OtpDisplayPlugin::DigestSize > hmac.size()) {
+			m_plugins.push_back(nullptr);
+			m_digests.resize(m_digests.size() + OtpDisplayPlugin::DigestSize, '\0');
+		} else {
+			m_plugins.push_back(&plugin);
+			m_digests.insert(m_digests.cend(), hmac.cbegin(), hmac.cbegin() + OtpDisplayPlugin::DigestSize);
+		}
+
+		return index;
+	}
+
+	void CodeBatch::write()
+	{
+		const auto count = m_plugins.size();
+
+		// the codes for each plugin are written in one run, so order the codes by plugin
+		std::vector<std::size_t> order(count);
+		std::iota(order.begin(), order.end(), std::size_t{0});
+
+		std::stable_sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs) {
+			return std::less<>()(m_plugins[lhs], m_plugins[rhs]);
+		});
+
+		std::vector<char> digests(count * OtpDisplayPlugin::DigestSize);
+		m_positions.assign(count, 0);
+		LibQonvince::secureWipe(m_codes.data(), m_codes.size());
+		m_codes.assign(count * OtpDisplayPlugin::MaxCodeLength, '\0');
+		m_lengths.assign(count, 0);
+
+		for(std::size_t position = 0; position < count; ++position) {
+			m_positions[order[position]] = position;
+			const auto source = m_digests.cbegin() + static_cast<std::ptrdiff_t>(order[position] * OtpDisplayPlugin::DigestSize);
+			std::copy_n(source, OtpDisplayPlugin::DigestSize, digests.begin() + static_cast<std::ptrdiff_t>(position * OtpDisplayPlugin::DigestSize));
+		}
+
+		const auto allDigests = std::span<const char>(digests);
+		const auto allCodes = std::span<char>(m_codes);
+		const auto allLengths = std::span<std::size_t>(m_lengths);
+		std::size_t runStart = 0;
+
+		while(runStart < count) {
+			const auto * plugin = m_plugins[order[runStart]];
+			auto runEnd = runStart + 1;
+
+			while(runEnd < count && m_plugins[order[runEnd]] == plugin) {
+				++runEnd;
+			}
+
+			// the codes that can't be written keep their zero lengths
+			if(plugin) {
+				const auto runLength = runEnd - runStart;
+				plugin->writeCodes(allDigests.subspan(runStart * OtpDisplayPlugin::DigestSize, runLength * OtpDisplayPlugin::DigestSize),
+										 allCodes.subspan(runStart * OtpDisplayPlugin::MaxCodeLength, runLength * OtpDisplayPlugin::MaxCodeLength),
+										 allLengths.subspan(runStart, runLength));
+			}
+
+			runStart = runEnd;
+		}
+
+		LibQonvince::secureWipe(digests.data(), digests.size());
+	}
+
+	std::string_view CodeBatch::code(std::size_t index) const
+	{
+		if(m_positions.size() <= index) {
+			return {};
+		}
+
+		const auto position = m_positions[index];
+		return {m_codes.data() + position * OtpDisplayPlugin::MaxCodeLength, std::min(m_lengths[position], OtpDisplayPlugin::MaxCodeLength)};
+	}
+}	// namespace Qonvince
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_CODEBATCH_H
+#define QONVINCE_CODEBATCH_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "otpdisplayplugin.h"
+#include "securestring.h"
+
+namespace Qonvince
+{
+	using LibQonvince::SecureString;
+
+	/**
+	 * Formats a set of codes, with one call to OtpDisplayPlugin::writeCodes() for each plugin involved.
+	 *
+	 * Add the HMAC for each code along with the plugin that displays it, call write(), then read each code using the
+	 * index add() returned. The digests and codes are wiped when the batch is destroyed.
+	 */
+	class CodeBatch final
+	{
+	public:
+		CodeBatch() = default;
+		~CodeBatch();
+
+		CodeBatch(const CodeBatch &) = delete;
+		CodeBatch(CodeBatch &&) = delete;
+		void operator=(const CodeBatch &) = delete;
+		void operator=(CodeBatch &&) = delete;
+
+		void reserve(std::size_t count);
+
+		// an hmac shorter than OtpDisplayPlugin::DigestSize gets an empty code
+		std::size_t add(const LibQonvince::OtpDisplayPlugin & plugin, const SecureString & hmac);
+
+		void write();
+
+		// only valid once write() has been called, and until the next call to add()
+		[[nodiscard]] std::string_view code(std::size_t index) const;
+
+		[[nodiscard]] std::size_t size() const
+		{
+			return m_plugins.size();
+		}
+
+	private:
+		// the plugin for each code, in the order they were added. null for codes that can't be written
+		std::vector<const LibQonvince::OtpDisplayPlugin *> m_plugins;
+
+		// each code's digest, in the order they were added
+		std::vector<char> m_digests;
+
+		// where each code's digest, code and length are in the batches given to the plugins
+		std::vector<std::size_t> m_positions;
+
+		// the codes and their lengths, grouped by plugin
+		std::vector<char> m_codes;
+		std::vector<std::size_t> m_lengths;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_CODEBATCH_H
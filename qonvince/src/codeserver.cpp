@@ -0,0 +1,362 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file codeserver.cpp
+ * @brief Implementation of the CodeServer class.
+ */
+
+#include "codeserver.h"
+
+#include <iostream>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStandardPaths>
+#include <nlohmann/json.hpp>
+
+#if defined(Q_OS_UNIX)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "application.h"
+#include "clock.h"
+#include "codebatch.h"
+#include "otp.h"
+#include "functions.h"
+#include "otpdisplayplugin.h"
+#include "qtiostream.h"
+
+using nlohmann::json;
+
+namespace Qonvince
+{
+	namespace
+	{
+		constexpr const int ProbeTimeout = 250;
+		constexpr const qint64 MaxRequestSize = 64 * 1024;
+
+		// clients can ask for codes at most this many intervals (or counter steps) either side of the current one
+		constexpr const std::int64_t MaxWindow = 10;
+
+		json errorResponse(const char * message)
+		{
+			return {{"ok", false}, {"error", message}};
+		}
+
+		// the socket permissions already exclude other users; this also rejects anything that gets past them
+		bool peerIsCurrentUser(QLocalSocket * socket)
+		{
+#if defined(Q_OS_LINUX)
+			ucred credentials{};
+			socklen_t length = sizeof(credentials);
+
+			if(0 != getsockopt(static_cast<int>(socket->socketDescriptor()), SOL_SOCKET, SO_PEERCRED, &credentials, &length)) {
+				return false;
+			}
+
+			return getuid() == credentials.uid;
+#elif defined(Q_OS_UNIX)
+			uid_t uid;
+			gid_t gid;
+
+			if(0 != getpeereid(static_cast<int>(socket->socketDescriptor()), &uid, &gid)) {
+				return false;
+			}
+
+			return getuid() == uid;
+#else
+			Q_UNUSED(socket);
+			return true;
+#endif
+		}
+	}	// namespace
+
+	class CodeServer::Worker
+	: public QObject
+	{
+	public:
+		explicit Worker(const CodeServer & owner)
+		: m_owner(owner),
+		  m_server(nullptr)
+		{
+		}
+
+		bool listen(const QString & path)
+		{
+			{
+				QLocalSocket probe;
+				probe.connectToServer(path);
+
+				if(probe.waitForConnected(ProbeTimeout)) {
+					std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: another code server is already listening on \"" << path << "\"\n";
+					return false;
+				}
+			}
+
+			QLocalServer::removeServer(path);
+			m_server = new QLocalServer(this);
+			m_server->setSocketOptions(QLocalServer::UserAccessOption);
+
+			if(!m_server->listen(path)) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to listen on \"" << path << "\": " << m_server->errorString() << "\n";
+				return false;
+			}
+
+			connect(m_server, &QLocalServer::newConnection, this, [this]() {
+				onNewConnection();
+			});
+
+			return true;
+		}
+
+	private:
+		void onNewConnection()
+		{
+			while(auto * socket = m_server->nextPendingConnection()) {
+				if(!peerIsCurrentUser(socket)) {
+					std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: rejected connection from another user\n";
+					socket->abort();
+					socket->deleteLater();
+					continue;
+				}
+
+				connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+				connect(socket, &QLocalSocket::readyRead, socket, [this, socket]() {
+					readRequests(socket);
+				});
+			}
+		}
+
+		void readRequests(QLocalSocket * socket) const
+		{
+			while(socket->canReadLine()) {
+				const auto line = socket->readLine();
+				json response;
+
+				try {
+					response = handleRequest(json::parse(line.toStdString()));
+				} catch(const json::exception &) {
+					response = errorResponse("invalid request");
+				}
+
+				socket->write(QByteArray::fromStdString(response.dump()).append('\n'));
+			}
+
+			if(MaxRequestSize < socket->bytesAvailable()) {
+				socket->abort();
+			}
+		}
+
+		json handleRequest(const json & request) const
+		{
+			if(!request.is_object() || !request.contains("codes") || !request["codes"].is_array()) {
+				return errorResponse("invalid request");
+			}
+
+			const auto window = request.value("window", static_cast<std::int64_t>(0));
+
+			if(-MaxWindow > window || MaxWindow < window) {
+				return errorResponse("window out of range");
+			}
+
+			const auto snapshot = m_owner.snapshot();
+			const auto now = static_cast<std::int64_t>(Clock::current().secsSinceEpoch());
+			const auto & ids = request["codes"];
+			auto codes = json::object();
+
+			// the requested codes are all formatted together, with one call to each display plugin
+			CodeBatch batch;
+			batch.reserve(ids.size());
+			std::vector<std::pair<const std::string *, std::size_t>> batched;
+			batched.reserve(ids.size());
+
+			for(const auto & id : ids) {
+				const auto & idString = id.get_ref<const std::string &>();
+				const auto entry = snapshot->find(QString::fromStdString(idString));
+				codes[idString] = nullptr;
+
+				if(snapshot->cend() == entry) {
+					continue;
+				}
+
+				if(const auto counter = codeCounter(entry->second, now, window); counter) {
+					batched.emplace_back(&idString, batch.add(*entry->second.plugin, Otp::hotp(entry->second.seed, *counter)));
+				}
+			}
+
+			batch.write();
+
+			for(const auto & [id, index] : batched) {
+				if(const auto code = batch.code(index); !code.empty()) {
+					codes[*id] = std::string(code);
+				}
+			}
+
+			return {{"ok", true}, {"window", window}, {"codes", std::move(codes)}};
+		}
+
+		// the counter for an OTP's code, window intervals (or counter steps) from the current one
+		static std::optional<std::uint64_t> codeCounter(const Entry & entry, std::int64_t now, std::int64_t window)
+		{
+			std::int64_t counter;
+
+			if(OtpType::Hotp == entry.type) {
+				counter = static_cast<std::int64_t>(entry.counter) + window;
+			}
+			else {
+				counter = ((now - entry.baselineTime) / entry.interval) + window;
+			}
+
+			if(0 > counter) {
+				return {};
+			}
+
+			return static_cast<std::uint64_t>(counter);
+		}
+
+		const CodeServer & m_owner;
+		QLocalServer * m_server;
+	};
+
+	CodeServer::CodeServer(QObject * parent)
+	: QObject(parent),
+	  m_snapshot(std::make_shared<Snapshot>()),
+	  m_worker(nullptr)
+	{
+		// several OTPs often change together (e.g. when the settings are read) so the snapshot is rebuilt once
+		m_snapshotTimer.setSingleShot(true);
+		m_snapshotTimer.setInterval(0);
+		connect(&m_snapshotTimer, &QTimer::timeout, this, &CodeServer::updateSnapshot);
+	}
+
+	CodeServer::~CodeServer()
+	{
+		stop();
+	}
+
+	QString CodeServer::defaultSocketPath()
+	{
+		auto dir = QStandardPaths::writableLocation(QStandardPaths::RuntimeLocation);
+
+		if(dir.isEmpty()) {
+			dir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+		}
+
+		return dir + QStringLiteral("/qonvince-codes.sock");
+	}
+
+	bool CodeServer::start(const QString & path)
+	{
+		if(isRunning()) {
+			return true;
+		}
+
+		updateSnapshot();
+		connect(qonvinceApp, qOverload<Otp *>(&Application::otpAdded), this, &CodeServer::scheduleSnapshotUpdate);
+		connect(qonvinceApp, qOverload<Otp *>(&Application::otpChanged), this, &CodeServer::scheduleSnapshotUpdate);
+		connect(qonvinceApp, &Application::otpRemoved, this, &CodeServer::scheduleSnapshotUpdate);
+
+		m_worker = new Worker(*this);
+		m_worker->moveToThread(&m_thread);
+		connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+		m_thread.setObjectName(QStringLiteral("code server"));
+		m_thread.start();
+
+		bool listening = false;
+
+		QMetaObject::invokeMethod(m_worker, [this, &listening, &path]() {
+			listening = m_worker->listen(path);
+		}, Qt::BlockingQueuedConnection);
+
+		if(!listening) {
+			stop();
+		}
+
+		return listening;
+	}
+
+	void CodeServer::stop()
+	{
+		if(!isRunning()) {
+			return;
+		}
+
+		disconnect(qonvinceApp, nullptr, this, nullptr);
+		m_thread.quit();
+		m_thread.wait();
+		m_worker = nullptr;
+	}
+
+	void CodeServer::scheduleSnapshotUpdate()
+	{
+		m_snapshotTimer.start();
+	}
+
+	void CodeServer::updateSnapshot()
+	{
+		auto snapshot = std::make_shared<Snapshot>();
+		const auto count = qonvinceApp->otpCount();
+		snapshot->reserve(static_cast<Snapshot::size_type>(count));
+
+		for(int idx = 0; idx < count; ++idx) {
+			auto * otp = qonvinceApp->otp(idx);
+
+			// codes from any window are served without the user seeing them, so these are left out altogether
+			if(otp->revealCodeOnDemand()) {
+				continue;
+			}
+
+			const auto * plugin = otp->displayPlugin();
+			const auto seed = otp->seed();
+
+			if(!plugin || seed.isEmpty()) {
+				continue;
+			}
+
+			auto interval = otp->interval();
+
+			if(0 >= interval) {
+				interval = Otp::DefaultInterval;
+			}
+
+			snapshot->insert({otpIdentifier(otp), Entry{
+				SecureString(seed.constData(), static_cast<SecureString::size_type>(seed.size())),
+				otp->type(),
+				otp->baselineSecSinceEpoch(),
+				interval,
+				otp->counter(),
+				plugin,
+			}});
+		}
+
+		std::lock_guard<std::mutex> lock(m_snapshotLock);
+		m_snapshot = std::move(snapshot);
+	}
+
+	std::shared_ptr<const CodeServer::Snapshot> CodeServer::snapshot() const
+	{
+		std::lock_guard<std::mutex> lock(m_snapshotLock);
+		return m_snapshot;
+	}
+}	// namespace Qonvince
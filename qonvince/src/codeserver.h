@@ -0,0 +1,108 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_CODESERVER_H
+#define QONVINCE_CODESERVER_H
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+
+#include "types.h"
+#include "securestring.h"
+#include "qtstdhash.h"
+
+namespace LibQonvince
+{
+	class OtpDisplayPlugin;
+}
+
+namespace Qonvince
+{
+	using LibQonvince::SecureString;
+
+	/**
+	 * Serves batches of codes over a local socket for automation.
+	 *
+	 * This is opt-in (the --code-server command-line option). The socket accepts connections only from processes owned
+	 * by the same user, checked using the peer's credentials where the platform provides them. Each request is a line
+	 * of JSON such as {"codes":["issuer:name", ...], "window":1} and each response is a line of JSON with the codes
+	 * keyed by identifier (null for unknown identifiers). The window is the number of intervals (or, for HOTP, counter
+	 * steps) ahead of or behind the current code, up to 10 either way. OTPs whose codes are only revealed on demand are
+	 * never served, so their identifiers get null codes.
+	 *
+	 * Requests are answered on a dedicated thread from a snapshot of the OTPs, so the GUI thread is never blocked by
+	 * clients. The snapshot is rebuilt on the GUI thread whenever the OTPs change.
+	 */
+	class CodeServer
+	: public QObject
+	{
+		Q_OBJECT
+
+	public:
+		explicit CodeServer(QObject * parent = nullptr);
+		~CodeServer() override;
+
+		static QString defaultSocketPath();
+
+		bool start(const QString & path = defaultSocketPath());
+		void stop();
+
+		[[nodiscard]] inline bool isRunning() const
+		{
+			return m_thread.isRunning();
+		}
+
+	public Q_SLOTS:
+		void scheduleSnapshotUpdate();
+
+	private:
+		class Worker;
+
+		// everything needed to generate an OTP's codes without touching the Otp object
+		struct Entry
+		{
+			SecureString seed;
+			OtpType type;
+			qint64 baselineTime;
+			int interval;
+			quint64 counter;
+			const LibQonvince::OtpDisplayPlugin * plugin;
+		};
+
+		using Snapshot = std::unordered_map<QString, Entry>;
+
+		void updateSnapshot();
+
+		// the worker takes a reference to the current snapshot, so the lock is only held while the pointer is copied
+		std::shared_ptr<const Snapshot> snapshot() const;
+
+		mutable std::mutex m_snapshotLock;
+		std::shared_ptr<const Snapshot> m_snapshot;
+		QTimer m_snapshotTimer;
+		QThread m_thread;
+		Worker * m_worker;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_CODESERVER_H
@@ -0,0 +1,315 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file commandlineclient.cpp
+ * @brief Implementation of the CommandLineClient class.
+ */
+
+#include "commandlineclient.h"
+
+#include <cstring>
+#include <span>
+#include <iostream>
+#include <QFile>
+#include <QSettings>
+
+#if defined(Q_OS_UNIX)
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "otp.h"
+#include "functions.h"
+#include "instanceclient.h"
+#include "instanceserver.h"
+#include "base32.h"
+#include "securestring.h"
+
+namespace Qonvince
+{
+	namespace
+	{
+		void printUsage()
+		{
+			std::cerr << "usage: qonvince --list\n"
+						 << "       qonvince --code <issuer:name> [--passphrase-fd <fd>] [--plugin-path <path>]\n\n"
+						 << "The passphrase is read from standard input unless --passphrase-fd is given.\n";
+		}
+
+#if defined(Q_OS_UNIX)
+		// RAII guard that turns off terminal echo while the passphrase is typed
+		class EchoSuppressor final
+		{
+		public:
+			explicit EchoSuppressor(int fd)
+			: m_fd(fd),
+			  m_restore(false)
+			{
+				if(!isatty(m_fd) || 0 != tcgetattr(m_fd, &m_original)) {
+					return;
+				}
+
+				termios silent = m_original;
+				silent.c_lflag &= ~static_cast<tcflag_t>(ECHO);
+				m_restore = (0 == tcsetattr(m_fd, TCSAFLUSH, &silent));
+				std::cerr << "Passphrase: " << std::flush;
+			}
+
+			~EchoSuppressor()
+			{
+				if(m_restore) {
+					tcsetattr(m_fd, TCSAFLUSH, &m_original);
+					std::cerr << "\n";
+				}
+			}
+
+			EchoSuppressor(const EchoSuppressor &) = delete;
+			EchoSuppressor(EchoSuppressor &&) = delete;
+			void operator=(const EchoSuppressor &) = delete;
+			void operator=(EchoSuppressor &&) = delete;
+
+		private:
+			int m_fd;
+			bool m_restore;
+			termios m_original{};
+		};
+#endif
+	}	// namespace
+
+	CommandLineClient::CommandLineClient(QStringList args)
+	: m_args(std::move(args)),
+	  m_passphraseFd(0),
+	  m_displayPluginFactory(".displayplugin")
+	{
+		Application::setApplicationIdentity();
+		Application::addBuiltInDisplayPlugins(m_displayPluginFactory);
+		Application::addDisplayPluginSearchPaths(m_displayPluginFactory);
+	}
+
+	bool CommandLineClient::isRequested(int argc, char ** argv)
+	{
+		for(int idx = 1; idx < argc; ++idx) {
+			if(0 == std::strcmp("--code", argv[idx]) || 0 == std::strcmp("--list", argv[idx])) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	int CommandLineClient::exec()
+	{
+		bool list = false;
+
+		for(int idx = 1, argCount = m_args.size(); idx < argCount; ++idx) {
+			const QString & arg = m_args[idx];
+
+			if(QStringLiteral("--list") == arg) {
+				list = true;
+				continue;
+			}
+
+			if(QStringLiteral("--code") != arg && QStringLiteral("--passphrase-fd") != arg && QStringLiteral("--plugin-path") != arg) {
+				std::cerr << "unrecognised argument \"" << qPrintable(arg) << "\"\n";
+				printUsage();
+				return UsageError;
+			}
+
+			++idx;
+
+			if(argCount <= idx) {
+				std::cerr << "missing argument for " << qPrintable(arg) << " option\n";
+				printUsage();
+				return UsageError;
+			}
+
+			if(QStringLiteral("--code") == arg) {
+				m_otpId = m_args[idx];
+			}
+			else if(QStringLiteral("--plugin-path") == arg) {
+				m_displayPluginFactory.addSearchPath(m_args[idx].toStdString());
+			}
+			else {
+				bool ok;
+				m_passphraseFd = m_args[idx].toInt(&ok);
+
+				if(!ok || 0 > m_passphraseFd) {
+					std::cerr << "invalid file descriptor \"" << qPrintable(m_args[idx]) << "\"\n";
+					return UsageError;
+				}
+			}
+		}
+
+		if(list == !m_otpId.isEmpty()) {
+			printUsage();
+			return UsageError;
+		}
+
+		if(list) {
+			return listOtps();
+		}
+
+		return printCode();
+	}
+
+	std::optional<QCA::SecureArray> CommandLineClient::readPassphrase() const
+	{
+		QFile in;
+
+		if(!in.open(m_passphraseFd, QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+			std::cerr << "failed to open file descriptor " << m_passphraseFd << " to read the passphrase\n";
+			return {};
+		}
+
+		QCA::SecureArray passphrase;
+
+		{
+#if defined(Q_OS_UNIX)
+			EchoSuppressor echoSuppressor(m_passphraseFd);
+#endif
+			passphrase = in.readLine();
+		}
+
+		auto length = passphrase.size();
+
+		while(0 < length && ('\n' == passphrase[length - 1] || '\r' == passphrase[length - 1])) {
+			--length;
+		}
+
+		passphrase.resize(length);
+
+		if(passphrase.isEmpty()) {
+			std::cerr << "no passphrase provided\n";
+			return {};
+		}
+
+		return passphrase;
+	}
+
+	int CommandLineClient::listOtps() const
+	{
+		// issuers and names are not encrypted, so no passphrase is required to list them
+		QSettings settings;
+		settings.beginGroup(QStringLiteral("codes"));
+		const int count = settings.value(QStringLiteral("code_count"), 0).toInt();
+
+		for(int idx = 0; idx < count; ++idx) {
+			settings.beginGroup(QStringLiteral("code-%1").arg(idx));
+			std::cout << qPrintable(otpIdentifier(settings.value(QStringLiteral("issuer")).toString(), settings.value(QStringLiteral("name")).toString())) << "\n";
+			settings.endGroup();
+		}
+
+		return Success;
+	}
+
+	int CommandLineClient::printCode()
+	{
+		// a running instance has already been unlocked, so ask it rather than asking for the passphrase
+		if(const auto response = InstanceClient::send({{"request", InstanceServer::CodeRequest}, {"otp", m_otpId.toStdString()}}); response) {
+			if(!response->value("ok", false)) {
+				if(InstanceServer::CodeHiddenError == response->value("error", std::string())) {
+					std::cerr << "the code for \"" << qPrintable(m_otpId) << "\" is only revealed on demand\n";
+					return CodeHidden;
+				}
+
+				std::cerr << "no OTP named \"" << qPrintable(m_otpId) << "\"\n";
+				return NotFound;
+			}
+
+			std::cout << response->value("code", std::string()) << "\n";
+			return Success;
+		}
+
+		const auto passphrase = readPassphrase();
+
+		if(!passphrase || !Application::checkSettingsPassphrase(*passphrase)) {
+			std::cerr << "the passphrase is not correct\n";
+			return IncorrectPassphrase;
+		}
+
+		QSettings settings;
+		settings.beginGroup(QStringLiteral("codes"));
+		const int count = settings.value(QStringLiteral("code_count"), 0).toInt();
+
+		for(int idx = 0; idx < count; ++idx) {
+			settings.beginGroup(QStringLiteral("code-%1").arg(idx));
+
+			if(m_otpId != otpIdentifier(settings.value(QStringLiteral("issuer")).toString(), settings.value(QStringLiteral("name")).toString())) {
+				settings.endGroup();
+				continue;
+			}
+
+			// only the seed for the requested OTP is ever decrypted, and it is decoded straight into secure storage
+			const auto encodedSeed = Otp::decryptSeed(settings, *passphrase);
+
+			if(!encodedSeed) {
+				std::cerr << "the seed for \"" << qPrintable(m_otpId) << "\" could not be decrypted\n";
+				return IncorrectPassphrase;
+			}
+
+			// the same policy as Otp::setSeed(), so any seed the application accepts works here too
+			constexpr const auto normalise = LibQonvince::Base32Codec::Normalise::Lenient;
+			const auto in = std::span<const char>(encodedSeed->constData(), static_cast<std::size_t>(encodedSeed->size()));
+			SecureString key;
+
+			if(const auto size = LibQonvince::Base32Codec::decodedSize(in, normalise); size) {
+				key.resize(*size);
+
+				if(!LibQonvince::Base32Codec::decode(in, std::span<char>(key.data(), key.size()), normalise)) {
+					key.clear();
+				}
+			}
+
+			if(key.empty()) {
+				std::cerr << "the seed for \"" << qPrintable(m_otpId) << "\" is not valid Base32\n";
+				return InvalidSeed;
+			}
+
+			const auto pluginName = Otp::displayPluginNameFromSettings(settings);
+			auto * plugin = m_displayPluginFactory.pluginByName(pluginName.toStdString());
+
+			if(!plugin) {
+				std::cerr << "display plugin \"" << qPrintable(pluginName) << "\" not found\n";
+				return NotFound;
+			}
+
+			SecureString code;
+
+			if(QStringLiteral("HOTP") == settings.value(QStringLiteral("type"), QStringLiteral("TOTP")).toString()) {
+				code = plugin->codeDisplayString(Otp::hotp(key, settings.value(QStringLiteral("counter"), 0).toULongLong()));
+			}
+			else {
+				auto interval = settings.value(QStringLiteral("interval"), 0).toInt();
+
+				if(0 >= interval) {
+					interval = Otp::DefaultInterval;
+				}
+
+				code = plugin->codeDisplayString(Otp::totp(key, settings.value(QStringLiteral("baseline_time"), 0).toLongLong(), interval));
+			}
+
+			std::cout << code << "\n";
+			return Success;
+		}
+
+		std::cerr << "no OTP named \"" << qPrintable(m_otpId) << "\"\n";
+		return NotFound;
+	}
+}	// namespace Qonvince
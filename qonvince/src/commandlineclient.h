@@ -0,0 +1,78 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_COMMANDLINECLIENT_H
+#define QONVINCE_COMMANDLINECLIENT_H
+
+#include <optional>
+#include <QString>
+#include <QStringList>
+#include <QtCrypto>
+
+#include "application.h"
+
+namespace Qonvince
+{
+	/**
+	 * Headless access to the stored OTPs for scripts.
+	 *
+	 * Handles the --code and --list command-line options. Only a QCoreApplication is required: no plugins are loaded
+	 * until a code is actually generated, no widgets are created and only the seed of the requested OTP is decrypted. If
+	 * Qonvince is already running the code is fetched from it instead, without asking for the passphrase.
+	 */
+	class CommandLineClient final
+	{
+	public:
+		// exit codes
+		static constexpr const int Success = 0;
+		static constexpr const int NotFound = 1;
+		static constexpr const int IncorrectPassphrase = 2;
+		static constexpr const int UsageError = 3;
+		static constexpr const int InvalidSeed = 4;
+		static constexpr const int CodeHidden = 5;
+
+		explicit CommandLineClient(QStringList args);
+		CommandLineClient(const CommandLineClient &) = delete;
+		CommandLineClient(CommandLineClient &&) = delete;
+		void operator=(const CommandLineClient &) = delete;
+		void operator=(CommandLineClient &&) = delete;
+
+		/**
+		 * Check whether the raw command-line requests headless operation.
+		 *
+		 * This is called before any Qt application object exists so that main() can decide which to create.
+		 */
+		static bool isRequested(int argc, char ** argv);
+
+		int exec();
+
+	private:
+		int listOtps() const;
+		int printCode();
+		std::optional<QCA::SecureArray> readPassphrase() const;
+
+		QCA::Initializer m_qcaInitializer;
+		QStringList m_args;
+		QString m_otpId;
+		int m_passphraseFd;
+		Application::DisplayPluginFactory m_displayPluginFactory;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_COMMANDLINECLIENT_H
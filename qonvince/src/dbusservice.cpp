@@ -0,0 +1,158 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file dbusservice.cpp
+ * @brief Implementation of the DBusService class.
+ */
+
+#include "dbusservice.h"
+
+#include <iostream>
+#include <QHash>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusError>
+
+#include "application.h"
+#include "otp.h"
+#include "functions.h"
+#include "qtiostream.h"
+
+namespace Qonvince
+{
+	namespace
+	{
+		// codes that are only revealed on demand are kept off the bus unless the user has revealed them
+		bool codeIsAvailable(const Otp * otp)
+		{
+			return otp->codeIsVisible();
+		}
+
+		QString codeString(Otp * otp)
+		{
+			const auto & code = otp->code();
+			return QString::fromUtf8(code.data(), static_cast<int>(code.size()));
+		}
+	}	// namespace
+
+	DBusService::DBusService(QObject * parent)
+	: QObject(parent)
+	{
+		for(int idx = 0; idx < qonvinceApp->otpCount(); ++idx) {
+			watchOtp(qonvinceApp->otp(idx));
+		}
+
+		connect(qonvinceApp, qOverload<Otp *>(&Application::otpAdded), this, &DBusService::watchOtp);
+	}
+
+	DBusService::~DBusService()
+	{
+		auto bus = QDBusConnection::sessionBus();
+		bus.unregisterObject(QString::fromLatin1(ObjectPath));
+		bus.unregisterService(QString::fromLatin1(ServiceName));
+	}
+
+	bool DBusService::registerService()
+	{
+		auto bus = QDBusConnection::sessionBus();
+
+		if(!bus.isConnected()) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: no session bus: " << bus.lastError().message() << "\n";
+			return false;
+		}
+
+		if(!bus.registerObject(QString::fromLatin1(ObjectPath), this, QDBusConnection::ExportScriptableSlots | QDBusConnection::ExportScriptableSignals)) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to register object: " << bus.lastError().message() << "\n";
+			return false;
+		}
+
+		if(!bus.registerService(QString::fromLatin1(ServiceName))) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to register service: " << bus.lastError().message() << "\n";
+			bus.unregisterObject(QString::fromLatin1(ObjectPath));
+			return false;
+		}
+
+		return true;
+	}
+
+	QString DBusService::GetCode(const QString & id)
+	{
+		auto * otp = qonvinceApp->otpByIdentifier(id);
+
+		if(!otp) {
+			sendErrorReply(QDBusError::InvalidArgs, QStringLiteral("No OTP named \"%1\"").arg(id));
+			return {};
+		}
+
+		if(!codeIsAvailable(otp)) {
+			sendErrorReply(QDBusError::AccessDenied, QStringLiteral("The code for \"%1\" is only revealed on demand").arg(id));
+			return {};
+		}
+
+		return codeString(otp);
+	}
+
+	QStringList DBusService::ListOtps() const
+	{
+		QStringList ids;
+		const auto count = qonvinceApp->otpCount();
+		ids.reserve(count);
+
+		for(int idx = 0; idx < count; ++idx) {
+			ids.append(otpIdentifier(qonvinceApp->otp(idx)));
+		}
+
+		return ids;
+	}
+
+	QStringList DBusService::GetCodes(const QStringList & ids) const
+	{
+		// index the OTPs once rather than searching the list for every requested id
+		QHash<QString, Otp *> otps;
+		const auto count = qonvinceApp->otpCount();
+		otps.reserve(count);
+
+		for(int idx = 0; idx < count; ++idx) {
+			auto * otp = qonvinceApp->otp(idx);
+			otps.insert(otpIdentifier(otp), otp);
+		}
+
+		QStringList codes;
+		codes.reserve(ids.size());
+
+		for(const auto & id : ids) {
+			auto * otp = otps.value(id, nullptr);
+			codes.append(otp && codeIsAvailable(otp) ? codeString(otp) : QString());
+		}
+
+		return codes;
+	}
+
+	void DBusService::watchOtp(Otp * otp)
+	{
+		connect(otp, &Otp::newCodeGenerated, this, [this, otp](const QString & code) {
+			// signals are broadcast to every client on the bus
+			if(!codeIsAvailable(otp)) {
+				return;
+			}
+
+			Q_EMIT CodeChanged(otpIdentifier(otp), code);
+		});
+	}
+}	// namespace Qonvince
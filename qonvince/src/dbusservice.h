@@ -0,0 +1,75 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_DBUSSERVICE_H
+#define QONVINCE_DBUSSERVICE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QtDBus/QDBusContext>
+
+namespace Qonvince
+{
+	class Otp;
+
+	/**
+	 * Exposes the current codes on the session bus.
+	 *
+	 * This is opt-in (the --dbus-service command-line option). The service is registered as dev.equit.Qonvince once the
+	 * settings have been unlocked. Calls are answered from the codes each Otp has already generated, so nothing is
+	 * computed on demand and no widgets are involved. OTPs are identified as they are on the command-line (see
+	 * otpIdentifier()).
+	 *
+	 * The codes of OTPs that are only revealed on demand are provided only while the user has revealed them. Until then
+	 * GetCode() fails, GetCodes() gives them empty codes and CodeChanged is not emitted for them.
+	 */
+	class DBusService
+	: public QObject,
+	  protected QDBusContext
+	{
+		Q_OBJECT
+		Q_CLASSINFO("D-Bus Interface", "dev.equit.Qonvince.Codes")
+
+	public:
+		static constexpr const char * ServiceName = "dev.equit.Qonvince";
+		static constexpr const char * ObjectPath = "/dev/equit/Qonvince";
+
+		explicit DBusService(QObject * parent = nullptr);
+		~DBusService() override;
+
+		bool registerService();
+
+	public Q_SLOTS:
+		Q_SCRIPTABLE QString GetCode(const QString & id);
+		Q_SCRIPTABLE QStringList ListOtps() const;
+
+		// the codes are in the same order as the ids; any id that doesn't identify an OTP, or whose code is hidden, gets an
+		// empty code
+		Q_SCRIPTABLE QStringList GetCodes(const QStringList & ids) const;
+
+	Q_SIGNALS:
+		Q_SCRIPTABLE void CodeChanged(const QString & id, const QString & code);
+
+	private:
+		void watchOtp(Otp * otp);
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_DBUSSERVICE_H
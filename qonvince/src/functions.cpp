@@ -51,4 +51,18 @@ namespace Qonvince
 
 		return QLatin1String("");
 	}
+
+	QString otpIdentifier(const QString & issuer, const QString & name)
+	{
+		if(issuer.isEmpty()) {
+			return name;
+		}
+
+		return issuer % QLatin1Char(':') % name;
+	}
+
+	QString otpIdentifier(Otp * otp)
+	{
+		return otpIdentifier(otp->issuer(), otp->name());
+	}
 }	// namespace Qonvince
@@ -26,6 +26,11 @@ namespace Qonvince
 	class Otp;
 
 	QString otpLabel(Otp * otp);
+
+	// the identifier used to refer to an Otp from outside the GUI (e.g. the command line): "issuer:name", or just
+	// "name" if the Otp has no issuer. unlike otpLabel() this does not depend on the user's display settings
+	QString otpIdentifier(const QString & issuer, const QString & name);
+	QString otpIdentifier(Otp * otp);
 }	// namespace Qonvince
 
 #endif  // QONVINCE_FUNCTIONS_H
@@ -0,0 +1,359 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file iconstore.cpp
+ * @brief Implementation of the IconStore class.
+ */
+
+#include "iconstore.h"
+
+#include <algorithm>
+#include <iostream>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QPixmap>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringBuilder>
+
+#include "application.h"
+#include "qtiostream.h"
+
+namespace Qonvince
+{
+	namespace
+	{
+		QString iconDirectory()
+		{
+			return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) % QStringLiteral("/codes/icons");
+		}
+
+		// the image scaled to each of the rendition extents below its own size, then the image itself at the next one up
+		std::vector<std::pair<int, QImage>> renditionsOf(const QImage & image)
+		{
+			const auto sourceExtent = std::max(image.width(), image.height());
+			std::vector<std::pair<int, QImage>> renditions;
+
+			for(const auto extent : IconStore::RenditionExtents) {
+				if(extent >= sourceExtent) {
+					renditions.emplace_back(extent, image);
+					break;
+				}
+
+				renditions.emplace_back(extent, image.scaled(extent, extent, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+			}
+
+			return renditions;
+		}
+
+		QIcon iconFrom(const std::vector<QImage> & renditions)
+		{
+			QIcon icon;
+
+			for(const auto & rendition : renditions) {
+				icon.addPixmap(QPixmap::fromImage(rendition));
+			}
+
+			return icon;
+		}
+	}	// namespace
+
+	IconStore::IconStore(QObject * parent)
+	: QObject(parent),
+	  m_worker(new QObject()),
+	  m_hasUnreferencedFiles(false)
+	{
+		m_worker->moveToThread(&m_thread);
+		connect(&m_thread, &QThread::finished, m_worker, &QObject::deleteLater);
+		m_thread.setObjectName(QStringLiteral("icon store"));
+		m_thread.start();
+	}
+
+	IconStore::~IconStore()
+	{
+		// the thread discards anything still queued when it stops, which could lose an icon that was just chosen
+		waitForPendingWork();
+		m_thread.quit();
+		m_thread.wait();
+	}
+
+	void IconStore::waitForPendingWork()
+	{
+		QMetaObject::invokeMethod(m_worker, []() {}, Qt::BlockingQueuedConnection);
+	}
+
+	QString IconStore::keyFor(const QImage & image)
+	{
+		const auto pixels = image.convertToFormat(QImage::Format_ARGB32);
+		const std::array<qint32, 2> size = {pixels.width(), pixels.height()};
+		QCryptographicHash hash(QCryptographicHash::Sha256);
+		hash.addData(reinterpret_cast<const char *>(size.data()), static_cast<int>(sizeof(size)));
+
+		// row by row so that any padding at the end of the scan lines doesn't contribute
+		for(int y = 0; y < pixels.height(); ++y) {
+			hash.addData(reinterpret_cast<const char *>(pixels.constScanLine(y)), pixels.width() * 4);
+		}
+
+		return QString::fromLatin1(hash.result().toHex());
+	}
+
+	QString IconStore::renditionFileName(const QString & key, int extent)
+	{
+		return key % QLatin1Char('-') % QString::number(extent) % QStringLiteral(".png");
+	}
+
+	bool IconStore::writeRenditions(const QString & key, const QImage & image)
+	{
+		if(!Application::ensureDataDirectory(QStringLiteral("codes/icons"))) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: the data directory \"" << iconDirectory()
+						 << "\" does not exist and could not be created\n";
+			return false;
+		}
+
+		const auto directory = iconDirectory();
+		bool ok = true;
+
+		for(const auto & [extent, rendition] : renditionsOf(image)) {
+			const auto path = directory % QLatin1Char('/') % renditionFileName(key, extent);
+
+			// the name comes from the content, so an existing file already holds this rendition
+			if(QFile::exists(path)) {
+				continue;
+			}
+
+			QSaveFile file(path);
+
+			if(!file.open(QIODevice::WriteOnly) || !rendition.save(&file, "PNG") || !file.commit()) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to save icon to \"" << path << "\"\n";
+				ok = false;
+			}
+		}
+
+		return ok;
+	}
+
+	QString IconStore::add(const QIcon & icon)
+	{
+		if(icon.isNull()) {
+			return {};
+		}
+
+		auto image = icon.pixmap(RenditionExtents.back()).toImage();
+
+		if(image.isNull()) {
+			return {};
+		}
+
+		image.setDevicePixelRatio(1.0);
+		const auto key = keyFor(image);
+		auto & entry = m_icons[key];
+		++entry.references;
+
+		if(entry.icon.isNull()) {
+			entry.icon = QIcon(QPixmap::fromImage(image));
+
+			QMetaObject::invokeMethod(m_worker, [key, image]() {
+				writeRenditions(key, image);
+			}, Qt::QueuedConnection);
+		}
+
+		return key;
+	}
+
+	void IconStore::acquire(const QString & key, QObject * context, AcquireCallback callback)
+	{
+		auto & entry = m_icons[key];
+		++entry.references;
+
+		if(!entry.icon.isNull()) {
+			callback(key, entry.icon);
+			return;
+		}
+
+		entry.waiters.push_back({context, std::move(callback)});
+
+		if(entry.reading) {
+			return;
+		}
+
+		entry.reading = true;
+
+		// the store outlives the worker thread, so the result can always be posted back to it
+		QMetaObject::invokeMethod(m_worker, [this, key]() {
+			const auto [storedKey, renditions] = readRenditions(key);
+
+			QMetaObject::invokeMethod(this, [this, key, storedKey = storedKey, renditions = renditions]() {
+				finishRead(key, storedKey, renditions);
+			}, Qt::QueuedConnection);
+		}, Qt::QueuedConnection);
+	}
+
+	void IconStore::finishRead(const QString & key, const QString & storedKey, const std::vector<QImage> & renditions)
+	{
+		const auto it = m_icons.find(key);
+
+		if(m_icons.end() == it) {
+			// every reference was released while the icon was being read
+			return;
+		}
+
+		const auto waiters = std::move(it->second.waiters);
+		it->second.waiters.clear();
+		it->second.reading = false;
+		auto * entry = &(it->second);
+
+		if(storedKey != key) {
+			// an old icon file was moved to its content key, so the references move with it
+			const auto references = entry->references;
+			m_icons.erase(it);
+			entry = &m_icons[storedKey];
+			entry->references += references;
+			m_hasUnreferencedFiles = true;
+		}
+
+		// an icon with the same content may have been added or read in the meantime, in which case that one is shared
+		if(entry->icon.isNull()) {
+			entry->icon = iconFrom(renditions);
+		}
+
+		const auto icon = entry->icon;
+
+		for(const auto & waiter : waiters) {
+			if(waiter.context) {
+				waiter.callback(storedKey, icon);
+			}
+		}
+	}
+
+	QIcon IconStore::icon(const QString & key) const
+	{
+		const auto entry = m_icons.find(key);
+		return (m_icons.cend() == entry ? QIcon() : entry->second.icon);
+	}
+
+	void IconStore::release(const QString & key)
+	{
+		const auto entry = m_icons.find(key);
+
+		if(m_icons.end() == entry) {
+			return;
+		}
+
+		if(0 < --entry->second.references) {
+			return;
+		}
+
+		// the decoded pixmaps go now, but the files stay until the settings no longer name them
+		m_icons.erase(entry);
+		m_hasUnreferencedFiles = true;
+	}
+
+	void IconStore::removeUnreferenced()
+	{
+		if(!m_hasUnreferencedFiles) {
+			return;
+		}
+
+		m_hasUnreferencedFiles = false;
+		QSet<QString> keys;
+		keys.reserve(static_cast<int>(m_icons.size()));
+
+		for(const auto & icon : m_icons) {
+			keys.insert(icon.first);
+		}
+
+		QMetaObject::invokeMethod(m_worker, [keys]() {
+			removeFilesExcept(keys);
+		}, Qt::QueuedConnection);
+	}
+
+	std::pair<QString, std::vector<QImage>> IconStore::readRenditions(const QString & key)
+	{
+		std::vector<QImage> renditions;
+
+		for(const auto extent : RenditionExtents) {
+			const auto path = QStandardPaths::locate(QStandardPaths::AppLocalDataLocation, QStringLiteral("codes/icons/") % renditionFileName(key, extent));
+
+			if(path.isEmpty()) {
+				continue;
+			}
+
+			QImage rendition;
+
+			if(!rendition.load(path)) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to read icon file \"" << path << "\"\n";
+				continue;
+			}
+
+			renditions.push_back(std::move(rendition));
+		}
+
+		if(!renditions.empty()) {
+			return {key, std::move(renditions)};
+		}
+
+		// earlier versions stored a single 64px file, named with a random hash
+		const auto path = QStandardPaths::locate(QStandardPaths::AppLocalDataLocation, QStringLiteral("codes/icons/") % key);
+
+		if(path.isEmpty()) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: icon \"" << key << "\" not found\n";
+			return {key, {}};
+		}
+
+		QImage image;
+
+		if(!image.load(path)) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to read icon file \"" << path << "\"\n";
+			return {key, {}};
+		}
+
+		const auto storedKey = keyFor(image);
+
+		if(!writeRenditions(storedKey, image)) {
+			// keep using the old file
+			return {key, {image}};
+		}
+
+		for(auto & rendition : renditionsOf(image)) {
+			renditions.push_back(std::move(rendition.second));
+		}
+
+		return {storedKey, std::move(renditions)};
+	}
+
+	void IconStore::removeFilesExcept(const QSet<QString> & keys)
+	{
+		QDir directory(iconDirectory());
+
+		for(const auto & fileName : directory.entryList(QDir::Files)) {
+			// renditions are named <key>-<extent>.png; files from earlier versions are named with just the key
+			const auto separator = fileName.indexOf(QLatin1Char('-'));
+
+			if(keys.contains(-1 == separator ? fileName : fileName.left(separator))) {
+				continue;
+			}
+
+			if(!directory.remove(fileName)) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to remove icon file \"" << directory.filePath(fileName) << "\"\n";
+			}
+		}
+	}
+}	// namespace Qonvince
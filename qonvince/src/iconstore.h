@@ -0,0 +1,132 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_ICONSTORE_H
+#define QONVINCE_ICONSTORE_H
+
+#include <array>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <QIcon>
+#include <QImage>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QThread>
+
+#include "qtstdhash.h"
+
+namespace Qonvince
+{
+	/**
+	 * Shares the OTP icons and keeps their files.
+	 *
+	 * Icons are content-addressed: the key for an icon is a hash of its pixels, so OTPs that use the same image share one
+	 * set of files and one QIcon, and so one set of decoded pixmaps for each size and pixel ratio that is painted. Each
+	 * icon is stored as PNG renditions of several sizes in the codes/icons directory of the application's data location,
+	 * named <key>-<extent>.png. Decoding, encoding and file access all happen on a dedicated thread, in the order they
+	 * were requested, so the GUI thread never waits for them.
+	 *
+	 * Each OTP holds a reference to the key of its icon. The files for an icon that nothing refers to any more are only
+	 * deleted by removeUnreferenced(), which must not be called until the settings that named the icon have been
+	 * rewritten. Icon files from earlier versions, named with a random hash, are moved to their content key the first
+	 * time they are read.
+	 *
+	 * The store must be used from the thread that created it.
+	 */
+	class IconStore
+	: public QObject
+	{
+		Q_OBJECT
+
+	public:
+		// called with the key the icon is now stored under and the shared icon, which is null if it couldn't be read
+		using AcquireCallback = std::function<void(const QString &, const QIcon &)>;
+
+		// the sizes at which icons are stored; new icons are rendered at the largest
+		static constexpr const std::array<int, 4> RenditionExtents = {32, 64, 128, 256};
+
+		explicit IconStore(QObject * parent = nullptr);
+
+		// waits for any outstanding writes to finish
+		~IconStore() override;
+
+		// identical images always have the same key, whatever their format
+		static QString keyFor(const QImage & image);
+
+		// the name of one of an icon's files in the codes/icons directory
+		static QString renditionFileName(const QString & key, int extent);
+
+		// write whichever renditions of an image are not already stored under the key. no rendition is larger than the
+		// image itself
+		static bool writeRenditions(const QString & key, const QImage & image);
+
+		// store an icon and take a reference to it. returns the key, or an empty string if the icon is null
+		QString add(const QIcon & icon);
+
+		// take a reference to a stored icon. the callback is called on this store's thread once the icon has been read,
+		// which is immediately if it's already in use, unless the context object has been destroyed by then
+		void acquire(const QString & key, QObject * context, AcquireCallback callback);
+
+		// the shared icon for a key, or a null icon if it isn't in use or hasn't been read yet
+		QIcon icon(const QString & key) const;
+
+		void release(const QString & key);
+
+		// delete the files of the icons that have lost all their references
+		void removeUnreferenced();
+
+		// block until everything requested so far has been done
+		void waitForPendingWork();
+
+	private:
+		struct Waiter
+		{
+			QPointer<QObject> context;
+			AcquireCallback callback;
+		};
+
+		struct Entry
+		{
+			QIcon icon;
+			int references = 0;
+			bool reading = false;
+			std::vector<Waiter> waiters;
+		};
+
+		void finishRead(const QString & key, const QString & storedKey, const std::vector<QImage> & renditions);
+
+		// these run on the worker thread
+		static std::pair<QString, std::vector<QImage>> readRenditions(const QString & key);
+		static void removeFilesExcept(const QSet<QString> & keys);
+
+		QThread m_thread;
+		QObject * m_worker;
+
+		std::unordered_map<QString, Entry> m_icons;
+
+		// set when an icon loses its last reference or an old icon file is moved
+		bool m_hasUnreferencedFiles;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_ICONSTORE_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file instanceclient.cpp
+ * @brief Implementation of the InstanceClient class.
+ */
+
+#include "instanceclient.h"
+
+#include <iostream>
+#include <QLocalSocket>
+
+#include "instanceserver.h"
+
+using nlohmann::json;
+
+namespace Qonvince
+{
+	std::optional<json> InstanceClient::send(const json & request, int timeout)
+	{
+		QLocalSocket socket;
+		socket.connectToServer(InstanceServer::serverName());
+
+		// fails immediately when nothing is listening, so this doesn't delay a normal start-up
+		if(!socket.waitForConnected(timeout)) {
+			return {};
+		}
+
+		socket.write(QByteArray::fromStdString(request.dump()).append('\n'));
+
+		if(!socket.waitForBytesWritten(timeout)) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to send request to running instance\n";
+			return {};
+		}
+
+		while(!socket.canReadLine()) {
+			if(!socket.waitForReadyRead(timeout)) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: no response from running instance\n";
+				return {};
+			}
+		}
+
+		try {
+			return json::parse(socket.readLine().toStdString());
+		} catch(const json::exception & err) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: invalid response from running instance: " << err.what() << "\n";
+		}
+
+		return {};
+	}
+}	// namespace Qonvince
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_INSTANCECLIENT_H
+#define QONVINCE_INSTANCECLIENT_H
+
+#include <optional>
+#include <nlohmann/json.hpp>
+
+namespace Qonvince
+{
+	/**
+	 * Sends a request to the InstanceServer of an already-running instance.
+	 *
+	 * The calls block, so they can be used before the event loop is running. Only a QCoreApplication (with the
+	 * application identity set) is required.
+	 */
+	class InstanceClient final
+	{
+	public:
+		// importing a QR code can involve running an external decoder, so allow a generous time for the response
+		static constexpr const int DefaultTimeout = 10000;
+
+		/**
+		 * Send a request and wait for the response.
+		 *
+		 * An empty optional means there is no running instance to handle the request (or it did not respond), in
+		 * which case the caller should handle the request itself.
+		 */
+		static std::optional<nlohmann::json> send(const nlohmann::json & request, int timeout = DefaultTimeout);
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_INSTANCECLIENT_H
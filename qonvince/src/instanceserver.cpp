@@ -0,0 +1,182 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file instanceserver.cpp
+ * @brief Implementation of the InstanceServer class.
+ */
+
+#include "instanceserver.h"
+
+#include <iostream>
+#include <QLocalSocket>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+
+#include "application.h"
+#include "otp.h"
+#include "qtiostream.h"
+
+using nlohmann::json;
+
+namespace Qonvince
+{
+	namespace
+	{
+		// how long to wait when checking whether another instance is already serving
+		constexpr const int ProbeTimeout = 250;
+
+		// clients that send more than this without a newline are dropped
+		constexpr const qint64 MaxRequestSize = 64 * 1024;
+
+		json errorResponse(const char * message)
+		{
+			return {{"ok", false}, {"error", message}};
+		}
+	}	// namespace
+
+	InstanceServer::InstanceServer(QObject * parent)
+	: QObject(parent)
+	{
+		connect(&m_server, &QLocalServer::newConnection, this, &InstanceServer::onNewConnection);
+	}
+
+	InstanceServer::~InstanceServer() = default;
+
+	QString InstanceServer::serverName()
+	{
+		const auto key = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation).toUtf8();
+		return QStringLiteral("qonvince-") + QString::fromLatin1(QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex());
+	}
+
+	bool InstanceServer::listen()
+	{
+		if(m_server.isListening()) {
+			return true;
+		}
+
+		const auto name = serverName();
+
+		{
+			QLocalSocket probe;
+			probe.connectToServer(name);
+
+			if(probe.waitForConnected(ProbeTimeout)) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: another instance is already accepting requests\n";
+				return false;
+			}
+		}
+
+		// nothing is accepting connections, so any existing socket is left over from an instance that didn't exit cleanly
+		QLocalServer::removeServer(name);
+		m_server.setSocketOptions(QLocalServer::UserAccessOption);
+
+		if(!m_server.listen(name)) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to listen on \"" << name << "\": " << m_server.errorString() << "\n";
+			return false;
+		}
+
+		return true;
+	}
+
+	json InstanceServer::handleRequest(const json & request)
+	{
+		if(!request.is_object()) {
+			return errorResponse("invalid request");
+		}
+
+		const auto type = request.value("request", std::string());
+
+		if(ShowRequest == type) {
+			qonvinceApp->showMainWindow();
+			return {{"ok", true}};
+		}
+
+		if(ImportRequest == type) {
+			const auto fileName = QString::fromStdString(request.value("file", std::string()));
+
+			if(fileName.isEmpty()) {
+				return errorResponse("no file specified");
+			}
+
+			if(!qonvinceApp->readQrCodeFrom(fileName)) {
+				return errorResponse("the file could not be read as a QR code");
+			}
+
+			return {{"ok", true}};
+		}
+
+		if(CopyRequest == type || CodeRequest == type) {
+			auto * otp = qonvinceApp->otpByIdentifier(QString::fromStdString(request.value("otp", std::string())));
+
+			if(!otp) {
+				return errorResponse("OTP not found");
+			}
+
+			// any of the user's processes can connect, so codes that are only revealed on demand stay hidden
+			if(!otp->codeIsVisible()) {
+				return errorResponse(CodeHiddenError);
+			}
+
+			if(CopyRequest == type) {
+				qonvinceApp->copyOtpToClipboard(otp);
+				return {{"ok", true}};
+			}
+
+			const auto & code = otp->code();
+			return {{"ok", true}, {"code", std::string(code.data(), code.size())}};
+		}
+
+		return errorResponse("unrecognised request");
+	}
+
+	void InstanceServer::onNewConnection()
+	{
+		while(auto * socket = m_server.nextPendingConnection()) {
+			connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+
+			// re: clazy warning, the socket is the context so the lambda can't outlive it
+			connect(socket, &QLocalSocket::readyRead, socket, [this, socket]() {
+				readRequests(socket);
+			});
+		}
+	}
+
+	void InstanceServer::readRequests(QLocalSocket * socket)
+	{
+		while(socket->canReadLine()) {
+			const auto line = socket->readLine();
+			json response;
+
+			try {
+				response = handleRequest(json::parse(line.toStdString()));
+			} catch(const json::exception & err) {
+				std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: invalid request: " << err.what() << "\n";
+				response = errorResponse("invalid request");
+			}
+
+			socket->write(QByteArray::fromStdString(response.dump()).append('\n'));
+		}
+
+		if(MaxRequestSize < socket->bytesAvailable()) {
+			std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: request too large - disconnecting client\n";
+			socket->abort();
+		}
+	}
+}	// namespace Qonvince
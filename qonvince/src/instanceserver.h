@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_INSTANCESERVER_H
+#define QONVINCE_INSTANCESERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QLocalServer>
+#include <nlohmann/json.hpp>
+
+class QLocalSocket;
+
+namespace Qonvince
+{
+	/**
+	 * Accepts requests forwarded from other invocations of Qonvince.
+	 *
+	 * Once the settings are unlocked the running instance listens on a local socket that only the current user can
+	 * connect to. Later invocations send their request (show the window, copy or print a code, import a QR code image)
+	 * to it rather than starting up and asking for the passphrase again.
+	 *
+	 * The protocol is one JSON object per line in each direction. Requests have a "request" member naming the action
+	 * and, depending on the action, an "otp" identifier (see otpIdentifier()) or a "file" path. Responses always have an
+	 * "ok" member and either an "error" message or, for "code" requests, the "code". Codes for OTPs that are only revealed
+	 * on demand are neither copied nor sent until the user has revealed them.
+	 */
+	class InstanceServer
+	: public QObject
+	{
+		Q_OBJECT
+
+	public:
+		static constexpr const char * ShowRequest = "show";
+		static constexpr const char * CopyRequest = "copy";
+		static constexpr const char * CodeRequest = "code";
+		static constexpr const char * ImportRequest = "import";
+
+		// the error for copy and code requests while the OTP's code is hidden
+		static constexpr const char * CodeHiddenError = "the code is only revealed on demand";
+
+		explicit InstanceServer(QObject * parent = nullptr);
+		~InstanceServer() override;
+
+		// the socket name is specific to the user's data location so that separate users never see each other's server
+		static QString serverName();
+
+		bool listen();
+
+		[[nodiscard]] inline bool isListening() const
+		{
+			return m_server.isListening();
+		}
+
+		// carry out a request on the running Application and build the response
+		static nlohmann::json handleRequest(const nlohmann::json & request);
+
+	private Q_SLOTS:
+		void onNewConnection();
+
+	private:
+		void readRequests(QLocalSocket * socket);
+
+		QLocalServer m_server;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_INSTANCESERVER_H
@@ -17,10 +17,18 @@
  * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QCoreApplication>
 #include "application.h"
+#include "commandlineclient.h"
 
 int main(int argc, char * argv[])
 {
+	// scripts that only want a code don't need any of the GUI set up
+	if(Qonvince::CommandLineClient::isRequested(argc, argv)) {
+		QCoreApplication app(argc, argv);
+		return Qonvince::CommandLineClient(QCoreApplication::arguments()).exec();
+	}
+
 	Qonvince::Application app(argc, argv);
-	Qonvince::Application::exec();
+	return Qonvince::Application::exec();
 }
@@ -41,6 +41,7 @@
 #include <QUrl>
 #include <QStringBuilder>
 #include <QTemporaryFile>
+#include <QLineEdit>
 
 #if defined(WITH_NETWORK_ACCESS)
 #include <QtNetwork/QNetworkRequest>
@@ -103,6 +104,7 @@ namespace Qonvince
 		});
 
 		connect(m_ui->otpList, &OtpListView::editCodeRequested, this, &MainWindow::createOtpEditor);
+		connect(m_ui->search, &QLineEdit::textChanged, m_ui->otpList, &OtpListView::setFilterText);
 
 		connect(&(qonvinceApp->settings()), qOverload<bool>(&Settings::copyCodeOnClickChanged), this, &MainWindow::refreshTooltip);
 	}
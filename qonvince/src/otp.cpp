@@ -25,10 +25,11 @@
  * @todo look for optimisations in hmac(), totp() and hotp()
  */
 #include "otp.h"
+#include <algorithm>
 #include <ctime>
 #include <cmath>
+#include <string_view>
 #include <utility>
-#include <random>
 #include <memory>
 #include <QStringBuilder>
 #include <QFile>
@@ -36,10 +37,13 @@
 #include <QBasicTimer>
 #include <QSettings>
 #include <QCryptographicHash>
+#include <QImage>
+#include <QPixmap>
 #include <QStandardPaths>
 #include <QtEndian>
 #include <QtCrypto>
 #include "application.h"
+#include "iconstore.h"
 #include "otpdisplayplugin.h"
 #include "qtiostream.h"
 #include "securestring.h"
@@ -59,6 +63,8 @@ namespace Qonvince
               m_issuer{std::move(issuer)},
               m_name{std::move(name)},
               m_displayPluginName{},
+              m_displayPluginHandle{Application::DisplayPluginFactory::InvalidHandle},
+              m_displayPluginGeneration{0},
               m_counter{0},
               m_baselineTime{0},
               m_interval{DefaultInterval},
@@ -73,6 +79,8 @@ namespace Qonvince
         refreshCode();
         resynchroniseRefreshTimer();
         blockSignals(false);
+
+        connect(&Clock::current(), &Clock::adjusted, this, &Otp::onClockAdjusted);
     }
 
     Otp::Otp(OtpType type, QObject * parent) noexcept
@@ -93,6 +101,11 @@ namespace Qonvince
     Otp::~Otp()
     {
         m_refreshTimer->stop();
+
+        if (!m_iconFileName.isEmpty() && qonvinceApp) {
+            qonvinceApp->iconStore().release(m_iconFileName);
+        }
+
         // TODO why is this here? base class should emit this should it not?
         Q_EMIT destroyed(this);
     }
@@ -145,42 +158,45 @@ namespace Qonvince
 
     void Otp::setIcon(const QIcon & icon)
     {
-        m_icon = icon;
+        auto & iconStore = qonvinceApp->iconStore();
 
-        if (m_icon.isNull()) {
-            if (!m_iconFileName.isEmpty()) {
-                /* remove old icon file */
-                QString path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) % "/codes/icons/" % m_iconFileName;
+        // the new icon is added before the old one is released so that setting the same icon again doesn't drop it. the
+        // files are written in the background (see IconStore)
+        const auto key = iconStore.add(icon);
 
-                if (QFile::exists(path) && !QFile::remove(path)) {
-                    std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to remove old icon file for " << issuer() << ":" << name() << " from \""
-                              << path << "\"\n";
-                }
-            }
+        if (!m_iconFileName.isEmpty()) {
+            iconStore.release(m_iconFileName);
+        }
 
-            m_iconFileName = QString();
-        } else {
-            if (m_iconFileName.isEmpty()) {
-                m_iconFileName = QCryptographicHash::hash((name() % issuer() % QString::number(std::random_device()() % 1000)).toUtf8(),
-                                                          QCryptographicHash::Sha1).toHex();
+        m_iconFileName = key;
+        m_icon = (key.isEmpty() ? QIcon() : iconStore.icon(key));
+        Q_EMIT iconChanged(m_icon);
+        Q_EMIT changed();
+    }
+
+    void Otp::loadIcon(const QString & key)
+    {
+        m_iconFileName = key;
+
+        // the icon came from the store, so it isn't written back and the Otp hasn't changed; only the icon is reported
+        qonvinceApp->iconStore().acquire(key, this, [this, key](const QString & storedKey, const QIcon & icon) {
+            if (key != m_iconFileName) {
+                // the icon has been replaced or removed while it was being read
+                return;
             }
 
-            if (!Application::ensureDataDirectory(QStringLiteral("codes/icons"))) {
-                std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: the data directory \""
-                          << QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
-                          << "/codes/icons\" does not exist and could not be created\n";
-            } else {
-                QString path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) % "/codes/icons/" % m_iconFileName;
+            // an icon file from an earlier version has been moved to its content key, which is saved with the next write
+            m_iconFileName = storedKey;
 
-                if (!m_icon.pixmap(64).save(path, "PNG")) {
-                    std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed to save icon for " << issuer() << ":" << name() << " to \"" << path
-                              << "\"\n";
-                }
+            if (icon.isNull()) {
+                std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed loading icon \"" << qPrintable(key) << "\" for code "
+                          << qPrintable(issuer()) << ":" << qPrintable(name()) << "\n";
+                return;
             }
-        }
 
-        Q_EMIT iconChanged(m_icon);
-        Q_EMIT changed();
+            m_icon = icon;
+            Q_EMIT iconChanged(m_icon);
+        });
     }
 
     QByteArray Otp::seed(SeedType seedType) const
@@ -211,7 +227,8 @@ namespace Qonvince
             oldSeed = m_seed.plain();
             oldB32 = m_seed.encoded();
 
-            if (!m_seed.setEncoded(newSeed)) {
+            // seeds typed by the user are often grouped, lower-case or unpadded, so accept them as they are
+            if (!m_seed.setEncoded(newSeed, LibQonvince::Base32Codec::Normalise::Lenient)) {
                 // invalid base32 sequence
                 m_seed.setPlain(oldSeed);
                 return false;
@@ -256,6 +273,7 @@ namespace Qonvince
         if (pluginName != m_displayPluginName) {
             QString oldName = m_displayPluginName;
             m_displayPluginName = pluginName;
+            resolveDisplayPlugin();
 
             Q_EMIT displayPluginChanged(oldName, pluginName);
             Q_EMIT displayPluginChanged(pluginName);
@@ -266,6 +284,31 @@ namespace Qonvince
         return true;
     }
 
+    void Otp::resolveDisplayPlugin() const
+    {
+        if (m_displayPluginName.isEmpty()) {
+            m_displayPluginHandle = Application::DisplayPluginFactory::InvalidHandle;
+        } else {
+            m_displayPluginHandle = qonvinceApp->otpDisplayPluginHandle(m_displayPluginName);
+        }
+
+        // read after the lookup, which can load plugins
+        m_displayPluginGeneration = qonvinceApp->otpDisplayPluginGeneration();
+    }
+
+    LibQonvince::OtpDisplayPlugin * Otp::displayPlugin() const
+    {
+        if (m_displayPluginName.isEmpty()) {
+            return nullptr;
+        }
+
+        if (m_displayPluginGeneration != qonvinceApp->otpDisplayPluginGeneration()) {
+            resolveDisplayPlugin();
+        }
+
+        return qonvinceApp->otpDisplayPlugin(m_displayPluginHandle);
+    }
+
     void Otp::setBaselineTime(qint64 secSinceEpoch)
     {
         if (secSinceEpoch != m_baselineTime) {
@@ -279,6 +322,11 @@ namespace Qonvince
     }
 
     std::unique_ptr<Otp> Otp::fromSettings(const QSettings & settings, const QCA::SecureArray & cryptKey)
+    {
+        return fromSettings(settings, decryptSeed(settings, cryptKey));
+    }
+
+    std::unique_ptr<Otp> Otp::fromSettings(const QSettings & settings, const std::optional<QByteArray> & base32Seed)
     {
         //		static constexpr std::array<QChar, 6> s_validIconFileNameChars = {{'a', 'b', 'c', 'd', 'e', 'f'}};
 
@@ -286,28 +334,7 @@ namespace Qonvince
         ret->setName(settings.value(QStringLiteral("name")).toString());
         ret->setIssuer(settings.value(QStringLiteral("issuer")).toString());
 
-        QString pluginName = settings.value(QStringLiteral("pluginName")).toString();
-
-        // in old files, the number of digits will be stored, so if there's no
-        // plugin name, look for that instead
-        if (pluginName.isEmpty()) {
-            bool ok;
-            int digits = settings.value(QStringLiteral("digits")).toInt(&ok);
-
-            if (ok) {
-                if (8 == digits) {
-                    pluginName = QStringLiteral("EightDigitsPlugin");
-                } else if (6 == digits) {
-                    pluginName = QStringLiteral("SixDigitsPlugin");
-                } else {
-                    std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: " << digits
-                              << " is an invalid number of digits for code (old settings entry) - reverting to 6 digits\n";
-                    pluginName = QStringLiteral("SixDigitsPlugin");
-                }
-            }
-        }
-
-        ret->setDisplayPluginName(pluginName);
+        ret->setDisplayPluginName(displayPluginNameFromSettings(settings));
 
         QString fileName = settings.value(QStringLiteral("icon")).toString();
 
@@ -323,41 +350,12 @@ namespace Qonvince
         }
 
         if (!fileName.isEmpty()) {
-            /* save icon and write filename to settings */
-            auto path = QStandardPaths::locate(QStandardPaths::AppLocalDataLocation, QStringLiteral("codes/icons/") % fileName);
-
-            if (path.isEmpty()) {
-                std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: icon file \"" << qPrintable(fileName) << "\" for code " << qPrintable(ret->issuer())
-                          << ":" << qPrintable(ret->name()) << " not found\n";
-            } else {
-                QIcon ic(path);
-
-                if (ic.isNull()) {
-                    std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed loading icon \"" << qPrintable(fileName) << "\" for code"
-                              << qPrintable(ret->issuer()) << ":" << qPrintable(ret->name()) << "\n";
-                } else {
-                    ret->m_iconFileName = fileName;
-                    ret->setIcon(ic);
-                }
-            }
-        }
-
-        bool haveSeed = false;
-
-        {
-            QCA::SecureArray value(QCA::hexToArray(settings.value(QStringLiteral("seed")).toByteArray()));
-            QCA::SymmetricKey key(cryptKey);
-            QCA::InitializationVector initVec(value.toByteArray().left(InitializationVectorSize));
-            QCA::Cipher cipher(QStringLiteral("aes256"), QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Decode, key, initVec);
-            QCA::SecureArray seed = cipher.process(value.toByteArray().mid(InitializationVectorSize));
-
-            if (cipher.ok()) {
-                ret->setSeed(seed.toByteArray(), SeedType::Base32);
-                haveSeed = true;
-            }
+            ret->loadIcon(fileName);
         }
 
-        if (!haveSeed) {
+        if (base32Seed) {
+            ret->setSeed(*base32Seed, SeedType::Base32);
+        } else {
             std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: decryption of seed failed\n";
         }
 
@@ -373,6 +371,61 @@ namespace Qonvince
         return ret;
     }
 
+    std::optional<QByteArray> Otp::decryptSeed(const QSettings & settings, const QCA::SecureArray & cryptKey)
+    {
+        QCA::SecureArray value(QCA::hexToArray(settings.value(QStringLiteral("seed")).toByteArray()));
+        QCA::SymmetricKey key(cryptKey);
+        QCA::InitializationVector initVec(value.toByteArray().left(InitializationVectorSize));
+        QCA::Cipher cipher(QStringLiteral("aes256"), QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Decode, key, initVec);
+        QCA::SecureArray seed = cipher.process(value.toByteArray().mid(InitializationVectorSize));
+
+        if (!cipher.ok()) {
+            return {};
+        }
+
+        return seed.toByteArray();
+    }
+
+    std::optional<QString> Otp::encryptSeed(const QByteArray & base32Seed, const QCA::SecureArray & cryptKey)
+    {
+        QCA::SymmetricKey key(cryptKey);
+        QCA::InitializationVector initVec(InitializationVectorSize);
+        QCA::Cipher cipher(QStringLiteral("aes256"), QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Encode, key, initVec);
+        QCA::SecureArray encrypted = initVec.toByteArray() + cipher.process(base32Seed);
+
+        if (!cipher.ok()) {
+            return {};
+        }
+
+        return QCA::arrayToHex(encrypted.toByteArray());
+    }
+
+    QString Otp::displayPluginNameFromSettings(const QSettings & settings)
+    {
+        QString pluginName = settings.value(QStringLiteral("pluginName")).toString();
+
+        // in old files, the number of digits will be stored, so if there's no
+        // plugin name, look for that instead
+        if (pluginName.isEmpty()) {
+            bool ok;
+            int digits = settings.value(QStringLiteral("digits")).toInt(&ok);
+
+            if (ok) {
+                if (8 == digits) {
+                    pluginName = QStringLiteral("EightDigitsPlugin");
+                } else if (6 == digits) {
+                    pluginName = QStringLiteral("SixDigitsPlugin");
+                } else {
+                    std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: " << digits
+                              << " is an invalid number of digits for code (old settings entry) - reverting to 6 digits\n";
+                    pluginName = QStringLiteral("SixDigitsPlugin");
+                }
+            }
+        }
+
+        return pluginName;
+    }
+
     void Otp::writeSettings(QSettings & settings, const QCA::SecureArray & cryptKey) const
     {
         settings.setValue(QStringLiteral("name"), name());
@@ -386,17 +439,10 @@ namespace Qonvince
 
         settings.setValue(QStringLiteral("pluginName"), m_displayPluginName);
 
-        // scope ensures sensitive data is destroyed ASAP
-        {
-            QCA::SymmetricKey key(cryptKey);
-            QCA::InitializationVector initVec(InitializationVectorSize);
-            QCA::Cipher cipher(QStringLiteral("aes256"), QCA::Cipher::CBC, QCA::Cipher::DefaultPadding, QCA::Encode, key, initVec);
-            QCA::SecureArray encrypted = initVec.toByteArray() + cipher.process(seed(SeedType::Base32));
-            settings.setValue(QStringLiteral("seed"), QCA::arrayToHex(encrypted.toByteArray()));
-
-            if (!cipher.ok()) {
-                std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: encryption of seed failed\n";
-            }
+        if (const auto encrypted = encryptSeed(seed(SeedType::Base32), cryptKey); encrypted) {
+            settings.setValue(QStringLiteral("seed"), *encrypted);
+        } else {
+            std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: encryption of seed failed\n";
         }
 
         if (OtpType::Hotp == type()) {
@@ -422,22 +468,7 @@ namespace Qonvince
             const auto fileName = QString::fromStdString(otpJson["icon"]);
             
             if (!fileName.isEmpty()) {
-                auto path = QStandardPaths::locate(QStandardPaths::AppLocalDataLocation, QStringLiteral("codes/icons/") % fileName);
-                
-                if (path.isEmpty()) {
-                    std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: icon file \"" << qPrintable(fileName) << "\" for code " << qPrintable(ret->issuer())
-                    << ":" << qPrintable(ret->name()) << " not found\n";
-                } else {
-                    QIcon ic(path);
-                    
-                    if (ic.isNull()) {
-                        std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: failed loading icon \"" << qPrintable(fileName) << "\" for code"
-                        << qPrintable(ret->issuer()) << ":" << qPrintable(ret->name()) << "\n";
-                    } else {
-                        ret->m_iconFileName = fileName;
-                        ret->setIcon(ic);
-                    }
-                }
+                ret->loadIcon(fileName);
             }
         }
         
@@ -504,7 +535,7 @@ namespace Qonvince
             return;
         }
 
-        auto * plugin = qonvinceApp->otpDisplayPluginByName(m_displayPluginName);
+        auto * plugin = displayPlugin();
 
         if (!plugin) {
             std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: display plugin \"" << qPrintable(m_displayPluginName) << "\" not found\n";
@@ -512,7 +543,8 @@ namespace Qonvince
             return;
         }
 
-        SecureString mySeed = seed().constData();
+        const auto plainSeed = seed();
+        SecureString mySeed(plainSeed.constData(), static_cast<std::size_t>(plainSeed.size()));
 
         if (0 == mySeed.length()) {
             std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: no seed\n";
@@ -520,8 +552,10 @@ namespace Qonvince
             return;
         }
 
+        // the plugin writes the code to the stack, and it's only copied into m_currentCode if it has changed
         if (OtpType::Hotp == m_type) {
-            m_currentCode = plugin->codeDisplayString(hotp(mySeed, counter()));
+            const LibQonvince::DisplayCode newCode(*plugin, hotp(mySeed, counter()));
+            m_currentCode.assign(newCode.view().data(), newCode.view().size());
             Q_EMIT newCodeGenerated(QString::fromUtf8(m_currentCode.data(), static_cast<int>(m_currentCode.size())));
         } else {
             auto codeInterval = interval();
@@ -530,11 +564,11 @@ namespace Qonvince
 					 codeInterval = 30;
             }
 
-            auto code = plugin->codeDisplayString(totp(mySeed, baselineSecSinceEpoch(), codeInterval));
+            const LibQonvince::DisplayCode newCode(*plugin, totp(mySeed, baselineSecSinceEpoch(), codeInterval));
 
-            if (!code.empty()) {
-                if (m_currentCode != code) {
-                    m_currentCode = code;
+            if (!newCode.empty()) {
+                if (std::string_view(m_currentCode.data(), m_currentCode.size()) != newCode.view()) {
+                    m_currentCode.assign(newCode.view().data(), newCode.view().size());
 						  Q_EMIT newCodeGenerated(QString::fromUtf8(m_currentCode.data(), static_cast<int>(m_currentCode.size())));
                 }
             } else {
@@ -568,9 +602,23 @@ namespace Qonvince
         }
     }
 
+    void Otp::onClockAdjusted()
+    {
+        // HOTP codes don't depend on the time
+        if (OtpType::Totp == m_type) {
+            refreshCode();
+            resynchroniseRefreshTimer();
+        }
+    }
+
 	 SecureString Otp::totp(const SecureString & seed, time_t base, int interval)
     {
-        return hotp(seed, static_cast<uint64_t>(std::floor((QDateTime::currentDateTimeUtc().toTime_t() - base) / interval)));
+        return totpAt(seed, static_cast<time_t>(Clock::current().secsSinceEpoch()), base, interval);
+    }
+
+    SecureString Otp::totpAt(const SecureString & seed, time_t time, time_t base, int interval)
+    {
+        return hotp(seed, static_cast<uint64_t>(std::floor((time - base) / interval)));
     }
 
     SecureString Otp::hotp(const SecureString & seed, uint64_t counter)
@@ -588,8 +636,10 @@ namespace Qonvince
         auto myKey = key;
         auto keySize = myKey.size();
 
+        // the key and the digests are binary so must never be treated as nul-terminated strings
         if (keySize > blockSize) {
-            myKey = QCryptographicHash::hash(myKey.data(), QCryptographicHash::Sha1).constData();
+            const auto digest = QCryptographicHash::hash(QByteArray::fromRawData(myKey.data(), static_cast<int>(keySize)), QCryptographicHash::Sha1);
+            myKey.assign(digest.constData(), static_cast<std::size_t>(digest.size()));
             keySize = myKey.size();
         }
 
@@ -605,6 +655,7 @@ namespace Qonvince
             i_key_pad[i] = static_cast<QByteArray::value_type >(i_key_pad[i] ^ myKey[i]);
         }
 
-        return QCryptographicHash::hash(o_key_pad + QCryptographicHash::hash(i_key_pad + message, QCryptographicHash::Sha1), QCryptographicHash::Sha1).constData();
+        const auto digest = QCryptographicHash::hash(o_key_pad + QCryptographicHash::hash(i_key_pad + message, QCryptographicHash::Sha1), QCryptographicHash::Sha1);
+        return SecureString(digest.constData(), static_cast<std::size_t>(digest.size()));
     }
 }    // namespace Qonvince
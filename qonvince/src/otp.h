@@ -20,7 +20,9 @@
 #ifndef QONVINCE_OTP_H
 #define QONVINCE_OTP_H
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 
 #include <QString>
 #include <QByteArray>
@@ -30,6 +32,7 @@
 #include <QtCrypto>
 
 #include "types.h"
+#include "clock.h"
 #include "securestring.h"
 #include "base32.h"
 #include "application.h"
@@ -71,6 +74,33 @@ namespace Qonvince
 
 		static std::unique_ptr<Otp> fromSettings(const QSettings & settings, const QCA::SecureArray & cryptKey);
 
+		// for when the seed has already been decrypted (e.g. off the GUI thread). pass an empty optional if decryption
+		// failed; it is reported, and the Otp is created without a seed
+		static std::unique_ptr<Otp> fromSettings(const QSettings & settings, const std::optional<QByteArray> & base32Seed);
+
+		/**
+		 * Decrypt the Base32 seed stored in an Otp's settings group.
+		 *
+		 * This is the only part of an Otp's stored settings that requires the passphrase, so callers that only need
+		 * the code for a single Otp can avoid decrypting all the others.
+		 *
+		 * @return The Base32 encoded seed, or an empty optional if it could not be decrypted.
+		 */
+		static std::optional<QByteArray> decryptSeed(const QSettings & settings, const QCA::SecureArray & cryptKey);
+
+		/**
+		 * Encrypt a Base32 seed in the form it is stored in an Otp's settings group.
+		 *
+		 * @return The hex-encoded IV and encrypted seed, or an empty optional if it could not be encrypted.
+		 */
+		static std::optional<QString> encryptSeed(const QByteArray & base32Seed, const QCA::SecureArray & cryptKey);
+
+		/**
+		 * Read the name of the display plugin from an Otp's settings group, taking into account files written by older
+		 * versions that stored the number of digits rather than the plugin name.
+		 */
+		static QString displayPluginNameFromSettings(const QSettings & settings);
+
 		inline const OtpType & type() const
 		{
 			return m_type;
@@ -125,26 +155,34 @@ namespace Qonvince
 			return m_baselineTime;
 		}
 
-		inline int timeSinceLastCode() const
+		// the seconds since the current code's interval started, at a given time
+		static constexpr int timeSinceLastCodeAt(qint64 secsSinceEpoch, qint64 baselineSecSinceEpoch, int interval)
 		{
-			int d(interval());
-
-			if(0 >= d) {
-				d = 30;
+			if(0 >= interval) {
+				interval = DefaultInterval;
 			}
 
-			return ((QDateTime::currentDateTimeUtc().toMSecsSinceEpoch() / 1000) - baselineSecSinceEpoch()) % d;
+			return static_cast<int>((secsSinceEpoch - baselineSecSinceEpoch) % interval);
 		}
 
-		inline int timeToNextCode() const
+		// the seconds until the next code's interval starts, at a given time
+		static constexpr int timeToNextCodeAt(qint64 secsSinceEpoch, qint64 baselineSecSinceEpoch, int interval)
 		{
-			int d(interval());
-
-			if(0 >= d) {
-				d = 30;
+			if(0 >= interval) {
+				interval = DefaultInterval;
 			}
 
-			return d - timeSinceLastCode();
+			return interval - timeSinceLastCodeAt(secsSinceEpoch, baselineSecSinceEpoch, interval);
+		}
+
+		inline int timeSinceLastCode() const
+		{
+			return timeSinceLastCodeAt(Clock::current().secsSinceEpoch(), baselineSecSinceEpoch(), interval());
+		}
+
+		inline int timeToNextCode() const
+		{
+			return timeToNextCodeAt(Clock::current().secsSinceEpoch(), baselineSecSinceEpoch(), interval());
 		}
 
 		const SecureString & code();
@@ -154,6 +192,9 @@ namespace Qonvince
 			return m_displayPluginName;
 		}
 
+		// the plugin is found by name only when the name is set or the loaded plugins have changed since
+		LibQonvince::OtpDisplayPlugin * displayPlugin() const;
+
 		void writeSettings(QSettings & settings, const QCA::SecureArray & cryptKey) const;
 
         // JsonSerialisable interface
@@ -272,22 +313,38 @@ namespace Qonvince
 
 	private Q_SLOTS:
 		void internalRefreshCode();
+		void onClockAdjusted();
 
-	protected:
+	public:
+		// the TOTP for the time according to Clock::current()
 		static SecureString totp(const SecureString & seed, time_t base = 0, int interval = 30);
+
+		// the TOTP for a given time (in seconds since the epoch) rather than the current time
+		static SecureString totpAt(const SecureString & seed, time_t time, time_t base = 0, int interval = 30);
 		static SecureString hotp(const SecureString & seed, uint64_t counter);
 		static SecureString hmac(const SecureString & key, const QByteArray & message);
 
 	private:
+		// use an icon that is already in the IconStore. the icon is read in the background and arrives with iconChanged()
+		void loadIcon(const QString & key);
+
 		QString m_issuer;
 		QString m_name;
 		QIcon m_icon;
 
-		// the name (JUST the name, not the path) of the temporary file for the
-		// icon so that it persists between invocations of Qonvince
+		// the IconStore key for the icon, so that it persists between invocations of Qonvince. the Otp holds a reference
+		// to it while it's set
 		QString m_iconFileName;
 
+		// look up the display plugin handle for the name
+		void resolveDisplayPlugin() const;
+
 		QString m_displayPluginName;
+
+		// the display plugin's handle in the Application's plugin factory, and the plugin generation it was resolved in
+		mutable int m_displayPluginHandle;
+		mutable std::uint64_t m_displayPluginGeneration;
+
 		mutable Base32 m_seed;
 		quint64 m_counter;
 		SecureString m_currentCode;
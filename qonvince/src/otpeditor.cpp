@@ -283,7 +283,7 @@ namespace Qonvince {
 
 		if(reader.decode()) {
 			m_otp->setName(reader.name());
-			m_otp->setSeed(reader.seed(), Otp::SeedType::Base32);
+			m_otp->setSeed(reader.seed(), Otp::SeedType::Plain);
 		}
 		else {
 			QMessageBox::critical(this, tr("%1: error").arg(QApplication::applicationName()), tr("The image could not be decoded. Is it really a QR code image?"));
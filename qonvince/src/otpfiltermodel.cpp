@@ -0,0 +1,467 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file otpfiltermodel.cpp
+ * @brief Implementation of the OtpFilterModel class.
+ */
+
+#include "otpfiltermodel.h"
+
+#include <algorithm>
+
+#include "otp.h"
+#include "otplistmodel.h"
+
+namespace Qonvince
+{
+	OtpFilterModel::OtpFilterModel(QObject * parent)
+	: QAbstractProxyModel(parent),
+	  m_filtered(false),
+	  m_sourceRowsDirty(true)
+	{
+		// a renamed OTP might start or stop matching
+		connect(&m_index, &OtpSearchIndex::otpChanged, this, [this]() {
+			if(!m_filtered) {
+				return;
+			}
+
+			beginResetModel();
+			refilter();
+			endResetModel();
+		});
+	}
+
+	OtpFilterModel::~OtpFilterModel() = default;
+
+	void OtpFilterModel::setSourceModel(QAbstractItemModel * sourceModel)
+	{
+		beginResetModel();
+
+		if(auto * oldSourceModel = this->sourceModel(); oldSourceModel) {
+			disconnect(oldSourceModel, nullptr, this, nullptr);
+		}
+
+		QAbstractProxyModel::setSourceModel(sourceModel);
+		m_index.clear();
+		m_sourceRowsDirty = true;
+
+		if(sourceModel) {
+			connect(sourceModel, &QAbstractItemModel::dataChanged, this, &OtpFilterModel::onSourceDataChanged);
+			connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted, this, &OtpFilterModel::onSourceRowsAboutToBeInserted);
+			connect(sourceModel, &QAbstractItemModel::rowsInserted, this, &OtpFilterModel::onSourceRowsInserted);
+			connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, &OtpFilterModel::onSourceRowsAboutToBeRemoved);
+			connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, &OtpFilterModel::onSourceRowsRemoved);
+			connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, &OtpFilterModel::onSourceAboutToBeReset);
+			connect(sourceModel, &QAbstractItemModel::modelReset, this, &OtpFilterModel::onSourceReset);
+
+			// OtpListModel doesn't report moves or layout changes, but if a source model does they're treated as resets
+			connect(sourceModel, &QAbstractItemModel::rowsAboutToBeMoved, this, &OtpFilterModel::onSourceAboutToBeReset);
+			connect(sourceModel, &QAbstractItemModel::rowsMoved, this, &OtpFilterModel::onSourceReset);
+			connect(sourceModel, &QAbstractItemModel::layoutAboutToBeChanged, this, &OtpFilterModel::onSourceAboutToBeReset);
+			connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &OtpFilterModel::onSourceReset);
+
+			indexSourceRows(0, sourceModel->rowCount() - 1);
+		}
+
+		refilter();
+		endResetModel();
+	}
+
+	int OtpFilterModel::sourceRow(int row) const
+	{
+		if(!m_filtered) {
+			return row;
+		}
+
+		return (0 <= row && m_rows.size() > static_cast<std::size_t>(row) ? m_rows[static_cast<std::size_t>(row)] : -1);
+	}
+
+	QModelIndex OtpFilterModel::index(int row, int column, const QModelIndex & parent) const
+	{
+		if(!hasIndex(row, column, parent)) {
+			return {};
+		}
+
+		return createIndex(row, column);
+	}
+
+	QModelIndex OtpFilterModel::parent(const QModelIndex &) const
+	{
+		return {};
+	}
+
+	int OtpFilterModel::rowCount(const QModelIndex & parent) const
+	{
+		if(parent.isValid() || !sourceModel()) {
+			return 0;
+		}
+
+		return (m_filtered ? static_cast<int>(m_rows.size()) : sourceModel()->rowCount());
+	}
+
+	int OtpFilterModel::columnCount(const QModelIndex & parent) const
+	{
+		return (parent.isValid() ? 0 : 1);
+	}
+
+	QModelIndex OtpFilterModel::mapToSource(const QModelIndex & proxyIndex) const
+	{
+		if(!sourceModel() || !proxyIndex.isValid()) {
+			return {};
+		}
+
+		const auto row = sourceRow(proxyIndex.row());
+		return (0 > row ? QModelIndex() : sourceModel()->index(row, proxyIndex.column()));
+	}
+
+	QModelIndex OtpFilterModel::mapFromSource(const QModelIndex & sourceIndex) const
+	{
+		if(!sourceIndex.isValid()) {
+			return {};
+		}
+
+		if(!m_filtered) {
+			return index(sourceIndex.row(), sourceIndex.column());
+		}
+
+		const auto row = m_proxyRows.find(sourceIndex.row());
+		return (m_proxyRows.cend() == row ? QModelIndex() : index(row->second, sourceIndex.column()));
+	}
+
+	Qt::ItemFlags OtpFilterModel::flags(const QModelIndex & index) const
+	{
+		auto flags = QAbstractProxyModel::flags(index);
+
+		if(m_filtered) {
+			flags &= ~(Qt::ItemIsDragEnabled | Qt::ItemIsDropEnabled);
+		}
+
+		return flags;
+	}
+
+	bool OtpFilterModel::canDropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column, const QModelIndex & parent) const
+	{
+		// unfiltered rows are the source rows, so the drop coordinates don't need mapping
+		if(m_filtered || !sourceModel()) {
+			return false;
+		}
+
+		return sourceModel()->canDropMimeData(data, action, row, column, mapToSource(parent));
+	}
+
+	bool OtpFilterModel::dropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column, const QModelIndex & parent)
+	{
+		if(m_filtered || !sourceModel()) {
+			return false;
+		}
+
+		return sourceModel()->dropMimeData(data, action, row, column, mapToSource(parent));
+	}
+
+	void OtpFilterModel::setFilterText(const QString & text)
+	{
+		if(text == m_filterText) {
+			return;
+		}
+
+		// reordering OTPs by drag and drop moves them in the Application without the source model reporting it, so
+		// the source rows are found again whenever filtering starts
+		if(!m_filtered) {
+			m_sourceRowsDirty = true;
+		}
+
+		beginResetModel();
+		m_filterText = text;
+		refilter();
+		endResetModel();
+	}
+
+	void OtpFilterModel::noteUse(Otp * otp)
+	{
+		m_index.noteUse(otp);
+	}
+
+	Otp * OtpFilterModel::sourceOtp(int sourceRow) const
+	{
+		return sourceModel()->index(sourceRow, 0).data(OtpListModel::OtpRole).value<Otp *>();
+	}
+
+	void OtpFilterModel::indexSourceRows(int first, int last)
+	{
+		for(int row = first; row <= last; ++row) {
+			m_index.add(sourceOtp(row));
+		}
+	}
+
+	void OtpFilterModel::refilter()
+	{
+		m_rows.clear();
+		m_ranks.clear();
+		m_proxyRows.clear();
+		m_filtered = !m_filterText.trimmed().isEmpty();
+
+		if(!m_filtered || !sourceModel()) {
+			return;
+		}
+
+		if(m_sourceRowsDirty) {
+			const auto rowCount = sourceModel()->rowCount();
+			m_sourceRows.clear();
+			m_sourceRows.reserve(static_cast<std::size_t>(rowCount));
+			m_sourceOtps.clear();
+			m_sourceOtps.reserve(static_cast<std::size_t>(rowCount));
+
+			for(int row = 0; row < rowCount; ++row) {
+				const auto * otp = sourceOtp(row);
+				m_sourceRows.emplace(otp, row);
+				m_sourceOtps.push_back(otp);
+			}
+
+			m_sourceRowsDirty = false;
+		}
+
+		// the index can briefly hold an OTP that the source model has already removed, until the OTP is destroyed
+		for(const auto & match : m_index.rankedSearch(m_filterText)) {
+			if(const auto row = m_sourceRows.find(match.otp); m_sourceRows.cend() != row) {
+				m_rows.push_back(row->second);
+				m_ranks.push_back(match.rank);
+			}
+		}
+
+		rebuildProxyRows();
+	}
+
+	void OtpFilterModel::rebuildProxyRows()
+	{
+		m_proxyRows.clear();
+		m_proxyRows.reserve(m_rows.size());
+
+		for(int row = 0, count = static_cast<int>(m_rows.size()); row < count; ++row) {
+			m_proxyRows.emplace(m_rows[static_cast<std::size_t>(row)], row);
+		}
+	}
+
+	void OtpFilterModel::onSourceDataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight, const QVector<int> & roles)
+	{
+		if(!m_filtered) {
+			Q_EMIT dataChanged(index(topLeft.row(), 0), index(bottomRight.row(), 0), roles);
+			return;
+		}
+
+		// visit the matches rather than the changed rows because there are never more of them, and report each run of
+		// adjacent matches as one change
+		const auto emitRun = [this, &roles](int first, int last) {
+			Q_EMIT dataChanged(index(first, 0), index(last, 0), roles);
+		};
+
+		int runStart = -1;
+		int runEnd = -1;
+
+		for(int row = 0, count = static_cast<int>(m_rows.size()); row < count; ++row) {
+			if(const auto sourceRow = m_rows[static_cast<std::size_t>(row)]; sourceRow < topLeft.row() || sourceRow > bottomRight.row()) {
+				continue;
+			}
+
+			if(0 <= runStart && runEnd + 1 == row) {
+				runEnd = row;
+				continue;
+			}
+
+			if(0 <= runStart) {
+				emitRun(runStart, runEnd);
+			}
+
+			runStart = row;
+			runEnd = row;
+		}
+
+		if(0 <= runStart) {
+			emitRun(runStart, runEnd);
+		}
+	}
+
+	void OtpFilterModel::onSourceRowsAboutToBeInserted(const QModelIndex &, int first, int last)
+	{
+		// while filtered, the new rows that match are inserted once the source has them
+		if(!m_filtered) {
+			beginInsertRows({}, first, last);
+		}
+	}
+
+	void OtpFilterModel::onSourceRowsInserted(const QModelIndex &, int first, int last)
+	{
+		if(!m_filtered) {
+			indexSourceRows(first, last);
+
+			// filtering finds the source rows again when it starts
+			m_sourceRowsDirty = true;
+			endInsertRows();
+			return;
+		}
+
+		const auto count = last - first + 1;
+		std::vector<Otp *> otps;
+		otps.reserve(static_cast<std::size_t>(count));
+
+		for(int row = first; row <= last; ++row) {
+			otps.push_back(sourceOtp(row));
+			m_index.add(otps.back());
+		}
+
+		// only the rows after the insertion move, so appending an OTP doesn't visit the others
+		if(!m_sourceRowsDirty) {
+			m_sourceOtps.insert(m_sourceOtps.cbegin() + first, otps.cbegin(), otps.cend());
+
+			for(auto row = static_cast<std::size_t>(first); row < m_sourceOtps.size(); ++row) {
+				m_sourceRows[m_sourceOtps[row]] = static_cast<int>(row);
+			}
+		}
+
+		bool shifted = false;
+
+		for(auto & row : m_rows) {
+			if(row >= first) {
+				row += count;
+				shifted = true;
+			}
+		}
+
+		if(shifted) {
+			rebuildProxyRows();
+		}
+
+		for(int sourceRow = first; sourceRow <= last; ++sourceRow) {
+			const auto rank = m_index.rank(otps[static_cast<std::size_t>(sourceRow - first)], m_filterText);
+
+			if(!rank) {
+				continue;
+			}
+
+			const auto position = static_cast<int>(std::upper_bound(m_ranks.cbegin(), m_ranks.cend(), *rank, &OtpSearchIndex::ranksBefore) - m_ranks.cbegin());
+			beginInsertRows({}, position, position);
+			m_rows.insert(m_rows.cbegin() + position, sourceRow);
+			m_ranks.insert(m_ranks.cbegin() + position, *rank);
+
+			for(int row = position, rowCount = static_cast<int>(m_rows.size()); row < rowCount; ++row) {
+				m_proxyRows[m_rows[static_cast<std::size_t>(row)]] = row;
+			}
+
+			endInsertRows();
+		}
+	}
+
+	void OtpFilterModel::onSourceRowsAboutToBeRemoved(const QModelIndex &, int first, int last)
+	{
+		if(!m_filtered) {
+			beginRemoveRows({}, first, last);
+			return;
+		}
+
+		// the matches go before the source rows do, so the remaining rows still map to valid source rows in the
+		// meantime. adjacent matches are removed together, working from the end so that earlier rows don't move
+		const auto isRemoved = [this, first, last](int row) {
+			const auto sourceRow = m_rows[static_cast<std::size_t>(row)];
+			return first <= sourceRow && sourceRow <= last;
+		};
+
+		for(auto row = static_cast<int>(m_rows.size()) - 1; 0 <= row; --row) {
+			if(!isRemoved(row)) {
+				continue;
+			}
+
+			auto runStart = row;
+
+			while(0 < runStart && isRemoved(runStart - 1)) {
+				--runStart;
+			}
+
+			beginRemoveRows({}, runStart, row);
+
+			for(auto removed = runStart; removed <= row; ++removed) {
+				m_proxyRows.erase(m_rows[static_cast<std::size_t>(removed)]);
+			}
+
+			m_rows.erase(m_rows.cbegin() + runStart, m_rows.cbegin() + row + 1);
+			m_ranks.erase(m_ranks.cbegin() + runStart, m_ranks.cbegin() + row + 1);
+
+			for(int moved = runStart, rowCount = static_cast<int>(m_rows.size()); moved < rowCount; ++moved) {
+				m_proxyRows[m_rows[static_cast<std::size_t>(moved)]] = moved;
+			}
+
+			endRemoveRows();
+			row = runStart;
+		}
+	}
+
+	void OtpFilterModel::onSourceRowsRemoved(const QModelIndex &, int first, int last)
+	{
+		// OtpListModel reports removals after the OTP has left the Application, so the OTP can't be looked up from the
+		// source model here. the index drops it when it's destroyed
+		if(!m_filtered) {
+			m_sourceRowsDirty = true;
+			endRemoveRows();
+			return;
+		}
+
+		const auto count = last - first + 1;
+
+		if(!m_sourceRowsDirty) {
+			const auto removedBegin = m_sourceOtps.cbegin() + first;
+			const auto removedEnd = m_sourceOtps.cbegin() + last + 1;
+
+			std::for_each(removedBegin, removedEnd, [this](const Otp * otp) {
+				m_sourceRows.erase(otp);
+			});
+
+			m_sourceOtps.erase(removedBegin, removedEnd);
+
+			for(auto row = static_cast<std::size_t>(first); row < m_sourceOtps.size(); ++row) {
+				m_sourceRows[m_sourceOtps[row]] = static_cast<int>(row);
+			}
+		}
+
+		bool shifted = false;
+
+		for(auto & row : m_rows) {
+			if(row > last) {
+				row -= count;
+				shifted = true;
+			}
+		}
+
+		if(shifted) {
+			rebuildProxyRows();
+		}
+	}
+
+	void OtpFilterModel::onSourceAboutToBeReset()
+	{
+		beginResetModel();
+	}
+
+	void OtpFilterModel::onSourceReset()
+	{
+		m_index.clear();
+		indexSourceRows(0, sourceModel()->rowCount() - 1);
+		m_sourceRowsDirty = true;
+		refilter();
+		endResetModel();
+	}
+}	// namespace Qonvince
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_OTPFILTERMODEL_H
+#define QONVINCE_OTPFILTERMODEL_H
+
+#include <unordered_map>
+#include <vector>
+#include <QAbstractProxyModel>
+#include <QString>
+
+#include "otpsearchindex.h"
+
+namespace Qonvince
+{
+	class Otp;
+
+	/**
+	 * Presents the rows of an OtpListModel that match a search, best match first.
+	 *
+	 * With no filter text the model passes the source rows through unchanged, in their own order. With filter text, the
+	 * rows are those the search index finds for it (see OtpSearchIndex) and the model is reset each time the text
+	 * changes. OTPs added to or removed from the source while filtered are inserted at their rank or removed, without
+	 * searching again. OTPs can't be reordered by drag and drop while the list is filtered because the filtered order
+	 * isn't the order of the list.
+	 */
+	class OtpFilterModel
+	: public QAbstractProxyModel
+	{
+		Q_OBJECT
+
+	public:
+		explicit OtpFilterModel(QObject * parent = nullptr);
+		~OtpFilterModel() override;
+
+		void setSourceModel(QAbstractItemModel * sourceModel) override;
+
+		[[nodiscard]] inline const QString & filterText() const
+		{
+			return m_filterText;
+		}
+
+		[[nodiscard]] inline bool isFiltered() const
+		{
+			return m_filtered;
+		}
+
+		// the source row shown in a row of this model, or -1 if there is no such row
+		[[nodiscard]] int sourceRow(int row) const;
+
+		[[nodiscard]] QModelIndex index(int row, int column, const QModelIndex & parent = {}) const override;
+		[[nodiscard]] QModelIndex parent(const QModelIndex & child) const override;
+		[[nodiscard]] int rowCount(const QModelIndex & parent = {}) const override;
+		[[nodiscard]] int columnCount(const QModelIndex & parent = {}) const override;
+		[[nodiscard]] QModelIndex mapToSource(const QModelIndex & proxyIndex) const override;
+		[[nodiscard]] QModelIndex mapFromSource(const QModelIndex & sourceIndex) const override;
+		[[nodiscard]] Qt::ItemFlags flags(const QModelIndex & index) const override;
+		[[nodiscard]] bool canDropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column, const QModelIndex & parent) const override;
+		bool dropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column, const QModelIndex & parent) override;
+
+	public Q_SLOTS:
+		void setFilterText(const QString & text);
+
+		// rank the OTP ahead of other equally good matches in future searches
+		void noteUse(Otp * otp);
+
+	private:
+		[[nodiscard]] Otp * sourceOtp(int sourceRow) const;
+		void indexSourceRows(int first, int last);
+
+		// run the search again and find the source rows of the matches. doesn't emit any signals
+		void refilter();
+
+		// find the filtered row of each match's source row again after m_rows has changed
+		void rebuildProxyRows();
+
+		void onSourceDataChanged(const QModelIndex & topLeft, const QModelIndex & bottomRight, const QVector<int> & roles);
+		void onSourceRowsAboutToBeInserted(const QModelIndex & parent, int first, int last);
+		void onSourceRowsInserted(const QModelIndex & parent, int first, int last);
+		void onSourceRowsAboutToBeRemoved(const QModelIndex & parent, int first, int last);
+		void onSourceRowsRemoved(const QModelIndex & parent, int first, int last);
+		void onSourceAboutToBeReset();
+		void onSourceReset();
+
+		OtpSearchIndex m_index;
+		QString m_filterText;
+		bool m_filtered;
+
+		// while filtered, the source rows of the matches in rank order, their ranks, and the reverse mapping. the ranks
+		// are those at the time of the search, so that OTPs added later are placed consistently with the rows shown
+		std::vector<int> m_rows;
+		std::vector<OtpSearchIndex::Rank> m_ranks;
+		std::unordered_map<int, int> m_proxyRows;
+
+		// the source row of each OTP, and the OTP in each source row. built when first needed after the source rows
+		// last changed without being tracked, and kept up to date as rows are inserted and removed while filtered
+		std::unordered_map<const Otp *, int> m_sourceRows;
+		std::vector<const Otp *> m_sourceOtps;
+		bool m_sourceRowsDirty;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_OTPFILTERMODEL_H
@@ -29,9 +29,11 @@
 
 #include <QPen>
 #include <QPainter>
+#include <QPixmap>
 #include <QScreen>
 #include <optional>
 
+#include "clock.h"
 #include "otp.h"
 #include "otplistmodel.h"
 
@@ -45,8 +47,12 @@ namespace
     constexpr const auto ItemHeight = OtpIconExtent + (2 * SpacingSize);
     constexpr const QSize OtpIconSize = {OtpIconExtent, OtpIconExtent};
     constexpr const auto CountdownSizeRatio = 0.5L;  // ratio of counter size to item height
-    constexpr const auto CountdownWarningThreshold = 8;
-    constexpr const auto CountdownCriticalThreshold = 4;
+
+    // smooth countdowns move in steps this long, which keeps the number of cached pies down
+    constexpr const qint64 SmoothCountdownStep = 50;
+
+    // a few intervals' worth of countdown states in each of the colours
+    constexpr const std::size_t MaxCountdownPixmaps = 512;
 }
 
 namespace Qonvince
@@ -54,63 +60,182 @@ namespace Qonvince
     OtpListItemDelegate::OtpListItemDelegate()
             : m_countdownWarningColour(-1, -1, -1),
               m_countdownCriticalColour(-1, -1, -1),
-              m_actionIconAreaWidth(0)
+              m_actionIconAreaWidth(0),
+              m_smoothCountdowns(false)
     {
     }
 
-    // TODO this code needs an efficiency review
-    void OtpListItemDelegate::paint(QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index) const
+    void OtpListItemDelegate::beginFrame(qint64 msecsSinceEpoch)
     {
-        auto * screen = option.widget->screen();
-        auto spacing = qonvinceApp->referencePxToScreenPx(SpacingSize, screen);
-        painter->save();
-        painter->setRenderHint(QPainter::Antialiasing, true);
-        painter->translate(option.rect.topLeft());
+        m_frameTime = msecsSinceEpoch;
+        m_countdownCohorts.clear();
+    }
+
+    QRect OtpListItemDelegate::countdownRect(const QRect & itemRect, const QScreen * screen) const
+    {
+        // a pixel all round for the anti-aliased edge
+        return layout(itemRect.size(), screen).timerRect.translated(itemRect.topLeft()).toAlignedRect().adjusted(-1, -1, 1, 1) & itemRect;
+    }
+
+    int OtpListItemDelegate::timeToNextCode(qint64 baselineSecSinceEpoch, int interval) const
+    {
+        for (const auto & cohort : m_countdownCohorts) {
+            if (cohort.baselineSecSinceEpoch == baselineSecSinceEpoch && cohort.interval == interval) {
+                return cohort.timeToNextCode;
+            }
+        }
+
+        // until the view has begun a frame the rows read the clock themselves
+        if (!m_frameTime) {
+            return Otp::timeToNextCodeAt(Clock::current().secsSinceEpoch(), baselineSecSinceEpoch, interval);
+        }
+
+        const auto countdown = Otp::timeToNextCodeAt(*m_frameTime / 1000, baselineSecSinceEpoch, interval);
+        m_countdownCohorts.push_back({baselineSecSinceEpoch, interval, countdown});
+        return countdown;
+    }
+
+    int OtpListItemDelegate::countdownSpan(int timeToNextCode, qint64 baselineSecSinceEpoch, int interval) const
+    {
+        // pies take angles in 1/16ths of a degree anticlockwise from 3 o'clock
+        // so 5760 is a full circle
+        if (!m_smoothCountdowns || !m_frameTime || CountdownCriticalThreshold < timeToNextCode) {
+            return 5760 * timeToNextCode / interval;
+        }
+
+        const qint64 intervalMs = interval * 1000;
+        auto remaining = intervalMs - ((*m_frameTime - (baselineSecSinceEpoch * 1000)) % intervalMs);
+        remaining = ((remaining + SmoothCountdownStep - 1) / SmoothCountdownStep) * SmoothCountdownStep;
+        return static_cast<int>(5760 * remaining / intervalMs);
+    }
+
+    const OtpListItemDelegate::Layout & OtpListItemDelegate::layout(const QSize & itemSize, const QScreen * screen) const
+    {
+        const auto dotsPerInch = screen->physicalDotsPerInchY();
+
+        if (m_layout && m_layout->itemSize == itemSize && m_layout->dotsPerInch == dotsPerInch && m_layout->actionIconAreaWidth == actionIconAreaWidth()) {
+            return *m_layout;
+        }
+
+        Layout layout;
+        layout.itemSize = itemSize;
+        layout.dotsPerInch = dotsPerInch;
+        layout.actionIconAreaWidth = actionIconAreaWidth();
+        layout.spacing = qonvinceApp->referencePxToScreenPx(SpacingSize, screen);
 
         // this should be the correct size for the screen pixel density since sizeHint(), where the option rect comes from, already accounts for that
-        QRect itemRect({0, 0}, option.rect.size());
-        auto height = itemRect.height();
+        auto height = itemSize.height();
         auto timerRectSize = static_cast<int>(height * CountdownSizeRatio);
+        auto textLeft = static_cast<int>(qonvinceApp->referencePxToScreenPx(OtpIconExtent + (2 * SpacingSize), screen));
+
+        layout.iconRect = QRect({layout.spacing, layout.spacing,}, qonvinceApp->referencePxToScreenPx(OtpIconSize, screen));
+        layout.timerRect = QRectF({0.5 + itemSize.width() - 1 - timerRectSize - actionIconAreaWidth(), 0.5 + ((height - timerRectSize) / 2.0)},
+                                  QSize(timerRectSize, timerRectSize));
+        layout.codeRect = QRect({textLeft, 0,},
+                                QPoint(static_cast<int>(layout.timerRect.left()) - static_cast<int>(qonvinceApp->referencePxToScreenPx(SpacingSize + SpacingSize, screen)),
+                                       height - 1));
+        layout.nameRect = QRect(textLeft, 0, 0, height);
+        layout.nameRect.setRight(layout.codeRect.right());
+        m_layout = layout;
+        return *m_layout;
+    }
 
-        QRect iconRect({spacing, spacing,}, qonvinceApp->referencePxToScreenPx(OtpIconSize, screen));
-        QRectF timerRect({0.5 + itemRect.right() - timerRectSize - actionIconAreaWidth(), 0.5 + ((height - timerRectSize) / 2.0)},
-                         QSize(timerRectSize, timerRectSize));
-        QRect codeRect(
-                {
-                        static_cast<int>(qonvinceApp->referencePxToScreenPx(OtpIconExtent + (2 * SpacingSize), screen)),
-                        0,
-                },
-                QPoint(static_cast<int>(timerRect.left()) - static_cast<int>(qonvinceApp->referencePxToScreenPx(SpacingSize + SpacingSize, screen)),
-                       height - 1));
+    const OtpListItemDelegate::Fonts & OtpListItemDelegate::fonts(const QFont & font, int height) const
+    {
+        if (m_fonts && m_fonts->base == font && m_fonts->height == height) {
+            return *m_fonts;
+        }
 
-        QString codeString;
+        Fonts fonts{font, height, font, font};
+        fonts.name.setBold(false);
+        fonts.name.setPixelSize(qMax(static_cast<int>(font.pixelSize() * 1.2), static_cast<int>(height / 3)));
+        fonts.code.setBold(true);
+        fonts.code.setPixelSize(height / 2);
+        m_fonts = fonts;
 
-        // only show the code if it's not hidden, or is hidden but user has manually
-        // revealed it and it's not timed out
-        bool showCode = index.data(OtpListModel::IsRevealedRole).toBool();
+        // the prepared code text is only valid for the font it was prepared with
+        m_codeTexts.clear();
+        return *m_fonts;
+    }
 
-        if (showCode) {
-            codeString = index.data(OtpListModel::CodeRole).toString();
+    const QStaticText & OtpListItemDelegate::codeText(const QString & code, const QFont & font) const
+    {
+        if (auto * text = m_codeTexts.object(code); text) {
+            return *text;
         }
 
-        auto displayName = index.data(OtpListModel::LabelRole).toString();
-        auto icon = index.data(OtpListModel::IconRole).value<QIcon>();
-        auto codeType = static_cast<OtpType>(index.data(OtpListModel::TypeRole).toInt());
-        auto countdown = index.data(OtpListModel::TimeToNextCodeRole).toInt();
-        auto interval = index.data(OtpListModel::IntervalRole).toInt();
+        auto * text = new QStaticText(code);
+        text->setTextFormat(Qt::PlainText);
+        text->setPerformanceHint(QStaticText::AggressiveCaching);
+        text->prepare(QTransform(), font);
+        m_codeTexts.insert(code, text);
+        return *text;
+    }
 
-        if (0 == interval) {
-            interval = Otp::DefaultInterval;
+    const QPixmap & OtpListItemDelegate::countdownPixmap(int extent, int span, const QColor & fill, const QColor & outline, qreal devicePixelRatio) const
+    {
+        const CountdownPixmapKey key = {extent, span, fill.rgba(), outline.rgba(), devicePixelRatio};
+
+        if (const auto cached = m_countdownPixmaps.find(key); m_countdownPixmaps.end() != cached) {
+            return cached->second;
         }
 
-        if (displayName.isEmpty()) {
-            displayName = tr("<unnamed>");
+        // only reached when the palette, custom colours or screen keep changing
+        if (MaxCountdownPixmaps <= m_countdownPixmaps.size()) {
+            m_countdownPixmaps.clear();
         }
 
-        if (showCode && codeString.isEmpty()) {
-            codeString = tr("<no code>");
+        // an extra pixel so that the half-pixel offset used for crisp outlines stays inside the pixmap
+        QPixmap pixmap(QSize(extent + 1, extent + 1) * devicePixelRatio);
+        pixmap.setDevicePixelRatio(devicePixelRatio);
+        pixmap.fill(Qt::transparent);
+
+        QPainter painter(&pixmap);
+        QRectF timerRect(0.5, 0.5, extent, extent);
+        QPen timerPen(outline);
+        timerPen.setWidthF(0.5);
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.setPen(Qt::transparent);
+        painter.setBrush(fill);
+
+        // pies take angles in 1/16ths of a degree anticlockwise from 3 o'clock
+        // so 5760 is a full circle, 1440 is a quarter circle and represents
+        // 12 o'clock
+        painter.drawPie(timerRect, 1440, span);
+        painter.setPen(timerPen);
+        painter.setBrush(Qt::transparent);
+        painter.drawEllipse(timerRect);
+        painter.end();
+
+        return m_countdownPixmaps.emplace(key, std::move(pixmap)).first->second;
+    }
+
+    void OtpListItemDelegate::paint(QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index) const
+    {
+        const auto * row = index.data(OtpListModel::SnapshotRole).value<const OtpRowSnapshot *>();
+
+        if (!row) {
+            return;
         }
 
+        const auto & layout = this->layout(option.rect.size(), option.widget->screen());
+        const auto & fonts = this->fonts(painter->font(), option.rect.height());
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing, true);
+        painter->translate(option.rect.topLeft());
+
+        // only show the code if it's not hidden, or is hidden but user has manually
+        // revealed it and it's not timed out
+        const bool showCode = row->isRevealed;
+        const auto codeType = row->type;
+        const auto interval = (0 == row->interval ? Otp::DefaultInterval : row->interval);
+
+        // HOTP rows have no countdown
+        const auto countdown = (OtpType::Totp == codeType ? timeToNextCode(row->baselineSecSinceEpoch, interval) : 0);
+        const auto displayName = (row->label.isEmpty() ? tr("<unnamed>") : row->label);
+        const auto codeString = (showCode && row->code.isEmpty() ? tr("<no code>") : row->code);
+        const auto & icon = row->icon;
+
         QPen itemPen = painter->pen();
         QBrush backgroundBrush = option.palette.base();
 
@@ -121,10 +246,10 @@ namespace Qonvince
             backgroundBrush = option.palette.alternateBase();
         }
 
-        painter->fillRect(itemRect, backgroundBrush);
+        painter->fillRect(QRect({0, 0}, layout.itemSize), backgroundBrush);
 
         if (!icon.isNull()) {
-            icon.paint(painter, iconRect);
+            icon.paint(painter, layout.iconRect);
         }
 
         if (CountdownWarningThreshold >= countdown && OtpType::Totp == codeType) {
@@ -133,53 +258,35 @@ namespace Qonvince
             painter->setPen(itemPen);
         }
 
-        QFont nameFont = painter->font();
-        QFont codeFont = nameFont;
-        nameFont.setBold(false);
-        nameFont.setPixelSize(qMax(static_cast<int>(nameFont.pixelSize() * 1.2), static_cast<int>(height / 3)));
-        codeFont.setBold(true);
-        codeFont.setPixelSize(height / 2);
-
-        QRect nameRect(static_cast<int>(qonvinceApp->referencePxToScreenPx(OtpIconExtent + (2 * SpacingSize), screen)), 0, 0, height);
+        QRect nameRect = layout.nameRect;
 
         if (showCode) {
-            painter->setFont(codeFont);
-            painter->drawText(codeRect, Qt::AlignVCenter | Qt::TextSingleLine | Qt::AlignRight, codeString, &codeRect);
-            nameRect.setRight(codeRect.left() - spacing - spacing);
-        } else {
-            nameRect.setRight(codeRect.right());
+            const auto & code = codeText(codeString, fonts.code);
+            const auto codeSize = code.size();
+            const auto codeLeft = layout.codeRect.right() + 1 - codeSize.width();
+            painter->setFont(fonts.code);
+            painter->drawStaticText(QPointF(codeLeft, layout.codeRect.top() + ((layout.codeRect.height() - codeSize.height()) / 2.0)), code);
+            nameRect.setRight(static_cast<int>(codeLeft) - layout.spacing - layout.spacing);
         }
 
         // draw the countdown
         if (OtpType::Totp == codeType) {
             auto countdownColour = option.palette.color(QPalette::WindowText).lighter(150);
-            QPen timerPen(countdownColour);
-            timerPen.setWidthF(0.5);
-            QBrush timerBrush(countdownColour);
+            auto fillColour = countdownColour;
 
             if (CountdownCriticalThreshold >= countdown && m_countdownCriticalColour.isValid()) {
-                timerBrush.setColor(m_countdownCriticalColour);
+                fillColour = m_countdownCriticalColour;
             } else if (CountdownWarningThreshold >= countdown && m_countdownWarningColour.isValid()) {
-                timerBrush.setColor(m_countdownWarningColour);
+                fillColour = m_countdownWarningColour;
             }
 
-            painter->save();
-            painter->setPen(Qt::transparent);
-            painter->setRenderHint(QPainter::Antialiasing, true);
-            painter->setBrush(timerBrush);
-
-            // pies take angles in 1/16ths of a degree anticlockwise from 3 o'clock
-            // so 5760 is a full circle, 1440 is a quarter circle and represents
-            // 12 o'clock
-            painter->drawPie(timerRect, 1440, (5760 * countdown / interval));
-            painter->setPen(timerPen);
-            painter->setBrush(Qt::transparent);
-            painter->drawEllipse(timerRect);
-            painter->restore();
+            const auto & pixmap = countdownPixmap(static_cast<int>(layout.timerRect.width()), countdownSpan(countdown, row->baselineSecSinceEpoch, interval), fillColour, countdownColour,
+                                                  painter->device()->devicePixelRatioF());
+            painter->drawPixmap(layout.timerRect.topLeft() - QPointF(0.5, 0.5), pixmap);
         }
 
         // draw the name after the code to ensure the name does not bleed into the code
-        painter->setFont(nameFont);
+        painter->setFont(fonts.name);
         itemPen.setColor(itemPen.color().lighter(200));
         painter->setPen(itemPen);
         painter->drawText(nameRect, Qt::AlignVCenter | Qt::TextSingleLine | Qt::AlignLeft, displayName);
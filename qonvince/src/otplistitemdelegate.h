@@ -20,8 +20,17 @@
 #ifndef QONVINCE_OTPLISTITEMDELEGATE_H
 #define QONVINCE_OTPLISTITEMDELEGATE_H
 
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <QCache>
+#include <QFont>
+#include <QPixmap>
+#include <QStaticText>
 #include <QStyledItemDelegate>
 
+class QScreen;
+
 namespace Qonvince
 {
     // Q_OBJECT macro is omitted because currently it's only required if using signals/slots/properties
@@ -29,10 +38,20 @@ namespace Qonvince
             : public QStyledItemDelegate
     {
     public:
+        // the code is drawn in a colour that depends on the countdown from this many seconds before it expires
+        static constexpr const int CountdownWarningThreshold = 8;
+        static constexpr const int CountdownCriticalThreshold = 4;
+
         // doesn't take parent arg because we only ever use objects of this class as
         // smart pointers
         OtpListItemDelegate();
 
+        // the time (milliseconds since the epoch) that all the rows painted until the next call show their countdowns for
+        void beginFrame(qint64 msecsSinceEpoch);
+
+        // the part of an item occupied by its countdown, which is all that changes from one second to the next
+        [[nodiscard]] QRect countdownRect(const QRect & itemRect, const QScreen * screen) const;
+
         void paint(QPainter *, const QStyleOptionViewItem &, const QModelIndex &) const override;
         [[nodiscard]] QSize sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const override;
 
@@ -78,12 +97,102 @@ namespace Qonvince
             m_actionIconAreaWidth = width;
         }
 
+        // whether countdowns under the critical threshold are drawn to the millisecond rather than the second
+        [[nodiscard]] inline bool smoothCountdowns() const
+        {
+            return m_smoothCountdowns;
+        }
+
+        inline void setSmoothCountdowns(bool smooth)
+        {
+            m_smoothCountdowns = smooth;
+        }
+
     private:
+        // OTPs with the same interval and baseline time always have the same countdown
+        struct CountdownCohort
+        {
+            qint64 baselineSecSinceEpoch;
+            int interval;
+            int timeToNextCode;
+        };
+
+        // where everything goes in an item, which only changes when the item size or screen changes
+        struct Layout
+        {
+            QSize itemSize;
+            qreal dotsPerInch;
+            int actionIconAreaWidth;
+            int spacing;
+            QRect iconRect;
+            QRectF timerRect;
+            QRect codeRect;
+            QRect nameRect;
+        };
+
+        // the fonts derived from the painter's font, which only change when the style or item height changes
+        struct Fonts
+        {
+            QFont base;
+            int height;
+            QFont name;
+            QFont code;
+        };
+
+        struct CountdownPixmapKey
+        {
+            int extent;
+            int span;
+            QRgb fill;
+            QRgb outline;
+            qreal devicePixelRatio;
+
+            bool operator==(const CountdownPixmapKey &) const = default;
+        };
+
+        struct CountdownPixmapKeyHash
+        {
+            std::size_t operator()(const CountdownPixmapKey & key) const noexcept
+            {
+                auto hash = std::hash<qreal>()(key.devicePixelRatio);
+
+                for (const std::size_t value : {static_cast<std::size_t>(key.extent), static_cast<std::size_t>(key.span), static_cast<std::size_t>(key.fill), static_cast<std::size_t>(key.outline)}) {
+                    hash = (hash * 31) + value;
+                }
+
+                return hash;
+            }
+        };
+
+        [[nodiscard]] int timeToNextCode(qint64 baselineSecSinceEpoch, int interval) const;
+
+        // the angle of the countdown pie in 1/16ths of a degree
+        [[nodiscard]] int countdownSpan(int timeToNextCode, qint64 baselineSecSinceEpoch, int interval) const;
+        [[nodiscard]] const Layout & layout(const QSize & itemSize, const QScreen * screen) const;
+        [[nodiscard]] const Fonts & fonts(const QFont & font, int height) const;
+        [[nodiscard]] const QStaticText & codeText(const QString & code, const QFont & font) const;
+
+        // the countdown pie and its outline, pre-rendered for blitting
+        [[nodiscard]] const QPixmap & countdownPixmap(int extent, int span, const QColor & fill, const QColor & outline, qreal devicePixelRatio) const;
+
         QColor m_countdownWarningColour;
         QColor m_countdownCriticalColour;
 
         // how many pixels to the right of each item are occupied by the widget's reveal/copy/refresh/remove actions
         int m_actionIconAreaWidth;
+        bool m_smoothCountdowns;
+
+        std::optional<qint64> m_frameTime;
+
+        // almost all OTPs use the default interval and baseline so a handful of cohorts covers the whole list
+        mutable std::vector<CountdownCohort> m_countdownCohorts;
+
+        mutable std::optional<Layout> m_layout;
+        mutable std::optional<Fonts> m_fonts;
+
+        // enough for every code in a long list to be laid out once, plus the next codes for the visible ones
+        mutable QCache<QString, QStaticText> m_codeTexts{1024};
+        mutable std::unordered_map<CountdownPixmapKey, QPixmap, CountdownPixmapKeyHash> m_countdownPixmaps;
     };
 }  // namespace Qonvince
 
@@ -27,7 +27,9 @@
 
 #include "otplistmodel.h"
 
+#include <algorithm>
 #include <numeric>
+#include <QTimer>
 #include <QString>
 #include <QStringBuilder>
 #include <QMimeData>
@@ -48,9 +50,10 @@ namespace Qonvince
 		// these connections ensure that the model emits the appropriate
 		// signals when this occurs
 		// the model itself is read-only
-		connect(qonvinceApp, qOverload<int, Otp *>(&Application::otpAdded), this, [this](int index) {
+		connect(qonvinceApp, qOverload<int, Otp *>(&Application::otpAdded), this, [this](int index, Otp * otp) {
 			beginInsertRows({}, index, index);
 			endInsertRows();
+			watchOtp(otp);
 		});
 
 		connect(qonvinceApp, qOverload<int>(&Application::otpRemoved), this, [this](int index) {
@@ -59,9 +62,136 @@ namespace Qonvince
 		});
 
 		connect(qonvinceApp, qOverload<int>(&Application::otpChanged), this, [this](int otpIndex) {
-			const auto itemIndex = index(otpIndex, 0);
-			Q_EMIT dataChanged(itemIndex, itemIndex);
+			auto * otp = qonvinceApp->otp(otpIndex);
+			m_snapshots.erase(otp);
+			queueChange(otp, ChangeScope::AllRoles);
 		});
+
+		// the labels depend on the display style
+		connect(&(qonvinceApp->settings()), qOverload<CodeLabelDisplayStyle>(&Settings::codeLabelDisplayStyleChanged), this, [this]() {
+			m_snapshots.clear();
+		});
+
+		for(int idx = 0; idx < qonvinceApp->otpCount(); ++idx) {
+			watchOtp(qonvinceApp->otp(idx));
+		}
+	}
+
+	void OtpListModel::watchOtp(Otp * otp)
+	{
+		// snapshots are keyed on the Otp rather than the row so that they survive OTPs being inserted, removed and moved
+		connect(otp, &QObject::destroyed, this, [this, otp]() {
+			m_snapshots.erase(otp);
+			m_pendingChanges.erase(otp);
+		});
+
+		// new codes don't change the Otp's properties so they aren't reported by Application::otpChanged()
+		connect(otp, &Otp::newCodeGenerated, this, [this, otp]() {
+			m_snapshots.erase(otp);
+			queueChange(otp, ChangeScope::Code);
+		});
+
+		// neither are icons that have finished loading
+		connect(otp, &Otp::iconChanged, this, [this, otp]() {
+			m_snapshots.erase(otp);
+			queueChange(otp, ChangeScope::AllRoles);
+		});
+	}
+
+	void OtpListModel::queueChange(const Otp * otp, ChangeScope scope)
+	{
+		if(!otp) {
+			return;
+		}
+
+		auto & pendingScope = m_pendingChanges[otp];
+		pendingScope = std::max(pendingScope, scope);
+
+		if(!m_changeFlushQueued) {
+			m_changeFlushQueued = true;
+			QTimer::singleShot(0, this, [this]() {
+				flushChanges();
+			});
+		}
+	}
+
+	void OtpListModel::flushChanges()
+	{
+		m_changeFlushQueued = false;
+
+		if(m_pendingChanges.empty()) {
+			return;
+		}
+
+		const auto pendingChanges = std::move(m_pendingChanges);
+		m_pendingChanges.clear();
+
+		// one pass over the rows rather than a search for each changed Otp, so that a rollover of thousands of codes
+		// stays linear. rows are reported in runs of adjacent rows with the same scope
+		const auto emitRun = [this](int first, int last, ChangeScope scope) {
+			if(ChangeScope::Code == scope) {
+				Q_EMIT dataChanged(index(first, 0), index(last, 0), {CodeRole, Qt::DisplayRole, SnapshotRole});
+			}
+			else {
+				Q_EMIT dataChanged(index(first, 0), index(last, 0));
+			}
+		};
+
+		int runStart = -1;
+		auto runScope = ChangeScope::Code;
+
+		for(int row = 0, count = qonvinceApp->otpCount(); row < count; ++row) {
+			const auto change = pendingChanges.find(qonvinceApp->otp(row));
+
+			if(pendingChanges.cend() != change && (0 > runStart || change->second == runScope)) {
+				if(0 > runStart) {
+					runStart = row;
+					runScope = change->second;
+				}
+
+				continue;
+			}
+
+			if(0 <= runStart) {
+				emitRun(runStart, row - 1, runScope);
+				runStart = -1;
+			}
+
+			// a changed row with a different scope starts the next run
+			if(pendingChanges.cend() != change) {
+				runStart = row;
+				runScope = change->second;
+			}
+		}
+
+		if(0 <= runStart) {
+			emitRun(runStart, qonvinceApp->otpCount() - 1, runScope);
+		}
+	}
+
+	const OtpRowSnapshot * OtpListModel::snapshot(Otp * otp) const
+	{
+		if(const auto snapshot = m_snapshots.find(otp); m_snapshots.end() != snapshot) {
+			return &(snapshot->second);
+		}
+
+		OtpRowSnapshot snapshot = {
+			otpLabel(otp),
+			{},
+			otp->icon(),
+			otp->baselineSecSinceEpoch(),
+			otp->interval(),
+			otp->type(),
+			otp->codeIsVisible(),
+		};
+
+		// hidden codes are not copied out of secure storage
+		if(snapshot.isRevealed) {
+			const auto & code = otp->code();
+			snapshot.code = QString::fromUtf8(code.data(), static_cast<int>(code.size()));
+		}
+
+		return &(m_snapshots.emplace(otp, std::move(snapshot)).first->second);
 	}
 
 	QVariant OtpListModel::headerData(int section, Qt::Orientation, int role) const
@@ -83,10 +213,15 @@ namespace Qonvince
 
 		switch(role) {
 			case Qt::EditRole:
-				return data(index, LabelRole);
+				return snapshot(otp)->label;
+
+			case Qt::DisplayRole: {
+				const auto & code = otp->code();
+				return static_cast<QString>(snapshot(otp)->label % ' ' % QString::fromUtf8(code.data(), static_cast<int>(code.size())));
+			}
 
-			case Qt::DisplayRole:
-				return static_cast<QString>(data(index, LabelRole).toString() % ' ' % data(index, CodeRole).toString());
+			case SnapshotRole:
+				return QVariant::fromValue(snapshot(otp));
 
 			case OtpRole:
 				return QVariant::fromValue(otp);
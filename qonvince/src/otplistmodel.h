@@ -20,10 +20,34 @@
 #ifndef QONVINCE_OTPLISTMODEL_H
 #define QONVINCE_OTPLISTMODEL_H
 
+#include <unordered_map>
 #include <QAbstractListModel>
+#include <QIcon>
+#include <QString>
+
+#include "types.h"
 
 namespace Qonvince
 {
+    class Otp;
+
+    /**
+     * Everything the list delegate needs to paint a row.
+     *
+     * The code is only present while it is revealed. The countdown is not stored because it changes every second;
+     * the delegate works it out for each frame from the interval and baseline time.
+     */
+    struct OtpRowSnapshot
+    {
+        QString label;
+        QString code;
+        QIcon icon;
+        qint64 baselineSecSinceEpoch;
+        int interval;
+        OtpType type;
+        bool isRevealed;
+    };
+
     class OtpListModel
             : public QAbstractListModel
     {
@@ -42,6 +66,9 @@ namespace Qonvince
         static constexpr const int RevealOnDemandRole = Qt::UserRole + 12;
         static constexpr const int IsRevealedRole = Qt::UserRole + 13;
 
+        // a const OtpRowSnapshot *, which remains valid until the model next reports a change to the row
+        static constexpr const int SnapshotRole = Qt::UserRole + 15;
+
         OtpListModel();
 
 		[[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
@@ -53,8 +80,31 @@ namespace Qonvince
 		[[nodiscard]] QMimeData * mimeData(const QModelIndexList & idx) const override;
 		[[nodiscard]] bool canDropMimeData(const QMimeData * data, Qt::DropAction action, int row, int col, const QModelIndex & parent) const override;
 		bool dropMimeData(const QMimeData * data, Qt::DropAction action, int row, int column, const QModelIndex & parent) override;
+
+	private:
+		// how much of a row a change affects; a row with both kinds of change is reported as changing all roles
+		enum class ChangeScope
+		{
+			Code = 0,
+			AllRoles,
+		};
+
+		void watchOtp(Otp * otp);
+		const OtpRowSnapshot * snapshot(Otp * otp) const;
+
+		// changes are collected until the event loop is next idle and reported as few ranges as possible
+		void queueChange(const Otp * otp, ChangeScope scope);
+		void flushChanges();
+
+		std::unordered_map<const Otp *, ChangeScope> m_pendingChanges;
+		bool m_changeFlushQueued = false;
+
+		// built on demand, and discarded whenever the Otp changes
+		mutable std::unordered_map<const Otp *, OtpRowSnapshot> m_snapshots;
 	};
 
 }  // namespace Qonvince
 
+Q_DECLARE_METATYPE(const Qonvince::OtpRowSnapshot *)
+
 #endif  // QONVINCE_OTPLISTMODEL_H
@@ -43,6 +43,7 @@ x  */
 #include "qtiostream.h"
 #include "functions.h"
 #include "application.h"
+#include "clock.h"
 #include "otp.h"
 #include "otplistmodel.h"
 #include "otpqrcodereader.h"
@@ -57,6 +58,9 @@ namespace
 	constexpr const int BackgroundTextVerticalOffset = 40;
 	constexpr const int ActionIconExtent = 14;
 	constexpr const int ActionIconHoverRectRounding = 3;
+
+	// how often smooth countdowns are repainted, in ms
+	constexpr const int SmoothCountdownInterval = 50;
 }	// namespace
 
 namespace Qonvince
@@ -66,10 +70,12 @@ namespace Qonvince
 	  m_tickTimerIsResynchronising(false),
 	  m_imageDropEnabled(OtpQrCodeReader::isAvailable()),
 	  m_tickTimerId(-1),
+	  m_smoothTimerId(-1),
 	  m_doubleClickWaitTimer(),
 	  m_receivedDoubleClickEvent(false),
 	  m_itemContextMenu(),
 	  m_model(std::make_unique<OtpListModel>()),
+	  m_filterModel(std::make_unique<OtpFilterModel>()),
 	  m_delegate(std::make_unique<OtpListItemDelegate>()),
 	  m_copy({QIcon::fromTheme("edit-copy", QIcon(":/icons/codeactions/copy")), {}}),
 	  m_refresh({QIcon::fromTheme("view-refresh", QIcon(":/icons/codeactions/refresh")), {}}),
@@ -91,7 +97,8 @@ namespace Qonvince
 		m_delegate->setCountdownWarningColour(QColor(160, 160, 92));
 		m_delegate->setCountdownCriticalColour(QColor(220, 78, 92));
 		m_delegate->setActionIconAreaWidth(static_cast<int>((4 * (actionExtent + spacing)) + spacing));
-		QListView::setModel(m_model.get());
+		m_filterModel->setSourceModel(m_model.get());
+		QListView::setModel(m_filterModel.get());
 		QListView::setItemDelegate(m_delegate.get());
 		setUniformItemSizes(true);
 		setAcceptDrops(true);
@@ -121,6 +128,10 @@ namespace Qonvince
 		});
 
 		connect(&(qonvinceApp->settings()), qOverload<CodeLabelDisplayStyle>(&Settings::codeLabelDisplayStyleChanged), this, qOverload<>(&OtpListView::update));
+		connect(&Clock::current(), &Clock::adjusted, this, &OtpListView::onClockAdjusted);
+		connect(qonvinceApp, &Application::otpCodeCopied, m_filterModel.get(), &OtpFilterModel::noteUse);
+		connect(&(qonvinceApp->settings()), qOverload<bool>(&Settings::smoothCountdownsChanged), this, &OtpListView::onSmoothCountdownsChanged);
+		onSmoothCountdownsChanged(qonvinceApp->settings().smoothCountdowns());
 
 		synchroniseTickTimer();
 	}
@@ -133,11 +144,21 @@ namespace Qonvince
 			return -1;
 		}
 
-		return index.row();
+		return m_filterModel->sourceRow(index.row());
 	}
 
 	OtpListView::~OtpListView() = default;
 
+	void OtpListView::setFilterText(const QString & text)
+	{
+		m_filterModel->setFilterText(text);
+
+		// the action icons belonged to whichever item was under the mouse before the rows changed
+		m_actionItemIndex = {};
+		m_actionIconHoverRect = {};
+		m_actionIconMouseClickStartRect = {};
+	}
+
 	void OtpListView::synchroniseTickTimer()
 	{
 		if(-1 != m_tickTimerId) {
@@ -151,7 +172,75 @@ namespace Qonvince
 		// actually generate the new code
 		// TODO could we obviate the need for this by synchronising both this and the code objects to a global sync
 		//  timer at application start?
-		m_tickTimerId = startTimer(50 + (QDateTime::currentMSecsSinceEpoch() % 1000), Qt::PreciseTimer);
+		m_tickTimerId = startTimer(50 + 1000 - (Clock::current().msecsSinceEpoch() % 1000), Qt::PreciseTimer);
+	}
+
+	void OtpListView::onClockAdjusted()
+	{
+		// the countdowns have jumped, so show them now and tick on the new second boundaries from now on
+		synchroniseTickTimer();
+		viewport()->update();
+	}
+
+	void OtpListView::onSmoothCountdownsChanged(bool smooth)
+	{
+		m_delegate->setSmoothCountdowns(smooth);
+
+		if(smooth && -1 == m_smoothTimerId) {
+			m_smoothTimerId = startTimer(SmoothCountdownInterval, Qt::PreciseTimer);
+		}
+		else if(!smooth && -1 != m_smoothTimerId) {
+			killTimer(m_smoothTimerId);
+			m_smoothTimerId = -1;
+		}
+	}
+
+	std::pair<int, int> OtpListView::visibleRows() const
+	{
+		// all items are the same height, so the rows at the top and bottom edges bound the visible rows
+		const auto first = indexAt({0, 0});
+
+		if(!first.isValid()) {
+			return {0, -1};
+		}
+
+		const auto last = indexAt({0, viewport()->height() - 1});
+		return {first.row(), last.isValid() ? last.row() : m_filterModel->rowCount() - 1};
+	}
+
+	QRegion OtpListView::countdownDamage(bool criticalOnly) const
+	{
+		const auto [first, last] = visibleRows();
+		const auto now = Clock::current().secsSinceEpoch();
+		const auto * screen = this->screen();
+		QRegion damage;
+
+		for(int row = first; row <= last; ++row) {
+			const auto * otp = qonvinceApp->otp(m_filterModel->sourceRow(row));
+
+			if(!otp || OtpType::Totp != otp->type()) {
+				continue;
+			}
+
+			const auto countdown = Otp::timeToNextCodeAt(now, otp->baselineSecSinceEpoch(), otp->interval());
+
+			if(criticalOnly && OtpListItemDelegate::CountdownCriticalThreshold < countdown) {
+				continue;
+			}
+
+			const auto itemRect = visualRect(m_filterModel->index(row, 0));
+
+			// the code's colour follows the countdown when it's about to expire, and goes back to normal when it does
+			// (i.e. when a whole interval remains)
+			if(!criticalOnly && (OtpListItemDelegate::CountdownWarningThreshold >= countdown || Otp::timeToNextCodeAt(0, 0, otp->interval()) == countdown)) {
+				damage += itemRect;
+			}
+			else {
+				damage += m_delegate->countdownRect(itemRect, screen);
+			}
+		}
+
+		return damage;
 	}
 
 	Otp * OtpListView::hoveredOtp() const
@@ -173,7 +262,10 @@ namespace Qonvince
 			m_tickTimerId = startTimer(1000, Qt::VeryCoarseTimer);
 		}
 
-		viewport()->update();
+		// the rest of each item only changes when its OTP does, and the model reports that
+		if(const auto damage = countdownDamage(false); !damage.isEmpty()) {
+			viewport()->update(damage);
+		}
 	}
 
 	bool OtpListView::event(QEvent * ev)
@@ -233,6 +325,15 @@ namespace Qonvince
 			return;
 		}
 
+		if(ev->timerId() == m_smoothTimerId) {
+			if(const auto damage = countdownDamage(true); !damage.isEmpty()) {
+				viewport()->update(damage);
+			}
+
+			ev->accept();
+			return;
+		}
+
 		QListView::timerEvent(ev);
 	}
 
@@ -584,6 +685,8 @@ namespace Qonvince
 								  tr("Drop QR code images here ..."));
 		}
 
+		// every row shows its countdown for the same instant, however long the frame takes
+		m_delegate->beginFrame(Clock::current().msecsSinceEpoch());
 		QListView::paintEvent(ev);
 
 		// render the action icon overlay
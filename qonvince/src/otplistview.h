@@ -20,18 +20,21 @@
 #ifndef QONVINCE_OTPLISTVIEW_H
 #define QONVINCE_OTPLISTVIEW_H
 
+#include <utility>
 #include <vector>
 
 #include <QListView>
 #include <QPushButton>
 #include <QMenu>
 #include <QColor>
+#include <QRegion>
 #include <QHash>
 #include <QBasicTimer>
 #include <QTimer>
 
 #include "otp.h"
 #include "otplistmodel.h"
+#include "otpfiltermodel.h"
 #include "otplistitemdelegate.h"
 
 class QEvent;
@@ -86,6 +89,15 @@ namespace Qonvince
 
         void setItemDelegate() = delete;
 
+        // only the OTPs whose issuer or name matches the text are listed, best match first
+        [[nodiscard]] inline const QString & filterText() const
+        {
+            return m_filterModel->filterText();
+        }
+
+    public Q_SLOTS:
+        void setFilterText(const QString & text);
+
     Q_SIGNALS:
         void codeClicked(Otp *);
         void codeDoubleClicked(Otp *);
@@ -111,10 +123,18 @@ namespace Qonvince
         virtual void mouseClickEvent(QMouseEvent * event);
         void synchroniseTickTimer();
 
+        // the first and last rows that are at least partly visible; last is less than first if none are
+        [[nodiscard]] std::pair<int, int> visibleRows() const;
+
+        // the parts of the visible TOTP items that change on a countdown tick
+        [[nodiscard]] QRegion countdownDamage(bool criticalOnly) const;
+
     private Q_SLOTS:
 
         //		void onOtpChanged();
         void updateCountdowns();
+        void onClockAdjusted();
+        void onSmoothCountdownsChanged(bool smooth);
         void onEditActionTriggered();
         void onRefreshActionTriggered();
         void onRevealActionTriggered();
@@ -130,6 +150,9 @@ namespace Qonvince
         // triggers widget redraw on TOTP timer ticks (i.e. 1s boundaries)
         int m_tickTimerId;
 
+        // animates the countdowns that are about to expire, when smooth countdowns are enabled
+        int m_smoothTimerId;
+
         // inserts a delay between receiving a mouseReleaseEvent() that looks like a click
         // on a code and actually acting on a click so that we can determine whether it's
         // actually a double-click. the timer is started by the mouseReleaseEvent() and
@@ -146,6 +169,7 @@ namespace Qonvince
         QModelIndex m_mousePressItemIndex;
 
         std::unique_ptr<OtpListModel> m_model;
+        std::unique_ptr<OtpFilterModel> m_filterModel;
         std::unique_ptr<OtpListItemDelegate> m_delegate;
 
         struct ActionButtonSpec
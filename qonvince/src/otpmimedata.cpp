@@ -18,6 +18,7 @@
  */
 
 #include "otpmimedata.h"
+#include <charconv>
 #include <QtGlobal>
 #include "application.h"
 #include "otp.h"
@@ -33,12 +34,10 @@ namespace Qonvince
     : m_origin(qonvinceApp)
     {
         Q_ASSERT_X(otp, __PRETTY_FUNCTION__ , "constructor expects a non-null Otp pointer.");
-        auto otps = json::array();
-        otps.push_back(otp->toJson());
-        setData(OtpJsonMimeType, QByteArray::fromStdString(otps.dump()));
+        setOtps({otp});
 
         if (index) {
-            setData(OtpIndicesMimeType, QByteArray::number(*index));
+            setIndices({*index});
         }
     }
 
@@ -102,31 +101,68 @@ namespace Qonvince
 
     void OtpMimeData::setIndices(const std::vector<int> & indices)
     {
-        setData(OtpIndicesMimeType,
-        std::transform_reduce(indices.cbegin(), indices.cend(),
-              QByteArray(),
-              [](const QByteArray & init, QByteArray index) -> QByteArray {
-                  if (init.isEmpty()) {
-                      return index;
-                  }
+        // space-separated, appended in place so that large selections stay linear
+        QByteArray indicesData;
+        indicesData.reserve(static_cast<int>(indices.size()) * 4);
+        char buffer[16];
+
+        for (const auto index : indices) {
+            if (!indicesData.isEmpty()) {
+                indicesData.append(' ');
+            }
+
+            const auto result = std::to_chars(std::begin(buffer), std::end(buffer), index);
+            indicesData.append(buffer, static_cast<int>(result.ptr - buffer));
+        }
 
-                  return init + ' ' + index;
-              },
-              [](int index) -> QByteArray {
-                  return QByteArray::number(index);
-              })
-        );
+        setData(OtpIndicesMimeType, indicesData);
     }
 
     void OtpMimeData::setOtps(const std::vector<Otp *> & otps)
     {
-        auto otpJson = json::array();
+        m_otps.assign(otps.cbegin(), otps.cend());
+        m_otpJson.reset();
+    }
+
+    QStringList OtpMimeData::formats() const
+    {
+        auto formats = QMimeData::formats();
 
-        for (const auto * otp : otps) {
-            otpJson.push_back(otp->toJson());
+        if (!m_otps.empty() && !formats.contains(OtpJsonMimeType)) {
+            formats.append(OtpJsonMimeType);
         }
 
-        setData(OtpJsonMimeType, QByteArray::fromStdString(otpJson.dump()));
+        return formats;
+    }
+
+    bool OtpMimeData::hasFormat(const QString & mimeType) const
+    {
+        if (!m_otps.empty() && OtpJsonMimeType == mimeType) {
+            return true;
+        }
+
+        return QMimeData::hasFormat(mimeType);
+    }
+
+    QVariant OtpMimeData::retrieveData(const QString & mimeType, QVariant::Type type) const
+    {
+        if (m_otps.empty() || OtpJsonMimeType != mimeType) {
+            return QMimeData::retrieveData(mimeType, type);
+        }
+
+        if (!m_otpJson) {
+            auto otpJson = json::array();
+
+            for (const auto & otp : m_otps) {
+                if (otp) {
+                    otpJson.push_back(otp->toJson());
+                }
+            }
+
+            m_otpJson = QByteArray::fromStdString(otpJson.dump());
+        }
+
+        return *m_otpJson;
     }
 
     std::optional<QByteArray> OtpMimeData::otpListJsonString() const
@@ -172,7 +208,10 @@ namespace Qonvince
             return {};
         }
 
-        return data(OtpIndicesMimeType).split(' ')[0].toInt();
+        const auto indicesData = data(OtpIndicesMimeType);
+        int index = 0;
+        std::from_chars(indicesData.constData(), indicesData.constData() + indicesData.size(), index);
+        return index;
     }
 
     std::optional<std::vector<int>> OtpMimeData::indices() const
@@ -182,12 +221,14 @@ namespace Qonvince
         }
 
         std::vector<int> ret;
-        auto strIndices = data(OtpIndicesMimeType).split(' ');
-        ret.reserve(strIndices.size());
+        const auto indicesData = data(OtpIndicesMimeType);
+        const auto * end = indicesData.constData() + indicesData.size();
 
-        std::transform(strIndices.begin(), strIndices.end(), std::back_inserter(ret), [](const QByteArray & strIndex) -> int {
-            return strIndex.toInt();
-        });
+        for (const auto * begin = indicesData.constData(); begin < end; ++begin) {
+            int index = 0;
+            begin = std::from_chars(begin, end, index).ptr;
+            ret.push_back(index);
+        }
 
         return ret;
     }
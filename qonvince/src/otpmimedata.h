@@ -24,6 +24,7 @@
 #include <vector>
 #include <QMimeData>
 #include <QByteArray>
+#include <QPointer>
 #include <nlohmann/json.hpp>
 
 namespace Qonvince
@@ -34,7 +35,9 @@ namespace Qonvince
     /**
      * @brief Specialisation of QMimeData for Otp export/drag-drop.
      *
-     *
+     * When built from Otp objects, the JSON representation is not produced until something asks for the
+     * OtpJsonMimeType data. Internal moves only use the indices, so they never serialise (or decrypt the seeds of) the
+     * dragged Otps. Otps that are destroyed before their JSON is requested are left out of it.
      */
     class OtpMimeData
     : public QMimeData
@@ -80,6 +83,9 @@ namespace Qonvince
          */
         ~OtpMimeData() noexcept override;
 
+        [[nodiscard]] QStringList formats() const override;
+        [[nodiscard]] bool hasFormat(const QString & mimeType) const override;
+
         /**
          * Fetch the stringified JSON representation of the Otps in the MIME data, if present.
          *
@@ -150,6 +156,9 @@ namespace Qonvince
             return m_origin;
         }
 
+    protected:
+        [[nodiscard]] QVariant retrieveData(const QString & mimeType, QVariant::Type type) const override;
+
     private:
         // helpers for the constructors
         void setIndices(const std::vector<int> & indices);
@@ -158,6 +167,10 @@ namespace Qonvince
         // the application from which the Otps originated. if the receiver is in the same application, it can use the
         // indices to just re-order the Otps on drop
         Application * m_origin;
+
+        // the Otps whose JSON is produced on demand, and the JSON once it has been
+        std::vector<QPointer<Otp>> m_otps;
+        mutable std::optional<QByteArray> m_otpJson;
     };
 } // Qonvince
 
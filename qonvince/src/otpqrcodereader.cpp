@@ -30,6 +30,7 @@
 #include <QRegularExpression>
 
 #include "application.h"
+#include "base32.h"
 #include "qtiostream.h"
 
 namespace Qonvince
@@ -135,12 +136,19 @@ namespace Qonvince
             return false;
         }
 
+        // google uses (used?) lower-case and whitespace and often omits the padding, so all of these are tolerated while
+        // decoding rather than building normalised copies of the seed first
+        LibQonvince::Base32<QByteArray> decodedSeed;
+
+        if (!decodedSeed.setEncoded(seed.toUtf8(), LibQonvince::Base32Codec::Normalise::Lenient)) {
+            std::cerr << __PRETTY_FUNCTION__ << " [" << __LINE__ << "]: invalid seed found in OTPAUTH:// URL\n";
+            return false;
+        }
+
         m_type = type;
         m_issuer = issuer;
         m_name = name;
-
-        // TODO google uses (used?) lower-case and whitespace, so convert and strip spaces
-        m_seed = seed.toUpper().toUtf8();
+        m_seed = decodedSeed.plain();
         m_counter = counter;
         m_interval = period;
         m_digits = digits;
@@ -150,7 +158,7 @@ namespace Qonvince
     std::unique_ptr<Otp> OtpQrCodeReader::createOtp() const
     {
         if (!m_seed.isEmpty() && (6 == m_digits || 8 == m_digits)) {
-            auto ret = std::make_unique<Otp>(type(), issuer(), name(), seed(), Otp::SeedType::Base32);
+            auto ret = std::make_unique<Otp>(type(), issuer(), name(), seed(), Otp::SeedType::Plain);
             ret->setCounter(static_cast<quint64>(m_counter));
             ret->setInterval(m_interval);
             ret->setDisplayPluginName((8 == m_digits ? QStringLiteral("EightDigitsPlugin") : QStringLiteral("SixDigitsPlugin")));
@@ -47,6 +47,7 @@ namespace Qonvince
             return m_issuer;
         }
 
+        // the decoded (plain) seed - use Otp::SeedType::Plain when passing it to an Otp
         [[nodiscard]] inline const QByteArray & seed() const
         {
             return m_seed;
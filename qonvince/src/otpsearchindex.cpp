@@ -0,0 +1,401 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file otpsearchindex.cpp
+ * @brief Implementation of the OtpSearchIndex class.
+ */
+
+#include "otpsearchindex.h"
+
+#include <algorithm>
+#include <QStringBuilder>
+
+#include "otp.h"
+
+namespace Qonvince
+{
+	namespace
+	{
+		using Key = quint64;
+
+		// the length of the n-gram is in the top bits so that trigrams and word prefixes never share a posting list
+		constexpr Key prefixKey(QChar first)
+		{
+			return (Key{1} << 48) | first.unicode();
+		}
+
+		constexpr Key prefixKey(QChar first, QChar second)
+		{
+			return (Key{2} << 48) | (Key{first.unicode()} << 16) | second.unicode();
+		}
+
+		constexpr Key trigramKey(QChar first, QChar second, QChar third)
+		{
+			return (Key{3} << 48) | (Key{first.unicode()} << 32) | (Key{second.unicode()} << 16) | third.unicode();
+		}
+
+		inline bool isWordStart(const QString & text, int pos)
+		{
+			return 0 == pos || !text[pos - 1].isLetterOrNumber();
+		}
+	}	// namespace
+
+	OtpSearchIndex::OtpSearchIndex(QObject * parent)
+	: QObject(parent)
+	{
+	}
+
+	OtpSearchIndex::~OtpSearchIndex() = default;
+
+	QString OtpSearchIndex::fold(const QString & text)
+	{
+		// decompose so that accents become separate marks that can be dropped, then "É" and "e" both fold to "e"
+		const auto decomposed = text.normalized(QString::NormalizationForm_KD);
+		QString folded;
+		folded.reserve(decomposed.size());
+
+		for(const auto ch : decomposed) {
+			if(!ch.isMark()) {
+				folded.append(ch);
+			}
+		}
+
+		return folded.toCaseFolded();
+	}
+
+	void OtpSearchIndex::add(Otp * otp)
+	{
+		if(!otp || contains(otp)) {
+			return;
+		}
+
+		EntryId id;
+
+		if(m_freeIds.empty()) {
+			id = static_cast<EntryId>(m_entries.size());
+			m_entries.emplace_back();
+		}
+		else {
+			id = m_freeIds.back();
+			m_freeIds.pop_back();
+		}
+
+		auto & entry = m_entries[id];
+		entry.otp = otp;
+		entry.order = m_nextOrder++;
+		m_ids.emplace(otp, id);
+		indexEntry(id);
+
+		connect(otp, qOverload<QString>(&Otp::issuerChanged), this, [this, otp]() {
+			reindex(otp);
+		});
+
+		connect(otp, qOverload<QString>(&Otp::nameChanged), this, [this, otp]() {
+			reindex(otp);
+		});
+
+		connect(otp, &QObject::destroyed, this, [this, otp]() {
+			remove(otp);
+		});
+	}
+
+	void OtpSearchIndex::remove(const Otp * otp)
+	{
+		const auto id = m_ids.find(otp);
+
+		if(m_ids.end() == id) {
+			return;
+		}
+
+		unindexEntry(id->second);
+		m_entries[id->second] = {};
+		m_freeIds.push_back(id->second);
+		m_ids.erase(id);
+		disconnect(otp, nullptr, this, nullptr);
+	}
+
+	void OtpSearchIndex::clear()
+	{
+		for(const auto & [otp, id] : m_ids) {
+			disconnect(otp, nullptr, this, nullptr);
+		}
+
+		m_entries.clear();
+		m_freeIds.clear();
+		m_ids.clear();
+		m_postings.clear();
+	}
+
+	void OtpSearchIndex::noteUse(const Otp * otp)
+	{
+		const auto id = m_ids.find(otp);
+
+		if(m_ids.end() == id) {
+			return;
+		}
+
+		auto & entry = m_entries[id->second];
+		++entry.useCount;
+		entry.lastUse = ++m_useSequence;
+	}
+
+	void OtpSearchIndex::reindex(Otp * otp)
+	{
+		const auto id = m_ids.find(otp);
+
+		if(m_ids.end() == id) {
+			return;
+		}
+
+		unindexEntry(id->second);
+		indexEntry(id->second);
+		Q_EMIT otpChanged(otp);
+	}
+
+	void OtpSearchIndex::indexEntry(EntryId id)
+	{
+		auto & entry = m_entries[id];
+		const auto issuer = fold(entry.otp->issuer());
+		entry.text = issuer % QLatin1Char(' ') % fold(entry.otp->name());
+		entry.nameStart = issuer.size() + 1;
+
+		// queries are split at whitespace, so no term can contain it and n-grams that do are never looked up
+		const auto & text = entry.text;
+		auto & keys = entry.keys;
+		keys.clear();
+
+		for(int pos = 0, length = text.size(); pos < length; ++pos) {
+			if(text[pos].isSpace()) {
+				continue;
+			}
+
+			const auto hasSecond = pos + 1 < length && !text[pos + 1].isSpace();
+
+			if(isWordStart(text, pos)) {
+				keys.push_back(prefixKey(text[pos]));
+
+				if(hasSecond) {
+					keys.push_back(prefixKey(text[pos], text[pos + 1]));
+				}
+			}
+
+			if(hasSecond && pos + 2 < length && !text[pos + 2].isSpace()) {
+				keys.push_back(trigramKey(text[pos], text[pos + 1], text[pos + 2]));
+			}
+		}
+
+		std::sort(keys.begin(), keys.end());
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+		for(const auto key : keys) {
+			auto & posting = m_postings[key];
+			posting.insert(std::lower_bound(posting.begin(), posting.end(), id), id);
+		}
+	}
+
+	void OtpSearchIndex::unindexEntry(EntryId id)
+	{
+		auto & entry = m_entries[id];
+
+		for(const auto key : entry.keys) {
+			const auto posting = m_postings.find(key);
+
+			if(m_postings.end() == posting) {
+				continue;
+			}
+
+			auto & ids = posting->second;
+
+			if(const auto it = std::lower_bound(ids.begin(), ids.end(), id); ids.end() != it && id == *it) {
+				ids.erase(it);
+			}
+
+			if(ids.empty()) {
+				m_postings.erase(posting);
+			}
+		}
+
+		entry.keys.clear();
+	}
+
+	std::vector<OtpSearchIndex::EntryId> OtpSearchIndex::candidates(const QString & term) const
+	{
+		if(3 > term.size()) {
+			const auto posting = m_postings.find(1 == term.size() ? prefixKey(term[0]) : prefixKey(term[0], term[1]));
+			return (m_postings.cend() == posting ? std::vector<EntryId>() : posting->second);
+		}
+
+		std::vector<const std::vector<EntryId> *> postings;
+
+		for(int pos = 0; pos + 2 < term.size(); ++pos) {
+			const auto posting = m_postings.find(trigramKey(term[pos], term[pos + 1], term[pos + 2]));
+
+			if(m_postings.cend() == posting) {
+				return {};
+			}
+
+			postings.push_back(&(posting->second));
+		}
+
+		// start with the rarest trigram so that the candidates only shrink from there
+		std::sort(postings.begin(), postings.end(), [](const auto * lhs, const auto * rhs) {
+			return lhs->size() < rhs->size();
+		});
+
+		postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+		auto ids = *(postings.front());
+
+		for(auto posting = postings.cbegin() + 1; posting != postings.cend() && !ids.empty(); ++posting) {
+			std::erase_if(ids, [posting](EntryId id) {
+				return !std::binary_search((*posting)->cbegin(), (*posting)->cend(), id);
+			});
+		}
+
+		return ids;
+	}
+
+	int OtpSearchIndex::termScore(const Entry & entry, const QString & term)
+	{
+		int score = 0;
+
+		for(auto pos = entry.text.indexOf(term); -1 != pos; pos = entry.text.indexOf(term, pos + 1)) {
+			if(0 == pos || entry.nameStart == pos) {
+				return 3;
+			}
+
+			score = std::max(score, isWordStart(entry.text, pos) ? 2 : 1);
+		}
+
+		return score;
+	}
+
+	QStringList OtpSearchIndex::queryTerms(const QString & query)
+	{
+		const auto folded = fold(query).simplified();
+		return (folded.isEmpty() ? QStringList() : folded.split(QLatin1Char(' ')));
+	}
+
+	std::optional<OtpSearchIndex::Rank> OtpSearchIndex::rankEntry(const Entry & entry, const QStringList & terms)
+	{
+		int score = 0;
+
+		for(const auto & term : terms) {
+			const auto termMatch = termScore(entry, term);
+
+			// a trigram candidate need not contain the term itself, and short terms only match the start of a word
+			if(0 == termMatch || (3 > term.size() && 2 > termMatch)) {
+				return {};
+			}
+
+			score += termMatch;
+		}
+
+		if(0 == score) {
+			return {};
+		}
+
+		return Rank{score, entry.useCount, entry.lastUse, entry.order};
+	}
+
+	bool OtpSearchIndex::ranksBefore(const Rank & lhs, const Rank & rhs)
+	{
+		if(lhs.score != rhs.score) {
+			return lhs.score > rhs.score;
+		}
+
+		if(lhs.useCount != rhs.useCount) {
+			return lhs.useCount > rhs.useCount;
+		}
+
+		if(lhs.lastUse != rhs.lastUse) {
+			return lhs.lastUse > rhs.lastUse;
+		}
+
+		return lhs.order < rhs.order;
+	}
+
+	std::optional<OtpSearchIndex::Rank> OtpSearchIndex::rank(const Otp * otp, const QString & query) const
+	{
+		const auto id = m_ids.find(otp);
+
+		if(m_ids.cend() == id) {
+			return {};
+		}
+
+		return rankEntry(m_entries[id->second], queryTerms(query));
+	}
+
+	std::vector<Otp *> OtpSearchIndex::search(const QString & query) const
+	{
+		const auto matches = rankedSearch(query);
+		std::vector<Otp *> otps;
+		otps.reserve(matches.size());
+		std::transform(matches.cbegin(), matches.cend(), std::back_inserter(otps), [](const Match & match) {
+			return match.otp;
+		});
+
+		return otps;
+	}
+
+	std::vector<OtpSearchIndex::Match> OtpSearchIndex::rankedSearch(const QString & query) const
+	{
+		const auto terms = queryTerms(query);
+
+		if(terms.isEmpty()) {
+			return {};
+		}
+
+		std::vector<EntryId> ids;
+
+		for(auto term = terms.cbegin(); term != terms.cend(); ++term) {
+			if(terms.cbegin() == term) {
+				ids = candidates(*term);
+			}
+			else {
+				const auto termIds = candidates(*term);
+
+				std::erase_if(ids, [&termIds](EntryId id) {
+					return !std::binary_search(termIds.cbegin(), termIds.cend(), id);
+				});
+			}
+
+			if(ids.empty()) {
+				return {};
+			}
+		}
+
+		std::vector<Match> matches;
+		matches.reserve(ids.size());
+
+		for(const auto id : ids) {
+			const auto & entry = m_entries[id];
+
+			if(const auto rank = rankEntry(entry, terms); rank) {
+				matches.push_back({entry.otp, *rank});
+			}
+		}
+
+		std::sort(matches.begin(), matches.end(), [](const Match & lhs, const Match & rhs) {
+			return ranksBefore(lhs.rank, rhs.rank);
+		});
+
+		return matches;
+	}
+}	// namespace Qonvince
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_OTPSEARCHINDEX_H
+#define QONVINCE_OTPSEARCHINDEX_H
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+namespace Qonvince
+{
+	class Otp;
+
+	/**
+	 * An incremental index of the issuers and names of a set of OTPs.
+	 *
+	 * Each OTP's issuer and name are case- and accent-folded, and every trigram of the folded text is recorded in a
+	 * posting list, along with the first one and two characters of each word. A query is split into terms at
+	 * whitespace and an OTP matches if it contains every term: terms of three or more characters match anywhere, and
+	 * are found by intersecting the posting lists of their trigrams; shorter terms match the start of a word. The
+	 * index follows changes to the issuers and names of the OTPs it contains, and drops OTPs that are destroyed.
+	 *
+	 * Matches are ranked by where the terms match (the start of the issuer or name, then the start of any word, then
+	 * anywhere), and OTPs that have been used more often and more recently (see noteUse()) come first among matches
+	 * that rank the same.
+	 */
+	class OtpSearchIndex
+	: public QObject
+	{
+		Q_OBJECT
+
+	public:
+		explicit OtpSearchIndex(QObject * parent = nullptr);
+		~OtpSearchIndex() override;
+
+		// the index does not take ownership. adding an OTP that is already in the index does nothing
+		void add(Otp * otp);
+		void remove(const Otp * otp);
+		void clear();
+
+		[[nodiscard]] bool contains(const Otp * otp) const
+		{
+			return m_ids.cend() != m_ids.find(otp);
+		}
+
+		[[nodiscard]] std::size_t size() const
+		{
+			return m_ids.size();
+		}
+
+		// record that the OTP's code has been used, for ranking
+		void noteUse(const Otp * otp);
+
+		// how well an OTP matches a query, as of the search that found it
+		struct Rank
+		{
+			int score = 0;
+			quint32 useCount = 0;
+			quint64 lastUse = 0;
+			quint64 order = 0;
+		};
+
+		struct Match
+		{
+			Otp * otp = nullptr;
+			Rank rank;
+		};
+
+		// whether a match with the first rank is listed before one with the second
+		[[nodiscard]] static bool ranksBefore(const Rank & lhs, const Rank & rhs);
+
+		// the OTPs matching the query, best first. a query with no terms matches nothing
+		[[nodiscard]] std::vector<Otp *> search(const QString & query) const;
+		[[nodiscard]] std::vector<Match> rankedSearch(const QString & query) const;
+
+		// how well a single OTP matches the query, without searching the whole index. empty if it doesn't match
+		[[nodiscard]] std::optional<Rank> rank(const Otp * otp, const QString & query) const;
+
+		// the form in which text is indexed and queries are matched
+		static QString fold(const QString & text);
+
+	Q_SIGNALS:
+		// the OTP's issuer or name has changed, so it may now match different queries
+		void otpChanged(Otp * otp);
+
+	private:
+		using EntryId = quint32;
+		using Key = quint64;
+
+		struct Entry
+		{
+			Otp * otp = nullptr;
+
+			// folded issuer and name, separated by a space
+			QString text;
+
+			// where the name starts in the text
+			int nameStart = 0;
+
+			// the posting lists the entry is in
+			std::vector<Key> keys;
+
+			quint32 useCount = 0;
+			quint64 lastUse = 0;
+			quint64 order = 0;
+		};
+
+		void indexEntry(EntryId id);
+		void unindexEntry(EntryId id);
+		void reindex(Otp * otp);
+
+		// the sorted ids of the entries that might contain the term; the caller checks the text of each candidate
+		[[nodiscard]] std::vector<EntryId> candidates(const QString & term) const;
+
+		// 3 for a term that starts the issuer or name, 2 for the start of another word and 1 for anywhere else
+		[[nodiscard]] static int termScore(const Entry & entry, const QString & term);
+
+		// the folded terms of a query
+		[[nodiscard]] static QStringList queryTerms(const QString & query);
+
+		// empty if the entry doesn't contain every term
+		[[nodiscard]] static std::optional<Rank> rankEntry(const Entry & entry, const QStringList & terms);
+
+		std::vector<Entry> m_entries;
+		std::vector<EntryId> m_freeIds;
+		std::unordered_map<const Otp *, EntryId> m_ids;
+
+		// each list of entry ids is kept sorted so that lists can be intersected in linear time
+		std::unordered_map<Key, std::vector<EntryId>> m_postings;
+
+		quint64 m_nextOrder = 0;
+		quint64 m_useSequence = 0;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_OTPSEARCHINDEX_H
@@ -27,6 +27,8 @@
 #include "src/passphrasedialogue.h"
 #include "ui_passphrasedialogue.h"
 
+#include <QPushButton>
+
 namespace Qonvince
 {
     PassphraseDialogue::PassphraseDialogue(QWidget * parent)
@@ -36,9 +38,11 @@ namespace Qonvince
 
     PassphraseDialogue::PassphraseDialogue(const QString & msg, QWidget * parent)
     : QDialog(parent),
-    m_ui{std::make_unique<Ui::PassphraseDialogue>()}
+    m_ui{std::make_unique<Ui::PassphraseDialogue>()},
+    m_verifiesPassphrase(false)
     {
         m_ui->setupUi(this);
+        m_ui->progress->setVisible(false);
         setMessage(msg);
         setMessageVisible(!msg.isEmpty());
         connect(m_ui->passphrase, &QLineEdit::textEdited, this, &PassphraseDialogue::passphraseChanged);
@@ -74,4 +78,51 @@ namespace Qonvince
     {
         m_ui->message->setVisible(vis);
     }
+
+    bool PassphraseDialogue::isBusy() const
+    {
+        return !m_ui->passphrase->isEnabled();
+    }
+
+    void PassphraseDialogue::setBusy(bool busy)
+    {
+        m_ui->passphrase->setEnabled(!busy);
+        m_ui->controlBox->button(QDialogButtonBox::Ok)->setEnabled(!busy);
+        m_ui->progress->setVisible(busy);
+
+        if (busy) {
+            // busy indicator until the first progress report
+            m_ui->progress->setRange(0, 0);
+        } else {
+            m_ui->passphrase->selectAll();
+            m_ui->passphrase->setFocus();
+        }
+    }
+
+    void PassphraseDialogue::setProgress(int done, int total)
+    {
+        m_ui->progress->setRange(0, total);
+        m_ui->progress->setValue(done);
+    }
+
+    void PassphraseDialogue::passphraseVerified()
+    {
+        setBusy(false);
+        done(QDialog::Accepted);
+    }
+
+    void PassphraseDialogue::accept()
+    {
+        if (!m_verifiesPassphrase) {
+            QDialog::accept();
+            return;
+        }
+
+        if (isBusy()) {
+            return;
+        }
+
+        setBusy(true);
+        Q_EMIT passphraseSubmitted(passphrase());
+    }
 }  // namespace Qonvince
@@ -31,6 +31,24 @@ namespace Qonvince
         [[nodiscard]] QString passphrase() const;
         void setPassphrase(const QString & pwd);
 
+        /**
+         * Keep the dialogue open while the passphrase is checked.
+         *
+         * When set, accepting the dialogue emits passphraseSubmitted() and makes the dialogue busy rather than closing
+         * it. The owner then either calls passphraseVerified() to close it or setBusy(false) to let the user try again.
+         */
+        void setVerifiesPassphrase(bool verify)
+        {
+            m_verifiesPassphrase = verify;
+        }
+
+        [[nodiscard]] bool verifiesPassphrase() const
+        {
+            return m_verifiesPassphrase;
+        }
+
+        [[nodiscard]] bool isBusy() const;
+
     public Q_SLOTS:
         inline void showMessage()
         {
@@ -44,11 +62,20 @@ namespace Qonvince
 
         void setMessageVisible(bool);
 
+        // while busy the passphrase can't be edited or submitted and the progress bar is shown
+        void setBusy(bool);
+        void setProgress(int done, int total);
+        void passphraseVerified();
+
+        void accept() override;
+
     Q_SIGNALS:
         void passphraseChanged(QString);
+        void passphraseSubmitted(QString);
 
     private:
         std::unique_ptr<Ui::PassphraseDialogue> m_ui;
+        bool m_verifiesPassphrase;
     };
 }  // namespace Qonvince
 
@@ -1,6 +1,7 @@
 #ifndef QONVINCE_PLUGINFACTORY_H
 #define QONVINCE_PLUGINFACTORY_H
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -30,6 +31,10 @@ namespace Qonvince
     public:
         using PathList = std::vector<std::string>;
 
+        // plugins are numbered in the order they are loaded, so a handle can stand in for a name on hot paths
+        using Handle = int;
+        static constexpr const Handle InvalidHandle = -1;
+
         explicit PluginFactory(std::string extension = QONVINCE_PLUGINFACTORY_DEFAULT_EXTENSION)
                 : m_extension(std::move(extension))
         {
@@ -90,7 +95,9 @@ namespace Qonvince
                 m_searchPaths.emplace_back(path, false);
             }
 
+            m_handles.clear();
             m_loadedPlugins.clear();
+            ++m_generation;
         }
 
         std::vector<PluginType *> loadedPlugins() const
@@ -99,7 +106,7 @@ namespace Qonvince
 
             std::transform(m_loadedPlugins.cbegin(), m_loadedPlugins.cend(), std::back_inserter(ret),
                            [](const typename decltype(m_loadedPlugins)::value_type & plugin){
-                               return plugin.second.get();
+                               return plugin.get();
                            });
 
             return ret;
@@ -107,14 +114,49 @@ namespace Qonvince
 
         PluginType * pluginByName(const std::string & name)
         {
-            loadAllPlugins();
-            auto plugin = m_loadedPlugins.find(name);
+            return plugin(handleByName(name));
+        }
+
+        // if no plugin with the name is loaded yet, this loads any plugins from paths that have yet to be searched, so it is
+        // best kept off hot paths
+        Handle handleByName(const std::string & name)
+        {
+            auto handle = m_handles.find(name);
+
+            if (handle == m_handles.cend()) {
+                loadAllPlugins();
+                handle = m_handles.find(name);
 
-            if (plugin == m_loadedPlugins.cend()) {
+                if (handle == m_handles.cend()) {
+                    return InvalidHandle;
+                }
+            }
+
+            return handle->second;
+        }
+
+        // register a plugin that is compiled into the application, so that it can be used without searching for plugin
+        // files. a plugin file with the same name is refused when it's loaded
+        template<class BuiltInPluginType>
+        bool addBuiltInPlugin()
+        {
+            return addPlugin(std::make_unique<BuiltInPluginType>(), "the application");
+        }
+
+        PluginType * plugin(Handle handle) const
+        {
+            if (0 > handle || m_loadedPlugins.size() <= static_cast<std::size_t>(handle)) {
                 return nullptr;
             }
 
-            return plugin->second.get();
+            return m_loadedPlugins[static_cast<std::size_t>(handle)].get();
+        }
+
+        // changes whenever the set of loaded plugins does. a handle, or the lack of one, for a name is only worth
+        // looking up again when this has changed
+        [[nodiscard]] std::uint64_t generation() const
+        {
+            return m_generation;
         }
 
         // this will load all plugins from paths that have yet to be searched
@@ -135,6 +177,7 @@ namespace Qonvince
         bool loadPlugin(const std::string & path)
         {
             using InstanceFunction = PluginType * (*)();
+            using LegacyInstanceFunction = void * (*)();
             auto lib = SharedLibrary(path);
 
             if (!lib.isOpen()) {
@@ -164,15 +207,17 @@ namespace Qonvince
             }
 
             auto * info = reinterpret_cast<LibQonvince::PluginInfo *>(symbol);
+
+            // all of the factory's messages go to stderr, since the command-line client's stdout is read by scripts
 #if !defined(NDEBUG)
-            std::cout << "\nPlugin type: " << info->pluginType << "\n";
-            std::cout << "API version: " << info->apiVersion << "\n";
-            std::cout << "Plugin name: " << info->pluginName << "\n";
-            std::cout << "Class name: " << info->className << "\n";
-            std::cout << "Display name: " << info->displayName << "\n";
-            std::cout << "Plugin version string: " << info->versionString << "\n";
-            std::cout << "Author: " << info->authorName << "\n";
-            std::cout << "Description: " << info->description << "\n\n";
+            std::cerr << "\nPlugin type: " << info->pluginType << "\n";
+            std::cerr << "API version: " << info->apiVersion << "\n";
+            std::cerr << "Plugin name: " << info->pluginName << "\n";
+            std::cerr << "Class name: " << info->className << "\n";
+            std::cerr << "Display name: " << info->displayName << "\n";
+            std::cerr << "Plugin version string: " << info->versionString << "\n";
+            std::cerr << "Author: " << info->authorName << "\n";
+            std::cerr << "Description: " << info->description << "\n\n";
 #endif
             if (0 != info->pluginType.compare(PluginType::PluginTypeName)) {
                 std::cerr << __PRETTY_FUNCTION__ << " (" << __FILE__ << " [" << __LINE__ << "]): the plugin \"" << path << "\" is not a(n) "
@@ -180,7 +225,7 @@ namespace Qonvince
                 return false;
             }
 
-            if (PluginType::ApiVersion != info->apiVersion) {
+            if (PluginType::ApiVersion != info->apiVersion && !isSupportedLegacyApiVersion(info->apiVersion)) {
                 std::cerr << __PRETTY_FUNCTION__ << " (" << __FILE__ << " [" << __LINE__ << "]): the plugin \"" << path
                           << "\" has an incorrect API version (it has v" << info->apiVersion << ", expecting v" << PluginType::ApiVersion << ")\n";
                 return false;
@@ -204,8 +249,14 @@ namespace Qonvince
                 return false;
             }
 
-            auto instanceFn = reinterpret_cast<InstanceFunction>(symbol);
-            std::unique_ptr<PluginType> plugin(instanceFn());
+            std::unique_ptr<PluginType> plugin;
+
+            if (PluginType::ApiVersion == info->apiVersion) {
+                plugin.reset(reinterpret_cast<InstanceFunction>(symbol)());
+            } else {
+                // the instance implements an older interface, so the plugin type has to wrap it
+                plugin = adaptLegacyInstance(info->apiVersion, reinterpret_cast<LegacyInstanceFunction>(symbol)());
+            }
 
             if (!plugin) {
                 std::cerr << __PRETTY_FUNCTION__ << " (" << __FILE__ << " [" << __LINE__ << "]): the createInstance() function in the plugin \"" << path
@@ -213,21 +264,55 @@ namespace Qonvince
                 return false;
             }
 
-            if (m_loadedPlugins.cend() != m_loadedPlugins.find(plugin->name())) {
-                std::cerr << __PRETTY_FUNCTION__ << " (" << __FILE__ << " [" << __LINE__ << "]): the plugin loaded from the file \"" << path
-                          << "\" has a name (\"" << plugin->name()
-                          << "\") that is identical to another plugin that is already loaded and therefore cannot be used.\n";
+            if (!addPlugin(std::move(plugin), "the file \"" + path + "\"")) {
                 return false;
             }
 
-            std::cout << __PRETTY_FUNCTION__ << " (" << __FILE__ << " [" << __LINE__ << "]) : successfully loaded plugin \"" << plugin->name() << "\" from \""
-                      << path << "\"\n";
+            std::cerr << __PRETTY_FUNCTION__ << " (" << __FILE__ << " [" << __LINE__ << "]) : successfully loaded plugin from \"" << path << "\"\n";
             m_openLibs.push_back(std::move(lib));
-            m_loadedPlugins.insert(std::make_pair(plugin->name(), std::move(plugin)));
             return true;
         }
 
     private:
+        // source describes where the plugin came from, for the error message
+        bool addPlugin(std::unique_ptr<PluginType> plugin, const std::string & source)
+        {
+            if (m_handles.cend() != m_handles.find(plugin->name())) {
+                std::cerr << __PRETTY_FUNCTION__ << " (" << __FILE__ << " [" << __LINE__ << "]): the plugin from " << source
+                          << " has a name (\"" << plugin->name()
+                          << "\") that is identical to another plugin that is already loaded and therefore cannot be used.\n";
+                return false;
+            }
+
+            m_handles.emplace(plugin->name(), static_cast<Handle>(m_loadedPlugins.size()));
+            m_loadedPlugins.push_back(std::move(plugin));
+            ++m_generation;
+            return true;
+        }
+
+        // a plugin type can keep loading plugins built against older versions of its API by providing an adapter
+        static constexpr const bool HasLegacyAdapter = requires(void * instance) {
+            PluginType::fromLegacyInstance(PluginType::OldestSupportedApiVersion, instance);
+        };
+
+        static constexpr bool isSupportedLegacyApiVersion(int apiVersion)
+        {
+            if constexpr (HasLegacyAdapter) {
+                return PluginType::OldestSupportedApiVersion <= apiVersion && PluginType::ApiVersion > apiVersion;
+            } else {
+                return false;
+            }
+        }
+
+        static std::unique_ptr<PluginType> adaptLegacyInstance(int apiVersion, void * instance)
+        {
+            if constexpr (HasLegacyAdapter) {
+                return PluginType::fromLegacyInstance(apiVersion, instance);
+            } else {
+                return nullptr;
+            }
+        }
+
         void loadPluginsFromPath(const std::string & path)
         {
 				const auto fsPath = fs::canonical(path);
@@ -274,7 +359,11 @@ namespace Qonvince
         std::vector<SearchPathsEntry> m_searchPaths;
         const std::string m_extension;
         std::vector<SharedLibrary> m_openLibs;
-        std::unordered_map<std::string, std::unique_ptr<PluginType>> m_loadedPlugins;
+
+        // indexed by handle
+        std::vector<std::unique_ptr<PluginType>> m_loadedPlugins;
+        std::unordered_map<std::string, Handle> m_handles;
+        std::uint64_t m_generation = 0;
     };
 }  // namespace Qonvince
 
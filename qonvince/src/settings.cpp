@@ -46,7 +46,8 @@ namespace Qonvince
               m_startMinimised(false),
               m_copyCodeOnClick(false),
               m_hideOnCodeCopyClick(false),
-              m_clearClipboardAfterInterval(false)
+              m_clearClipboardAfterInterval(false),
+              m_smoothCountdowns(false)
     {
     }
 
@@ -58,6 +59,7 @@ namespace Qonvince
         setCopyCodeOnClick(settings.value(QStringLiteral("copy_code_on_click"), false).toBool());
         setHideOnCodeCopyClick(settings.value(QStringLiteral("hide_on_code_copy_click"), false).toBool());
         setClearClipboardAfterInterval(settings.value(QStringLiteral("clear_clipboard_after_interval"), false).toBool());
+        setSmoothCountdowns(settings.value(QStringLiteral("smooth_countdowns"), false).toBool());
 
         bool ok;
         int i = settings.value(QStringLiteral("clipboard_clear_interval"), DefaultClipboardClearInterval).toInt(&ok);
@@ -100,6 +102,7 @@ namespace Qonvince
         settings.setValue(QStringLiteral("clear_clipboard_after_interval"), clearClipboardAfterInterval());
         settings.setValue(QStringLiteral("clipboard_clear_interval"), clipboardClearInterval());
         settings.setValue(QStringLiteral("code_reveal_timeout"), codeRevealTimeout());
+        settings.setValue(QStringLiteral("smooth_countdowns"), smoothCountdowns());
 
         switch (codeLabelDisplayStyle()) {
             case CodeLabelDisplayStyle::IssuerAndName:
@@ -97,6 +97,12 @@ namespace Qonvince
             return m_revealTimeout;
         }
 
+        // animate the countdowns that are about to expire rather than updating them once a second
+        [[nodiscard]] inline bool smoothCountdowns() const
+        {
+            return m_smoothCountdowns;
+        }
+
         void read(const QSettings & settings);
         void write(QSettings & settings) const;
 
@@ -120,6 +126,8 @@ namespace Qonvince
         void codeLabelDisplayStyleChanged(CodeLabelDisplayStyle oldStyle, CodeLabelDisplayStyle newStyle);
         void codeRevealTimeoutChanged(int newValue);
         void codeRevealTimeoutChanged(int oldValue, int newValue);
+        void smoothCountdownsChanged(bool newValue);
+        void smoothCountdownsChanged(bool oldValue, bool newValue);
 
     public Q_SLOTS:
         inline void setSingleInstance(bool single)
@@ -202,6 +210,16 @@ namespace Qonvince
             }
         }
 
+        inline void setSmoothCountdowns(bool smooth)
+        {
+            if (smooth != m_smoothCountdowns) {
+                m_smoothCountdowns = smooth;
+                Q_EMIT smoothCountdownsChanged(!m_smoothCountdowns, m_smoothCountdowns);
+                Q_EMIT smoothCountdownsChanged(m_smoothCountdowns);
+                Q_EMIT changed();
+            }
+        }
+
         inline void setCodeLabelDisplayStyle(CodeLabelDisplayStyle style)
         {
             if (style != m_codeLabelDisplayStyle) {
@@ -222,6 +240,7 @@ namespace Qonvince
         bool m_copyCodeOnClick;
         bool m_hideOnCodeCopyClick;
         bool m_clearClipboardAfterInterval;
+        bool m_smoothCountdowns;
     };
 }  // namespace Qonvince
 
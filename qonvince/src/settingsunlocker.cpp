@@ -0,0 +1,109 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file settingsunlocker.cpp
+ * @brief Implementation of the SettingsUnlocker class.
+ */
+
+#include "settingsunlocker.h"
+
+#include <algorithm>
+#include <QSettings>
+
+#include "application.h"
+#include "otp.h"
+
+namespace Qonvince
+{
+	SettingsUnlocker::SettingsUnlocker(QObject * parent)
+	: QObject(parent),
+	  m_passphraseCorrect(false)
+	{
+	}
+
+	SettingsUnlocker::~SettingsUnlocker()
+	{
+		if(m_thread) {
+			m_thread->wait();
+		}
+	}
+
+	bool SettingsUnlocker::isBusy() const
+	{
+		return m_thread && m_thread->isRunning();
+	}
+
+	void SettingsUnlocker::unlock(const QCA::SecureArray & passphrase)
+	{
+		Q_ASSERT_X(!isBusy(), __PRETTY_FUNCTION__, "an unlock is already in progress");
+
+		if(m_thread) {
+			m_thread->wait();
+		}
+
+		m_passphraseCorrect = false;
+		m_seeds.clear();
+
+		// the members written by run() are only read once the thread has finished
+		m_thread.reset(QThread::create([this, passphrase]() {
+			run(passphrase);
+		}));
+
+		connect(m_thread.get(), &QThread::finished, this, [this]() {
+			Q_EMIT finished(m_passphraseCorrect);
+		});
+
+		m_thread->start();
+	}
+
+	SettingsUnlocker::Seeds SettingsUnlocker::takeSeeds()
+	{
+		Q_ASSERT_X(!isBusy(), __PRETTY_FUNCTION__, "seeds can't be taken while an unlock is in progress");
+		return std::move(m_seeds);
+	}
+
+	void SettingsUnlocker::run(const QCA::SecureArray & passphrase)
+	{
+		if(!Application::checkSettingsPassphrase(passphrase)) {
+			return;
+		}
+
+		m_passphraseCorrect = true;
+
+		QSettings settings;
+		settings.beginGroup(QStringLiteral("codes"));
+		const int count = settings.value(QStringLiteral("code_count"), 0).toInt();
+		m_seeds.reserve(static_cast<Seeds::size_type>(count));
+		Q_EMIT progress(0, count);
+
+		// each report is a queued event for the GUI thread, so large vaults only report every percent or so
+		const int reportInterval = std::max(1, count / 100);
+
+		for(int idx = 0; idx < count; ++idx) {
+			settings.beginGroup(QStringLiteral("code-%1").arg(idx));
+			m_seeds.push_back(Otp::decryptSeed(settings, passphrase));
+			settings.endGroup();
+
+			if(0 == (idx + 1) % reportInterval || idx + 1 == count) {
+				Q_EMIT progress(idx + 1, count);
+			}
+		}
+	}
+}	// namespace Qonvince
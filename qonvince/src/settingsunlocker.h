@@ -0,0 +1,76 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_SETTINGSUNLOCKER_H
+#define QONVINCE_SETTINGSUNLOCKER_H
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include <QObject>
+#include <QByteArray>
+#include <QThread>
+#include <QtCrypto>
+
+namespace Qonvince
+{
+	/**
+	 * Checks a passphrase and decrypts the stored seeds on a worker thread.
+	 *
+	 * All the expensive work of unlocking the settings happens here so that the GUI thread stays responsive: the
+	 * crypt_check verification and the decryption of each OTP's seed. Progress is reported as each seed is decrypted.
+	 * The Otp objects themselves are created afterwards on the GUI thread from the decrypted seeds (see
+	 * Application::readCodeSettings()).
+	 */
+	class SettingsUnlocker
+	: public QObject
+	{
+		Q_OBJECT
+
+	public:
+		// the Base32 seed for each stored OTP, in settings order; empty for seeds that could not be decrypted
+		using Seeds = std::vector<std::optional<QByteArray>>;
+
+		explicit SettingsUnlocker(QObject * parent = nullptr);
+
+		// waits for any unlock in progress to finish
+		~SettingsUnlocker() override;
+
+		[[nodiscard]] bool isBusy() const;
+
+		// start unlocking with a passphrase; finished() is emitted when done
+		void unlock(const QCA::SecureArray & passphrase);
+
+		// only valid after finished(true) has been emitted
+		Seeds takeSeeds();
+
+	Q_SIGNALS:
+		void progress(int done, int total);
+		void finished(bool passphraseCorrect);
+
+	private:
+		void run(const QCA::SecureArray & passphrase);
+
+		std::unique_ptr<QThread> m_thread;
+		bool m_passphraseCorrect;
+		Seeds m_seeds;
+	};
+}	// namespace Qonvince
+
+#endif  // QONVINCE_SETTINGSUNLOCKER_H
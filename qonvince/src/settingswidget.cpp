@@ -50,6 +50,7 @@ namespace Qonvince
         connect(m_ui->clipboardClearInterval, qOverload<int>(&QSpinBox::valueChanged), &m_settings, &Settings::setClipboardClearInterval);
         connect(m_ui->codeLabelDisplayStyle, qOverload<int>(&QComboBox::currentIndexChanged), this, &SettingsWidget::onDisplayStyleWidgetChanged);
         connect(m_ui->revealTimeout, qOverload<int>(&QSpinBox::valueChanged), &m_settings, &Settings::setCodeRevealTimeout);
+        connect(m_ui->smoothCountdowns, &QCheckBox::toggled, &m_settings, &Settings::setSmoothCountdowns);
         connect(&m_settings, &Settings::changed, this, &SettingsWidget::resyncWithSettings);
     }
 
@@ -67,6 +68,7 @@ namespace Qonvince
         setClipboardClearInterval(m_settings.clipboardClearInterval());
         setCodeLabelDisplayStyle(m_settings.codeLabelDisplayStyle());
         setCodeRevealTimeout(m_settings.codeRevealTimeout());
+        setSmoothCountdowns(m_settings.smoothCountdowns());
     }
 
     void SettingsWidget::onDisplayStyleWidgetChanged()
@@ -162,6 +164,11 @@ namespace Qonvince
         return m_ui->revealTimeout->value();
     }
 
+    bool SettingsWidget::smoothCountdowns() const
+    {
+        return m_ui->smoothCountdowns->isChecked();
+    }
+
     void SettingsWidget::setCodeLabelDisplayStyle(CodeLabelDisplayStyle style)
     {
         switch (style) {
@@ -188,4 +195,9 @@ namespace Qonvince
 
         m_ui->revealTimeout->setValue(timeout);
     }
+
+    void SettingsWidget::setSmoothCountdowns(bool smooth)
+    {
+        m_ui->smoothCountdowns->setChecked(smooth);
+    }
 }  // namespace Qonvince
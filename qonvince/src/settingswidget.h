@@ -50,6 +50,7 @@ namespace Qonvince {
 		[[nodiscard]] int clipboardClearInterval() const;
 		[[nodiscard]] CodeLabelDisplayStyle codeLabelDisplayStyle() const;
 		[[nodiscard]] int codeRevealTimeout() const;
+		[[nodiscard]] bool smoothCountdowns() const;
 
 	public Q_SLOTS:
 		void setSingleInstance(bool close);
@@ -61,6 +62,7 @@ namespace Qonvince {
 		void setClipboardClearInterval(int interval);
 		void setCodeLabelDisplayStyle(Qonvince::CodeLabelDisplayStyle style);
 		void setCodeRevealTimeout(int timeout);
+		void setSmoothCountdowns(bool smooth);
 
 	private Q_SLOTS:
 		void resyncWithSettings();
@@ -1,6 +1,8 @@
 TARGET = test_base32
 include(../test_common.pri)
 
+QT += testlib
+
 SOURCES +=\
     src/base32.cpp \
 
@@ -17,25 +17,185 @@
  * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <iostream>
+#include <algorithm>
+#include <span>
+#include <string>
+#include <vector>
+#include <QtTest>
 #include "base32.h"
 
-
 using Base32 = LibQonvince::Base32<std::string>;
+using LibQonvince::Base32Codec::Normalise;
+
+class Base32Test
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void encode_data();
+	void encode();
+	void decode_data();
+	void decode();
+	void roundTrip_data();
+	void roundTrip();
+	void invalid_data();
+	void invalid();
+	void lenient_data();
+	void lenient();
+	void streaming();
+};
+
+namespace
+{
+	std::string toStdString(const QByteArray & bytes)
+	{
+		return {bytes.constData(), static_cast<std::size_t>(bytes.size())};
+	}
+
+	void addRfc4648Vectors()
+	{
+		QTest::addColumn<QByteArray>("plain");
+		QTest::addColumn<QByteArray>("encoded");
+
+		// RFC 4648 section 10
+		QTest::newRow("empty") << QByteArray() << QByteArray();
+		QTest::newRow("f") << QByteArray("f") << QByteArray("MY======");
+		QTest::newRow("fo") << QByteArray("fo") << QByteArray("MZXQ====");
+		QTest::newRow("foo") << QByteArray("foo") << QByteArray("MZXW6===");
+		QTest::newRow("foob") << QByteArray("foob") << QByteArray("MZXW6YQ=");
+		QTest::newRow("fooba") << QByteArray("fooba") << QByteArray("MZXW6YTB");
+		QTest::newRow("foobar") << QByteArray("foobar") << QByteArray("MZXW6YTBOI======");
+		QTest::newRow("sentence") << QByteArray("what have you done for me lately?\n") << QByteArray("O5UGC5BANBQXMZJAPFXXKIDEN5XGKIDGN5ZCA3LFEBWGC5DFNR4T6CQ=");
+	}
+}	// namespace
+
+void Base32Test::encode_data()
+{
+	addRfc4648Vectors();
+}
+
+void Base32Test::encode()
+{
+	QFETCH(QByteArray, plain);
+	QFETCH(QByteArray, encoded);
+
+	QCOMPARE(Base32(toStdString(plain)).encoded(), toStdString(encoded));
+}
+
+void Base32Test::decode_data()
+{
+	addRfc4648Vectors();
+}
+
+void Base32Test::decode()
+{
+	QFETCH(QByteArray, plain);
+	QFETCH(QByteArray, encoded);
+
+	Base32 codec;
+	QVERIFY(codec.setEncoded(toStdString(encoded)));
+	QCOMPARE(codec.plain(), toStdString(plain));
+}
+
+void Base32Test::roundTrip_data()
+{
+	QTest::addColumn<int>("size");
+
+	for(const auto size : {1, 2, 3, 4, 5, 10, 16, 20, 32, 63, 64, 255, 1024}) {
+		QTest::newRow(qPrintable(QStringLiteral("%1 bytes").arg(size))) << size;
+	}
+}
 
+void Base32Test::roundTrip()
+{
+	QFETCH(int, size);
 
-int main(int argc, char * argv[]) {
-	(void) argc;
-	(void) argv;
+	// every byte value, including nul, must survive
+	std::string plain(static_cast<std::size_t>(size), '\0');
 
-	Base32::ByteArray data = reinterpret_cast<const Base32::ByteArray::value_type *>("what have you done for me lately?\n");
-	Base32 encoder(data);
+	for(std::size_t idx = 0; idx < plain.size(); ++idx) {
+		plain[idx] = static_cast<char>(idx * 151 + 13);
+	}
 
-	std::cout << "Plain: \"" << data.data() << "\"\n";
-	// expected: "O5UGC5BANBQXMZJAPFXXKIDEN5XGKIDGN5ZCA3LFEBWGC5DFNR4T6CQ="
-	std::cout << "Base32: \"" << encoder.encoded().data() << "\"\n";
+	const auto encoded = Base32(plain).encoded();
+	QCOMPARE(encoded.size(), LibQonvince::Base32Codec::encodedSize(plain.size()));
 
-	encoder.setEncoded(encoder.encoded());
-	std::cout << "Plain: \"" << encoder.plain().data() << "\"\n";
-	return 0;
+	Base32 decoder;
+	QVERIFY(decoder.setEncoded(encoded));
+	QCOMPARE(decoder.plain(), plain);
+
+	// the span functions must agree with the Base32 class
+	std::vector<char> decoded(plain.size());
+	const auto decodedSize = LibQonvince::Base32Codec::decode(std::span<const char>(encoded), std::span<char>(decoded));
+	QVERIFY(decodedSize);
+	QCOMPARE(*decodedSize, plain.size());
+	QVERIFY(std::equal(plain.cbegin(), plain.cend(), decoded.cbegin()));
+}
+
+void Base32Test::invalid_data()
+{
+	QTest::addColumn<QByteArray>("encoded");
+
+	QTest::newRow("invalid character") << QByteArray("MZXW1===");
+	QTest::newRow("lower case") << QByteArray("mzxw6===");
+	QTest::newRow("missing padding") << QByteArray("MZXW6");
+	QTest::newRow("impossible length") << QByteArray("MZX=====");
+	QTest::newRow("data after padding") << QByteArray("MY======MY======");
+	QTest::newRow("whitespace") << QByteArray("MZXW 6===");
+}
+
+void Base32Test::invalid()
+{
+	QFETCH(QByteArray, encoded);
+
+	// strictly RFC 4648 - by default missing padding is tolerated
+	Base32 codec;
+	QVERIFY(!codec.setEncoded(toStdString(encoded), Normalise::None));
+}
+
+void Base32Test::lenient_data()
+{
+	QTest::addColumn<QByteArray>("encoded");
+	QTest::addColumn<QByteArray>("plain");
+
+	QTest::newRow("lower case") << QByteArray("mzxw6ytboi======") << QByteArray("foobar");
+	QTest::newRow("grouped") << QByteArray("MZXW 6YTB OI") << QByteArray("foobar");
+	QTest::newRow("hyphenated") << QByteArray("mzxw-6ytb-oi") << QByteArray("foobar");
+	QTest::newRow("unpadded") << QByteArray("MZXW6YQ") << QByteArray("foob");
 }
+
+void Base32Test::lenient()
+{
+	QFETCH(QByteArray, encoded);
+	QFETCH(QByteArray, plain);
+
+	Base32 codec;
+	QVERIFY(codec.setEncoded(toStdString(encoded), Normalise::Lenient));
+	QCOMPARE(codec.plain(), toStdString(plain));
+}
+
+void Base32Test::streaming()
+{
+	const std::string plain = "what have you done for me lately?\n";
+	const auto encoded = Base32(plain).encoded();
+
+	// feed the encoded data in awkwardly-sized chunks. each update() needs room for the most a chunk could decode to,
+	// which for the chunks containing padding is more than they actually decode to
+	LibQonvince::Base32Codec::Decoder decoder;
+	std::vector<char> decoded(plain.size() + LibQonvince::Base32Codec::Decoder::maxUpdateSize(3));
+	std::size_t decodedSize = 0;
+
+	for(std::size_t offset = 0; offset < encoded.size(); offset += 3) {
+		const auto chunk = std::span<const char>(encoded).subspan(offset, std::min<std::size_t>(3, encoded.size() - offset));
+		const auto written = decoder.update(chunk, std::span<char>(decoded).subspan(decodedSize));
+		QVERIFY(written);
+		decodedSize += *written;
+	}
+
+	QVERIFY(decoder.finish());
+	QCOMPARE(std::string(decoded.data(), decodedSize), plain);
+}
+
+QTEST_APPLESS_MAIN(Base32Test)
+#include "base32.moc"
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <QtTest>
+#include <QProcess>
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QtCrypto>
+#include "application.h"
+#include "functions.h"
+
+using Qonvince::Application;
+using Qonvince::Otp;
+
+/**
+ * Runs "qonvince --code" against a vault in a temporary directory.
+ *
+ * Scripts capture the code from stdout, so it must be the only thing written there, whether the OTP's display plugin is
+ * built in or has to be loaded from a file. Seeds are decoded as leniently as the application decodes them.
+ */
+class CommandLineTest
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void code_data();
+	void code();
+
+private:
+	QByteArray runCode(const QString & id);
+
+	QCA::Initializer m_qcaInitializer;
+	QTemporaryDir m_home;
+};
+
+namespace
+{
+	// the seed used by the RFC 4226 test vectors, Base32 encoded
+	const QByteArray Rfc4226Seed = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+	const QByteArray Passphrase = "qonvince-test-passphrase";
+	const QString Issuer = QStringLiteral("Example");
+
+	// the same seed as the application accepts it when it's typed: lower case and grouped
+	const QByteArray LenientRfc4226Seed = "gezd gnbv gy3t qojq gezd gnbv gy3t qojq";
+
+	struct TestOtp
+	{
+		QString name;
+		QString pluginName;
+		QByteArray seed;
+	};
+
+	// all are six digits with the same seed, so all give the RFC 4226 HOTP value for counter 0
+	const std::array<TestOtp, 3> TestOtps = {{
+		{QStringLiteral("builtin"), QStringLiteral("SixDigitsPlugin"), Rfc4226Seed},
+		{QStringLiteral("legacy"), QStringLiteral("LegacySixDigitsPlugin"), Rfc4226Seed},
+		{QStringLiteral("lenient"), QStringLiteral("SixDigitsPlugin"), LenientRfc4226Seed},
+	}};
+}	// namespace
+
+void CommandLineTest::initTestCase()
+{
+	QVERIFY(m_home.isValid());
+
+	if(!QCA::isSupported("aes256-cbc")) {
+		QSKIP("AES256 encryption is not available");
+	}
+
+	// where the application finds its settings when XDG_CONFIG_HOME is the config directory in m_home
+	QSettings settings(m_home.filePath(QStringLiteral("config/Equit/Qonvince.conf")), QSettings::IniFormat);
+	const QCA::SecureArray passphrase(Passphrase);
+	Application::writeCryptCheck(settings, passphrase);
+	settings.beginGroup(QStringLiteral("codes"));
+	settings.setValue(QStringLiteral("code_count"), static_cast<int>(TestOtps.size()));
+
+	// the same keys as Otp::writeSettings()
+	for(std::size_t idx = 0; idx < TestOtps.size(); ++idx) {
+		const auto encryptedSeed = Otp::encryptSeed(TestOtps[idx].seed, passphrase);
+		QVERIFY(encryptedSeed);
+
+		settings.beginGroup(QStringLiteral("code-%1").arg(idx));
+		settings.setValue(QStringLiteral("issuer"), Issuer);
+		settings.setValue(QStringLiteral("name"), TestOtps[idx].name);
+		settings.setValue(QStringLiteral("pluginName"), TestOtps[idx].pluginName);
+		settings.setValue(QStringLiteral("seed"), *encryptedSeed);
+		settings.setValue(QStringLiteral("type"), QStringLiteral("HOTP"));
+		settings.setValue(QStringLiteral("counter"), 0);
+		settings.endGroup();
+	}
+
+	settings.endGroup();
+	settings.sync();
+	QCOMPARE(settings.status(), QSettings::NoError);
+}
+
+QByteArray CommandLineTest::runCode(const QString & id)
+{
+	auto environment = QProcessEnvironment::systemEnvironment();
+	environment.insert(QStringLiteral("XDG_CONFIG_HOME"), m_home.filePath(QStringLiteral("config")));
+	environment.insert(QStringLiteral("XDG_DATA_HOME"), m_home.filePath(QStringLiteral("data")));
+
+	QProcess qonvince;
+	qonvince.setProcessEnvironment(environment);
+	qonvince.start(QStringLiteral(QONVINCE_TEST_EXECUTABLE), {QStringLiteral("--code"), id, QStringLiteral("--plugin-path"), QStringLiteral(QONVINCE_TEST_LEGACY_PLUGIN_DIR)});
+
+	if(!qonvince.waitForStarted()) {
+		return {};
+	}
+
+	qonvince.write(Passphrase + '\n');
+	qonvince.closeWriteChannel();
+
+	if(!qonvince.waitForFinished() || QProcess::NormalExit != qonvince.exitStatus() || 0 != qonvince.exitCode()) {
+		qWarning() << qonvince.readAllStandardError();
+		return {};
+	}
+
+	return qonvince.readAllStandardOutput();
+}
+
+void CommandLineTest::code_data()
+{
+	QTest::addColumn<QString>("name");
+
+	for(const auto & otp : TestOtps) {
+		QTest::newRow(qPrintable(otp.name)) << otp.name;
+	}
+}
+
+void CommandLineTest::code()
+{
+	QFETCH(QString, name);
+	QCOMPARE(runCode(Qonvince::otpIdentifier(Issuer, name)), QByteArray("755224\n"));
+}
+
+QTEST_GUILESS_MAIN(CommandLineTest)
+#include "commandline.moc"
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QONVINCE_TEST_DISPLAYPLUGINS_H
+#define QONVINCE_TEST_DISPLAYPLUGINS_H
+
+#include <QtGlobal>
+#include "otpdisplayplugin.h"
+#include "pluginfactory.h"
+
+namespace Qonvince::Test
+{
+	using DisplayPluginFactory = PluginFactory<LibQonvince::OtpDisplayPlugin>;
+
+	/**
+	 * Load the display plugins built alongside the tests.
+	 *
+	 * The directories are provided by the test's CMakeLists.txt.
+	 */
+	inline void loadBuiltDisplayPlugins(DisplayPluginFactory & factory)
+	{
+		for(const auto * path : {QONVINCE_TEST_INTEGER_PLUGIN_DIR, QONVINCE_TEST_STEAM_PLUGIN_DIR}) {
+			factory.addSearchPath(path);
+		}
+
+		factory.loadAllPlugins();
+	}
+}	// namespace Qonvince::Test
+
+#endif  // QONVINCE_TEST_DISPLAYPLUGINS_H
@@ -0,0 +1,218 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusPendingCall>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include "application.h"
+#include "dbusservice.h"
+#include "functions.h"
+#include "otp.h"
+
+using Qonvince::DBusService;
+using Qonvince::Otp;
+using Qonvince::OtpType;
+
+namespace
+{
+	// the seed used by the RFC 4226 test vectors, Base32 encoded
+	const QByteArray Rfc4226Seed = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+	const QString Issuer = QStringLiteral("Example");
+
+	// the RFC 4226 HOTP values for counters 0 and 1
+	const QString FirstCode = QStringLiteral("755224");
+	const QString SecondCode = QStringLiteral("287082");
+
+	const QString Interface = QStringLiteral("dev.equit.Qonvince.Codes");
+}	// namespace
+
+// receives the CodeChanged signal from the bus
+class CodeChangedReceiver
+: public QObject
+{
+	Q_OBJECT
+
+public Q_SLOTS:
+	void onCodeChanged(const QString & id, const QString & code)
+	{
+		Q_EMIT codeChanged(id, code);
+	}
+
+Q_SIGNALS:
+	void codeChanged(const QString & id, const QString & code);
+};
+
+/**
+ * Talks to the DBusService over the session bus, as another application would.
+ *
+ * The bus is provided by running the test under dbus-run-session. The calls are made on a separate connection so that
+ * they go through the bus daemon, and they are asynchronous because the service answers them on this thread.
+ */
+class DBusServiceTest
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void cleanup();
+	void listOtps();
+	void getCode();
+	void getCodeRevealOnDemand();
+	void getCodes();
+	void codeChanged();
+
+private:
+	QDBusMessage call(const QString & method, const QVariantList & args = {});
+
+	QDBusConnection m_client = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("dbusservice-test-client"));
+	Otp * m_visibleOtp = nullptr;
+	Otp * m_onDemandOtp = nullptr;
+};
+
+QDBusMessage DBusServiceTest::call(const QString & method, const QVariantList & args)
+{
+	auto message = QDBusMessage::createMethodCall(QString::fromLatin1(DBusService::ServiceName), QString::fromLatin1(DBusService::ObjectPath), Interface, method);
+	message.setArguments(args);
+	const auto pending = m_client.asyncCall(message);
+	QDBusPendingCallWatcher watcher(pending);
+
+	if(!watcher.isFinished()) {
+		QSignalSpy finished(&watcher, &QDBusPendingCallWatcher::finished);
+		finished.wait();
+	}
+
+	return watcher.reply();
+}
+
+void DBusServiceTest::initTestCase()
+{
+	QVERIFY2(m_client.isConnected(), "no session bus - run the test with dbus-run-session");
+
+	m_visibleOtp = new Otp(OtpType::Hotp, Issuer, QStringLiteral("visible"), Rfc4226Seed, Otp::SeedType::Base32);
+	m_visibleOtp->setDisplayPluginName(QStringLiteral("SixDigitsPlugin"));
+	m_onDemandOtp = new Otp(OtpType::Hotp, Issuer, QStringLiteral("ondemand"), Rfc4226Seed, Otp::SeedType::Base32);
+	m_onDemandOtp->setDisplayPluginName(QStringLiteral("SixDigitsPlugin"));
+	m_onDemandOtp->setRevealOnDemand(true);
+
+	// the service watches OTPs added before and after it is created
+	qonvinceApp->addOtp(m_visibleOtp);
+	QVERIFY((new DBusService(qonvinceApp))->registerService());
+	qonvinceApp->addOtp(m_onDemandOtp);
+}
+
+void DBusServiceTest::cleanup()
+{
+	m_onDemandOtp->hide();
+}
+
+void DBusServiceTest::listOtps()
+{
+	// hiding the code doesn't hide the OTP
+	const auto reply = call(QStringLiteral("ListOtps"));
+	QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+	QCOMPARE(reply.arguments().value(0).toStringList(), (QStringList{Qonvince::otpIdentifier(m_visibleOtp), Qonvince::otpIdentifier(m_onDemandOtp)}));
+}
+
+void DBusServiceTest::getCode()
+{
+	auto reply = call(QStringLiteral("GetCode"), {Qonvince::otpIdentifier(m_visibleOtp)});
+	QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+	QCOMPARE(reply.arguments().value(0).toString(), FirstCode);
+
+	reply = call(QStringLiteral("GetCode"), {Qonvince::otpIdentifier(Issuer, QStringLiteral("missing"))});
+	QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+}
+
+void DBusServiceTest::getCodeRevealOnDemand()
+{
+	const auto id = Qonvince::otpIdentifier(m_onDemandOtp);
+	auto reply = call(QStringLiteral("GetCode"), {id});
+	QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+	QCOMPARE(reply.errorName(), QStringLiteral("org.freedesktop.DBus.Error.AccessDenied"));
+
+	m_onDemandOtp->reveal();
+	reply = call(QStringLiteral("GetCode"), {id});
+	QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+	QCOMPARE(reply.arguments().value(0).toString(), FirstCode);
+
+	m_onDemandOtp->hide();
+	reply = call(QStringLiteral("GetCode"), {id});
+	QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+}
+
+void DBusServiceTest::getCodes()
+{
+	const QStringList ids = {
+		Qonvince::otpIdentifier(m_onDemandOtp),
+		Qonvince::otpIdentifier(Issuer, QStringLiteral("missing")),
+		Qonvince::otpIdentifier(m_visibleOtp),
+	};
+
+	auto reply = call(QStringLiteral("GetCodes"), {QVariant(ids)});
+	QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+	QCOMPARE(reply.arguments().value(0).toStringList(), (QStringList{QString(), QString(), FirstCode}));
+
+	m_onDemandOtp->reveal();
+	reply = call(QStringLiteral("GetCodes"), {QVariant(ids)});
+	QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+	QCOMPARE(reply.arguments().value(0).toStringList(), (QStringList{FirstCode, QString(), FirstCode}));
+}
+
+void DBusServiceTest::codeChanged()
+{
+	CodeChangedReceiver receiver;
+	QVERIFY(m_client.connect(QString::fromLatin1(DBusService::ServiceName), QString::fromLatin1(DBusService::ObjectPath), Interface, QStringLiteral("CodeChanged"), &receiver, SLOT(onCodeChanged(QString,QString))));
+	QSignalSpy changes(&receiver, &CodeChangedReceiver::codeChanged);
+
+	// signals arrive in the order they're emitted, so if the hidden code were broadcast it would arrive first
+	m_onDemandOtp->incrementCounter();
+	m_visibleOtp->incrementCounter();
+	QVERIFY(changes.wait());
+
+	QCOMPARE(changes.size(), 1);
+	QCOMPARE(changes.at(0).value(0).toString(), Qonvince::otpIdentifier(m_visibleOtp));
+	QCOMPARE(changes.at(0).value(1).toString(), SecondCode);
+}
+
+int main(int argc, char ** argv)
+{
+	// the service needs the real application, which must not touch the user's own settings
+	QTemporaryDir home;
+
+	if(!home.isValid()) {
+		return 1;
+	}
+
+	qputenv("XDG_CONFIG_HOME", QFile::encodeName(home.filePath(QStringLiteral("config"))));
+	qputenv("XDG_DATA_HOME", QFile::encodeName(home.filePath(QStringLiteral("data"))));
+
+	if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	}
+
+	Qonvince::Application app(argc, argv);
+	DBusServiceTest test;
+	return QTest::qExec(&test, argc, argv);
+}
+
+#include "dbusservice.moc"
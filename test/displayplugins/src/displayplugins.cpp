@@ -0,0 +1,320 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <string_view>
+#include <vector>
+#include <QtTest>
+#include "application.h"
+#include "codebatch.h"
+#include "otp.h"
+#include "securestring.h"
+#include "../../common/displayplugins.h"
+
+using LibQonvince::SecureString;
+using Qonvince::Otp;
+
+class DisplayPluginsTest
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void sixDigits_data();
+	void sixDigits();
+	void eightDigits_data();
+	void eightDigits();
+	void integerTruncation_data();
+	void integerTruncation();
+	void steam();
+	void handles();
+	void batch();
+	void codeBatch();
+	void builtIns();
+	void legacyPlugin();
+
+private:
+	const LibQonvince::OtpDisplayPlugin & plugin(const char * name);
+
+	Qonvince::Test::DisplayPluginFactory m_factory{".displayplugin"};
+};
+
+namespace
+{
+	// the seed used by the RFC 4226 and RFC 6238 test vectors
+	const SecureString Rfc4226Seed = "12345678901234567890";
+
+	SecureString toSecureString(const QByteArray & bytes)
+	{
+		return {bytes.constData(), static_cast<std::size_t>(bytes.size())};
+	}
+}	// namespace
+
+void DisplayPluginsTest::initTestCase()
+{
+	Qonvince::Test::loadBuiltDisplayPlugins(m_factory);
+	QVERIFY(m_factory.pluginByName("SixDigitsPlugin"));
+	QVERIFY(m_factory.pluginByName("EightDigitsPlugin"));
+	QVERIFY(m_factory.pluginByName("SteamOtpDisplayPlugin"));
+}
+
+const LibQonvince::OtpDisplayPlugin & DisplayPluginsTest::plugin(const char * name)
+{
+	return *m_factory.pluginByName(name);
+}
+
+void DisplayPluginsTest::sixDigits_data()
+{
+	QTest::addColumn<quint64>("counter");
+	QTest::addColumn<QByteArray>("expected");
+
+	// RFC 4226 appendix D
+	QTest::newRow("count 0") << Q_UINT64_C(0) << QByteArray("755224");
+	QTest::newRow("count 1") << Q_UINT64_C(1) << QByteArray("287082");
+	QTest::newRow("count 2") << Q_UINT64_C(2) << QByteArray("359152");
+	QTest::newRow("count 3") << Q_UINT64_C(3) << QByteArray("969429");
+	QTest::newRow("count 4") << Q_UINT64_C(4) << QByteArray("338314");
+	QTest::newRow("count 5") << Q_UINT64_C(5) << QByteArray("254676");
+	QTest::newRow("count 6") << Q_UINT64_C(6) << QByteArray("287922");
+	QTest::newRow("count 7") << Q_UINT64_C(7) << QByteArray("162583");
+	QTest::newRow("count 8") << Q_UINT64_C(8) << QByteArray("399871");
+	QTest::newRow("count 9") << Q_UINT64_C(9) << QByteArray("520489");
+}
+
+void DisplayPluginsTest::sixDigits()
+{
+	QFETCH(quint64, counter);
+	QFETCH(QByteArray, expected);
+
+	QCOMPARE(plugin("SixDigitsPlugin").codeDisplayString(Otp::hotp(Rfc4226Seed, counter)), toSecureString(expected));
+}
+
+void DisplayPluginsTest::eightDigits_data()
+{
+	QTest::addColumn<qint64>("time");
+	QTest::addColumn<QByteArray>("expected");
+
+	// RFC 6238 appendix B, SHA1 only
+	QTest::newRow("59") << Q_INT64_C(59) << QByteArray("94287082");
+	QTest::newRow("1111111109") << Q_INT64_C(1111111109) << QByteArray("07081804");
+	QTest::newRow("1111111111") << Q_INT64_C(1111111111) << QByteArray("14050471");
+	QTest::newRow("1234567890") << Q_INT64_C(1234567890) << QByteArray("89005924");
+	QTest::newRow("2000000000") << Q_INT64_C(2000000000) << QByteArray("69279037");
+	QTest::newRow("20000000000") << Q_INT64_C(20000000000) << QByteArray("65353130");
+}
+
+void DisplayPluginsTest::eightDigits()
+{
+	QFETCH(qint64, time);
+	QFETCH(QByteArray, expected);
+
+	QCOMPARE(plugin("EightDigitsPlugin").codeDisplayString(Otp::totpAt(Rfc4226Seed, static_cast<time_t>(time), 0, Otp::DefaultInterval)), toSecureString(expected));
+}
+
+void DisplayPluginsTest::integerTruncation_data()
+{
+	QTest::addColumn<QByteArray>("hmac");
+	QTest::addColumn<QByteArray>("sixDigits");
+	QTest::addColumn<QByteArray>("eightDigits");
+
+	// the last nibble is the offset of the 4 bytes used. the top bit of those bytes is always ignored
+	auto highestOffset = QByteArray(20, '\xff');
+	highestOffset[19] = '\x0f';
+	QTest::newRow("highest offset, top bit set") << highestOffset << QByteArray("483647") << QByteArray("47483647");
+
+	// small values are padded with leading zeroes
+	auto smallValue = QByteArray(20, '\0');
+	smallValue[3] = '\x01';
+	QTest::newRow("leading zeroes") << smallValue << QByteArray("000001") << QByteArray("00000001");
+
+	auto zero = QByteArray(20, '\0');
+	zero[0] = '\x80';
+	QTest::newRow("zero") << zero << QByteArray("000000") << QByteArray("00000000");
+}
+
+void DisplayPluginsTest::integerTruncation()
+{
+	QFETCH(QByteArray, hmac);
+	QFETCH(QByteArray, sixDigits);
+	QFETCH(QByteArray, eightDigits);
+
+	QCOMPARE(plugin("SixDigitsPlugin").codeDisplayString(toSecureString(hmac)), toSecureString(sixDigits));
+	QCOMPARE(plugin("EightDigitsPlugin").codeDisplayString(toSecureString(hmac)), toSecureString(eightDigits));
+}
+
+void DisplayPluginsTest::steam()
+{
+	static constexpr const std::string_view Alphabet = "23456789BCDFGHJKMNPQRTVWXY";
+
+	for(quint64 counter = 0; counter < 10; ++counter) {
+		const auto code = plugin("SteamOtpDisplayPlugin").codeDisplayString(Otp::hotp(Rfc4226Seed, counter));
+		QCOMPARE(code.size(), std::size_t{5});
+		QVERIFY(std::all_of(code.cbegin(), code.cend(), [](char ch) {
+			return std::string_view::npos != Alphabet.find(ch);
+		}));
+	}
+
+	// pins the current output so that changes to the plugin don't alter the codes users see. the plugin reads the HMAC
+	// in host byte order, so the code is only known for little-endian hosts
+	if constexpr(std::endian::little == std::endian::native) {
+		QCOMPARE(plugin("SteamOtpDisplayPlugin").codeDisplayString(Otp::hotp(Rfc4226Seed, 0)), SecureString("JQ8W2"));
+	}
+}
+
+void DisplayPluginsTest::handles()
+{
+	const auto generation = m_factory.generation();
+	std::vector<Qonvince::Test::DisplayPluginFactory::Handle> handles;
+
+	for(const auto * name : {"SixDigitsPlugin", "EightDigitsPlugin", "SteamOtpDisplayPlugin"}) {
+		const auto handle = m_factory.handleByName(name);
+		QVERIFY(Qonvince::Test::DisplayPluginFactory::InvalidHandle != handle);
+		QCOMPARE(m_factory.plugin(handle), m_factory.pluginByName(name));
+		QVERIFY(handles.cend() == std::find(handles.cbegin(), handles.cend(), handle));
+		handles.push_back(handle);
+	}
+
+	QCOMPARE(m_factory.handleByName("NoSuchPlugin"), Qonvince::Test::DisplayPluginFactory::InvalidHandle);
+	QVERIFY(!m_factory.plugin(Qonvince::Test::DisplayPluginFactory::InvalidHandle));
+	QVERIFY(!m_factory.plugin(static_cast<Qonvince::Test::DisplayPluginFactory::Handle>(m_factory.loadedPlugins().size())));
+
+	// looking plugins up doesn't change the set that's loaded, so handles resolved earlier remain current
+	QCOMPARE(m_factory.generation(), generation);
+}
+
+void DisplayPluginsTest::batch()
+{
+	using LibQonvince::OtpDisplayPlugin;
+	constexpr const std::size_t BatchSize = 10;
+
+	std::vector<char> digests(BatchSize * OtpDisplayPlugin::DigestSize);
+
+	for(std::size_t idx = 0; idx < BatchSize; ++idx) {
+		const auto hmac = Otp::hotp(Rfc4226Seed, idx);
+		std::copy_n(hmac.cbegin(), OtpDisplayPlugin::DigestSize, digests.begin() + static_cast<std::ptrdiff_t>(idx * OtpDisplayPlugin::DigestSize));
+	}
+
+	for(const auto * name : {"SixDigitsPlugin", "EightDigitsPlugin", "SteamOtpDisplayPlugin"}) {
+		const auto & displayPlugin = plugin(name);
+
+		// one spare slot so that a batch that overruns would show up
+		std::vector<char> codes((BatchSize + 1) * OtpDisplayPlugin::MaxCodeLength, '\0');
+		std::vector<std::size_t> lengths(BatchSize + 1, 0);
+		displayPlugin.writeCodes(digests, codes, lengths);
+
+		for(std::size_t idx = 0; idx < BatchSize; ++idx) {
+			const auto expected = displayPlugin.codeDisplayString(Otp::hotp(Rfc4226Seed, idx));
+			QCOMPARE(SecureString(codes.data() + idx * OtpDisplayPlugin::MaxCodeLength, lengths[idx]), expected);
+		}
+
+		QCOMPARE(lengths.back(), std::size_t{0});
+	}
+}
+
+void DisplayPluginsTest::codeBatch()
+{
+	const std::array<const char *, 3> names = {"SixDigitsPlugin", "EightDigitsPlugin", "SteamOtpDisplayPlugin"};
+	Qonvince::CodeBatch batch;
+	std::vector<std::pair<std::size_t, SecureString>> expected;
+
+	// the plugins are interleaved so that the batch has to group the codes by plugin and put them back in order
+	for(std::uint64_t counter = 0; counter < 12; ++counter) {
+		const auto & displayPlugin = plugin(names[counter % names.size()]);
+		const auto hmac = Otp::hotp(Rfc4226Seed, counter);
+		expected.emplace_back(batch.add(displayPlugin, hmac), displayPlugin.codeDisplayString(hmac));
+	}
+
+	const auto tooShort = batch.add(plugin("SixDigitsPlugin"), SecureString("short"));
+	QCOMPARE(batch.size(), expected.size() + 1);
+	batch.write();
+
+	for(const auto & [index, code] : expected) {
+		QCOMPARE(SecureString(batch.code(index).data(), batch.code(index).size()), code);
+	}
+
+	QVERIFY(batch.code(tooShort).empty());
+	QVERIFY(batch.code(batch.size()).empty());
+}
+
+void DisplayPluginsTest::builtIns()
+{
+	// no search paths, so anything the factory has must have been built in
+	Qonvince::Application::DisplayPluginFactory builtInFactory(".displayplugin");
+	Qonvince::Application::addBuiltInDisplayPlugins(builtInFactory);
+	const auto generation = builtInFactory.generation();
+	QCOMPARE(builtInFactory.loadedPlugins().size(), std::size_t{3});
+
+	for(const auto * name : {"SixDigitsPlugin", "EightDigitsPlugin", "SteamOtpDisplayPlugin"}) {
+		const auto * builtIn = builtInFactory.pluginByName(name);
+		QVERIFY(builtIn);
+
+		for(std::uint64_t counter = 0; counter < 10; ++counter) {
+			const auto hmac = Otp::hotp(Rfc4226Seed, counter);
+			QCOMPARE(builtIn->codeDisplayString(hmac), plugin(name).codeDisplayString(hmac));
+		}
+	}
+
+	// the same plugins can't be built in twice
+	Qonvince::Application::addBuiltInDisplayPlugins(builtInFactory);
+	QCOMPARE(builtInFactory.loadedPlugins().size(), std::size_t{3});
+	QCOMPARE(builtInFactory.generation(), generation);
+}
+
+void DisplayPluginsTest::legacyPlugin()
+{
+	using LibQonvince::OtpDisplayPlugin;
+	constexpr const std::size_t BatchSize = 10;
+
+	// the fixture is a six-digit plugin built against API version 2, so it's loaded through the adapter
+	Qonvince::Test::DisplayPluginFactory legacyFactory(".displayplugin");
+	legacyFactory.addSearchPath(QONVINCE_TEST_LEGACY_PLUGIN_DIR);
+	const auto * legacy = legacyFactory.pluginByName("LegacySixDigitsPlugin");
+	QVERIFY(legacy);
+
+	// each of these is a call through a different slot of the old plugin's vtable
+	QCOMPARE(legacy->name(), std::string("LegacySixDigitsPlugin"));
+	QCOMPARE(legacy->displayName(), std::string("Legacy six digits"));
+	QCOMPARE(legacy->description(), std::string("Six decimal digits, from a plugin built against API version 2."));
+	QCOMPARE(legacy->author(), std::string("Darren Edale"));
+	QCOMPARE(legacy->versionString(), std::string("1.0.0"));
+
+	const auto & current = plugin("SixDigitsPlugin");
+	std::vector<char> digests(BatchSize * OtpDisplayPlugin::DigestSize);
+
+	for(std::size_t idx = 0; idx < BatchSize; ++idx) {
+		const auto hmac = Otp::hotp(Rfc4226Seed, idx);
+		std::copy_n(hmac.cbegin(), OtpDisplayPlugin::DigestSize, digests.begin() + static_cast<std::ptrdiff_t>(idx * OtpDisplayPlugin::DigestSize));
+		QCOMPARE(legacy->codeDisplayString(hmac), current.codeDisplayString(hmac));
+	}
+
+	std::vector<char> codes(BatchSize * OtpDisplayPlugin::MaxCodeLength, '\0');
+	std::vector<std::size_t> lengths(BatchSize, 0);
+	legacy->writeCodes(digests, codes, lengths);
+
+	for(std::size_t idx = 0; idx < BatchSize; ++idx) {
+		const auto expected = current.codeDisplayString(Otp::hotp(Rfc4226Seed, idx));
+		QCOMPARE(SecureString(codes.data() + idx * OtpDisplayPlugin::MaxCodeLength, lengths[idx]), expected);
+	}
+}
+
+QTEST_APPLESS_MAIN(DisplayPluginsTest)
+#include "displayplugins.moc"
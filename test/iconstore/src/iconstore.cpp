@@ -0,0 +1,288 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QIcon>
+#include <QImage>
+#include <QPixmap>
+#include <QStandardPaths>
+#include "iconstore.h"
+
+using Qonvince::IconStore;
+
+class IconStoreTest
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void cleanup();
+	void keyFor();
+	void writeRenditions_data();
+	void writeRenditions();
+	void addSameImage();
+	void releaseOneReference();
+	void removeUnreferenced();
+	void acquire();
+	void legacyFile();
+
+private:
+	static QImage image(int width, int height, QRgb colour);
+	static QIcon icon(int extent, QRgb colour);
+	static QString iconDirectory();
+
+	// the number of renditions stored for a key
+	static int renditionCount(const QString & key);
+};
+
+QImage IconStoreTest::image(int width, int height, QRgb colour)
+{
+	QImage ret(width, height, QImage::Format_ARGB32);
+	ret.fill(colour);
+	return ret;
+}
+
+QIcon IconStoreTest::icon(int extent, QRgb colour)
+{
+	return QIcon(QPixmap::fromImage(image(extent, extent, colour)));
+}
+
+QString IconStoreTest::iconDirectory()
+{
+	return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + QStringLiteral("/codes/icons");
+}
+
+int IconStoreTest::renditionCount(const QString & key)
+{
+	return QDir(iconDirectory()).entryList({key + QStringLiteral("-*.png")}, QDir::Files).size();
+}
+
+void IconStoreTest::initTestCase()
+{
+	// keep the files the test writes away from the user's own icons
+	QStandardPaths::setTestModeEnabled(true);
+}
+
+void IconStoreTest::cleanup()
+{
+	QDir(iconDirectory()).removeRecursively();
+}
+
+void IconStoreTest::keyFor()
+{
+	const auto red = image(16, 16, qRgb(255, 0, 0));
+	const auto key = IconStore::keyFor(red);
+	QVERIFY(!key.isEmpty());
+
+	// the key only depends on the pixels, so it makes an acceptable icon file name
+	for(const auto & c : key) {
+		QVERIFY(c.isLetterOrNumber());
+	}
+
+	QCOMPARE(IconStore::keyFor(image(16, 16, qRgb(255, 0, 0))), key);
+	QCOMPARE(IconStore::keyFor(red.convertToFormat(QImage::Format_RGB32)), key);
+	QVERIFY(IconStore::keyFor(image(16, 16, qRgb(0, 255, 0))) != key);
+
+	// the same bytes in a different shape are a different image
+	QVERIFY(IconStore::keyFor(image(8, 32, qRgb(255, 0, 0))) != key);
+}
+
+void IconStoreTest::writeRenditions_data()
+{
+	QTest::addColumn<int>("sourceExtent");
+	QTest::addColumn<QList<int>>("expectedExtents");
+	QTest::addColumn<int>("largestExtent");
+
+	QTest::newRow("tiny") << 20 << QList<int>{32} << 20;
+	QTest::newRow("exact") << 64 << QList<int>{32, 64} << 64;
+	QTest::newRow("between") << 100 << QList<int>{32, 64, 128} << 100;
+	QTest::newRow("largest") << 256 << QList<int>{32, 64, 128, 256} << 256;
+	QTest::newRow("oversized") << 300 << QList<int>{32, 64, 128, 256} << 256;
+}
+
+void IconStoreTest::writeRenditions()
+{
+	QFETCH(int, sourceExtent);
+	QFETCH(QList<int>, expectedExtents);
+	QFETCH(int, largestExtent);
+
+	const auto source = image(sourceExtent, sourceExtent, qRgb(0, 0, 255));
+	const auto key = IconStore::keyFor(source);
+	QVERIFY(IconStore::writeRenditions(key, source));
+
+	for(const auto extent : IconStore::RenditionExtents) {
+		const auto path = iconDirectory() + QLatin1Char('/') + IconStore::renditionFileName(key, extent);
+		QCOMPARE(QFile::exists(path), expectedExtents.contains(extent));
+
+		if(!expectedExtents.contains(extent)) {
+			continue;
+		}
+
+		const QImage rendition(path);
+		QCOMPARE(rendition.width(), std::min(extent, largestExtent));
+	}
+
+	// writing the same icon again leaves the existing files alone
+	QVERIFY(IconStore::writeRenditions(key, source));
+	QCOMPARE(QDir(iconDirectory()).entryList(QDir::Files).size(), expectedExtents.size());
+}
+
+void IconStoreTest::addSameImage()
+{
+	IconStore store;
+	const auto key = store.add(icon(64, qRgb(255, 0, 0)));
+	QCOMPARE(key, IconStore::keyFor(image(64, 64, qRgb(255, 0, 0))));
+	const auto shared = store.icon(key);
+	QVERIFY(!shared.isNull());
+
+	// a separate icon with the same pixels shares the stored one
+	QCOMPARE(store.add(icon(64, qRgb(255, 0, 0))), key);
+	QCOMPARE(store.icon(key).cacheKey(), shared.cacheKey());
+
+	store.waitForPendingWork();
+	QCOMPARE(renditionCount(key), 2);
+	QVERIFY(store.add(QIcon()).isEmpty());
+}
+
+void IconStoreTest::releaseOneReference()
+{
+	IconStore store;
+	const auto key = store.add(icon(64, qRgb(255, 0, 0)));
+	QCOMPARE(store.add(icon(64, qRgb(255, 0, 0))), key);
+	store.release(key);
+	store.removeUnreferenced();
+	store.waitForPendingWork();
+
+	QVERIFY(!store.icon(key).isNull());
+	QCOMPARE(renditionCount(key), 2);
+}
+
+void IconStoreTest::removeUnreferenced()
+{
+	IconStore store;
+	const auto key = store.add(icon(64, qRgb(255, 0, 0)));
+	const auto otherKey = store.add(icon(64, qRgb(0, 255, 0)));
+	QCOMPARE(store.add(icon(64, qRgb(255, 0, 0))), key);
+	store.release(key);
+	store.release(key);
+	store.waitForPendingWork();
+
+	// the files stay until the settings no longer name the icon
+	QVERIFY(store.icon(key).isNull());
+	QCOMPARE(renditionCount(key), 2);
+
+	store.removeUnreferenced();
+	store.waitForPendingWork();
+	QCOMPARE(renditionCount(key), 0);
+	QCOMPARE(renditionCount(otherKey), 2);
+}
+
+void IconStoreTest::acquire()
+{
+	const auto source = image(64, 64, qRgb(0, 0, 255));
+	const auto key = IconStore::keyFor(source);
+	QVERIFY(IconStore::writeRenditions(key, source));
+
+	IconStore store;
+	QString acquiredKey;
+	QIcon acquiredIcon;
+
+	const auto callback = [&acquiredKey, &acquiredIcon](const QString & storedKey, const QIcon & storedIcon) {
+		acquiredKey = storedKey;
+		acquiredIcon = storedIcon;
+	};
+
+	// the icon is read on the store's thread, and the result posted back
+	store.acquire(key, this, callback);
+	QVERIFY(acquiredKey.isEmpty());
+	store.waitForPendingWork();
+	QCoreApplication::sendPostedEvents();
+	QCOMPARE(acquiredKey, key);
+	QVERIFY(!acquiredIcon.isNull());
+	QCOMPARE(store.icon(key).cacheKey(), acquiredIcon.cacheKey());
+
+	// once it's in use it's shared straight away
+	acquiredKey.clear();
+	store.acquire(key, this, callback);
+	QCOMPARE(acquiredKey, key);
+	QCOMPARE(store.add(QIcon(QPixmap::fromImage(source))), key);
+	QCOMPARE(store.icon(key).cacheKey(), acquiredIcon.cacheKey());
+
+	// three references
+	store.release(key);
+	store.release(key);
+	store.removeUnreferenced();
+	store.waitForPendingWork();
+	QVERIFY(!store.icon(key).isNull());
+	QCOMPARE(renditionCount(key), 2);
+
+	store.release(key);
+	store.removeUnreferenced();
+	store.waitForPendingWork();
+	QCOMPARE(renditionCount(key), 0);
+}
+
+void IconStoreTest::legacyFile()
+{
+	// earlier versions stored a single file named with a random hash
+	const QString legacyKey = QStringLiteral("0123456789abcdef0123456789abcdef");
+	const auto source = image(64, 64, qRgb(255, 255, 0));
+	const auto contentKey = IconStore::keyFor(source);
+	const auto legacyPath = iconDirectory() + QLatin1Char('/') + legacyKey;
+	QVERIFY(QDir().mkpath(iconDirectory()));
+	QVERIFY(source.save(legacyPath, "PNG"));
+
+	IconStore store;
+	QString acquiredKey;
+	QIcon acquiredIcon;
+
+	store.acquire(legacyKey, this, [&acquiredKey, &acquiredIcon](const QString & storedKey, const QIcon & storedIcon) {
+		acquiredKey = storedKey;
+		acquiredIcon = storedIcon;
+	});
+
+	store.waitForPendingWork();
+	QCoreApplication::sendPostedEvents();
+
+	// the icon moves to its content key, but the old file is kept until the settings have been rewritten
+	QCOMPARE(acquiredKey, contentKey);
+	QVERIFY(!acquiredIcon.isNull());
+	QVERIFY(store.icon(legacyKey).isNull());
+	QCOMPARE(store.icon(contentKey).cacheKey(), acquiredIcon.cacheKey());
+	QCOMPARE(renditionCount(contentKey), 2);
+	QVERIFY(QFile::exists(legacyPath));
+
+	store.removeUnreferenced();
+	store.waitForPendingWork();
+	QVERIFY(!QFile::exists(legacyPath));
+	QCOMPARE(renditionCount(contentKey), 2);
+
+	// the reference taken for the old key is held by the content key
+	store.release(contentKey);
+	store.removeUnreferenced();
+	store.waitForPendingWork();
+	QCOMPARE(renditionCount(contentKey), 0);
+}
+
+QTEST_MAIN(IconStoreTest)
+#include "iconstore.moc"
@@ -0,0 +1,29 @@
+#include "legacysixdigits.h"
+
+#include <cstdint>
+
+static_assert(2 == LIBQONVINCE_OTPDISPLAYPLUGIN_PLUGIN_API_VERSION, "the legacy plugin fixture must be built against API version 2");
+
+SecureString LegacySixDigitsPlugin::codeDisplayString(const SecureString & hmac) const
+{
+    // calculate offset and read value from 4 bytes at offset
+    int offset = static_cast<char>(hmac[19]) & 0xf;
+    auto value = static_cast<uint32_t>((hmac[offset] & 0x7f) << 24 | (hmac[offset + 1] & 0xff) << 16 | (hmac[offset + 2] & 0xff) << 8 |
+                                       (hmac[offset + 3] & 0xff));
+    value = value % 1000000;
+
+    // initialise the returned string to all 0s so we don't need to pad it later
+    auto ret = SecureString(6, '0');
+    auto pos = 5;
+
+    // insert the digits from the value from right to left
+    while (0 < value) {
+        ret[pos] = static_cast<char>('0' + (value % 10));
+        --pos;
+        value /= 10;
+    }
+
+    return ret;
+}
+
+DECLARE_LIBQONVINCE_OTPDISPLAYPLUGIN(LegacySixDigitsPlugin, "Legacy six digits", "Six decimal digits, from a plugin built against API version 2.", "Darren Edale", "1.0.0")
@@ -0,0 +1,20 @@
+#ifndef QONVINCE_TEST_LEGACYSIXDIGITS_H
+#define QONVINCE_TEST_LEGACYSIXDIGITS_H
+
+// the API version 2 header alongside this file, not the current one
+#include "otpdisplayplugin.h"
+#include "securestring.h"
+
+using LibQonvince::SecureString;
+
+// six decimal digits, implemented as display plugins were at API version 2
+class LegacySixDigitsPlugin
+        : public LibQonvince::OtpDisplayPlugin
+{
+LIBQONVINCE_OTPDISPLAYPLUGIN
+
+public:
+    SecureString codeDisplayString(const SecureString & hmac) const override;
+};
+
+#endif  // QONVINCE_TEST_LEGACYSIXDIGITS_H
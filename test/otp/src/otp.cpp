@@ -0,0 +1,163 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+#include "otp.h"
+#include "clock.h"
+#include "securestring.h"
+
+using LibQonvince::SecureString;
+using Qonvince::Otp;
+
+class OtpTest
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void hmac_data();
+	void hmac();
+	void hotp_data();
+	void hotp();
+	void totp_data();
+	void totp();
+	void totpBaseline();
+	void totpVirtualClock();
+	void countdown();
+};
+
+namespace
+{
+	// the seed used by the RFC 4226 and RFC 6238 test vectors
+	const SecureString Rfc4226Seed = "12345678901234567890";
+
+	QByteArray toHex(const SecureString & bytes)
+	{
+		return QByteArray(bytes.data(), static_cast<int>(bytes.size())).toHex();
+	}
+
+	SecureString toSecureString(const QByteArray & bytes)
+	{
+		return {bytes.constData(), static_cast<std::size_t>(bytes.size())};
+	}
+}	// namespace
+
+void OtpTest::hmac_data()
+{
+	QTest::addColumn<QByteArray>("key");
+	QTest::addColumn<QByteArray>("message");
+	QTest::addColumn<QByteArray>("expected");
+
+	// RFC 2202 HMAC-SHA1 test cases
+	QTest::newRow("rfc2202 case 2") << QByteArray("Jefe") << QByteArray("what do ya want for nothing?") << QByteArray("effcdf6ae5eb2fa2d27416d5f184df9c259a7c79");
+	QTest::newRow("rfc2202 case 6 (key longer than block)") << QByteArray(80, '\xaa') << QByteArray("Test Using Larger Than Block-Size Key - Hash Key First") << QByteArray("aa4ae5e15272d00e95705637ce8a3b55ed402112");
+
+	// keys are binary so nul bytes must not truncate them
+	QTest::newRow("key containing nul") << QByteArray("\x00\x01\x02\x00seed", 8) << QByteArray("\x00\x00\x00\x00\x00\x00\x00\x01", 8) << QByteArray("0cd7f3b3f0c7116e1a2d087f85b91c9241564aba");
+}
+
+void OtpTest::hmac()
+{
+	QFETCH(QByteArray, key);
+	QFETCH(QByteArray, message);
+	QFETCH(QByteArray, expected);
+
+	QCOMPARE(toHex(Otp::hmac(toSecureString(key), message)), expected);
+}
+
+void OtpTest::hotp_data()
+{
+	QTest::addColumn<quint64>("counter");
+	QTest::addColumn<QByteArray>("expected");
+
+	// RFC 4226 appendix D intermediate HMAC values. several contain nul bytes, which must not truncate the result
+	QTest::newRow("count 0") << Q_UINT64_C(0) << QByteArray("cc93cf18508d94934c64b65d8ba7667fb7cde4b0");
+	QTest::newRow("count 1") << Q_UINT64_C(1) << QByteArray("75a48a19d4cbe100644e8ac1397eea747a2d33ab");
+	QTest::newRow("count 2") << Q_UINT64_C(2) << QByteArray("0bacb7fa082fef30782211938bc1c5e70416ff44");
+	QTest::newRow("count 3") << Q_UINT64_C(3) << QByteArray("66c28227d03a2d5529262ff016a1e6ef76557ece");
+	QTest::newRow("count 4") << Q_UINT64_C(4) << QByteArray("a904c900a64b35909874b33e61c5938a8e15ed1c");
+	QTest::newRow("count 5") << Q_UINT64_C(5) << QByteArray("a37e783d7b7233c083d4f62926c7a25f238d0316");
+	QTest::newRow("count 6") << Q_UINT64_C(6) << QByteArray("bc9cd28561042c83f219324d3c607256c03272ae");
+	QTest::newRow("count 7") << Q_UINT64_C(7) << QByteArray("a4fb960c0bc06e1eabb804e5b397cdc4b45596fa");
+	QTest::newRow("count 8") << Q_UINT64_C(8) << QByteArray("1b3c89f65e6c9e883012052823443f048b4332db");
+	QTest::newRow("count 9") << Q_UINT64_C(9) << QByteArray("1637409809a679dc698207310c8c7fc07290d9e5");
+}
+
+void OtpTest::hotp()
+{
+	QFETCH(quint64, counter);
+	QFETCH(QByteArray, expected);
+
+	QCOMPARE(toHex(Otp::hotp(Rfc4226Seed, counter)), expected);
+}
+
+void OtpTest::totp_data()
+{
+	QTest::addColumn<qint64>("time");
+	QTest::addColumn<QByteArray>("expected");
+
+	// the HMACs behind the RFC 6238 appendix B SHA1 test vectors (only SHA1 is supported)
+	QTest::newRow("59") << Q_INT64_C(59) << QByteArray("75a48a19d4cbe100644e8ac1397eea747a2d33ab");
+	QTest::newRow("1111111109") << Q_INT64_C(1111111109) << QByteArray("278c02e53610f84c40bd9135acd4101012410a14");
+	QTest::newRow("1111111111") << Q_INT64_C(1111111111) << QByteArray("b0092b21d048af209da0a1ddd498ade8a79487ed");
+	QTest::newRow("1234567890") << Q_INT64_C(1234567890) << QByteArray("907cd1a9116564ecb9d5d1780325f246173fe703");
+	QTest::newRow("2000000000") << Q_INT64_C(2000000000) << QByteArray("25a326d31fc366244cad054976020c7b56b13d5f");
+	QTest::newRow("20000000000") << Q_INT64_C(20000000000) << QByteArray("ab07e97e2c1278769dbcd75783aabde75ed8550a");
+}
+
+void OtpTest::totp()
+{
+	QFETCH(qint64, time);
+	QFETCH(QByteArray, expected);
+
+	QCOMPARE(toHex(Otp::totpAt(Rfc4226Seed, static_cast<time_t>(time), 0, Otp::DefaultInterval)), expected);
+}
+
+void OtpTest::totpBaseline()
+{
+	// the counter is the number of whole intervals since the baseline time
+	QCOMPARE(Otp::totpAt(Rfc4226Seed, 100, 40, 30), Otp::hotp(Rfc4226Seed, 2));
+	QCOMPARE(Otp::totpAt(Rfc4226Seed, 1000, 0, 60), Otp::hotp(Rfc4226Seed, 16));
+}
+
+void OtpTest::totpVirtualClock()
+{
+	// the current TOTP follows the installed clock, and moves to the next code as soon as the clock crosses the boundary
+	Qonvince::VirtualClock clock(Q_INT64_C(1111111109) * 1000);
+	Qonvince::Clock::setCurrent(&clock);
+	QCOMPARE(toHex(Otp::totp(Rfc4226Seed)), QByteArray("278c02e53610f84c40bd9135acd4101012410a14"));
+
+	clock.advance(2000);
+	QCOMPARE(toHex(Otp::totp(Rfc4226Seed)), QByteArray("b0092b21d048af209da0a1ddd498ade8a79487ed"));
+	Qonvince::Clock::setCurrent(nullptr);
+}
+
+void OtpTest::countdown()
+{
+	QCOMPARE(Otp::timeSinceLastCodeAt(59, 0, 30), 29);
+	QCOMPARE(Otp::timeToNextCodeAt(59, 0, 30), 1);
+	QCOMPARE(Otp::timeToNextCodeAt(60, 0, 30), 30);
+	QCOMPARE(Otp::timeToNextCodeAt(100, 40, 60), 60);
+
+	// an unset interval is the default interval
+	QCOMPARE(Otp::timeToNextCodeAt(59, 0, 0), 1);
+}
+
+QTEST_APPLESS_MAIN(OtpTest)
+#include "otp.moc"
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <QtTest>
+#include <QElapsedTimer>
+#include "otp.h"
+#include "otpsearchindex.h"
+#include "base32.h"
+#include "securestring.h"
+#include "allocationcounter.h"
+#include "../../common/displayplugins.h"
+
+using LibQonvince::SecureString;
+using Qonvince::Otp;
+using Qonvince::Bench::allocationCount;
+
+/**
+ * Fails when generating a batch of codes takes longer, or allocates more, than the budgets configured in CMake
+ * (QONVINCE_TEST_BATCH_SIZE, QONVINCE_TEST_TIME_BUDGET_MS and QONVINCE_TEST_ALLOCATION_BUDGET), or when searching an
+ * index of QONVINCE_TEST_SEARCH_SIZE OTPs takes longer than QONVINCE_TEST_SEARCH_BUDGET_US per keystroke.
+ */
+class PerformanceTest
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void hotpBatch();
+	void totpBatch();
+	void formatBatch();
+	void base32Batch();
+	void searchKeystrokes();
+
+private:
+	template<typename Fn>
+	void checkBudget(Fn && generate, qint64 allocationBudget);
+
+	Qonvince::Test::DisplayPluginFactory m_factory{".displayplugin"};
+	const LibQonvince::OtpDisplayPlugin * m_plugin = nullptr;
+};
+
+namespace
+{
+	constexpr const int BatchSize = QONVINCE_TEST_BATCH_SIZE;
+	constexpr const qint64 TimeBudgetMs = QONVINCE_TEST_TIME_BUDGET_MS;
+	constexpr const qint64 AllocationBudget = QONVINCE_TEST_ALLOCATION_BUDGET;
+	constexpr const int SearchSize = QONVINCE_TEST_SEARCH_SIZE;
+	constexpr const qint64 SearchBudgetUs = QONVINCE_TEST_SEARCH_BUDGET_US;
+
+	const SecureString Seed = "12345678901234567890";
+}	// namespace
+
+void PerformanceTest::initTestCase()
+{
+	Qonvince::Test::loadBuiltDisplayPlugins(m_factory);
+	m_plugin = m_factory.pluginByName("SixDigitsPlugin");
+	QVERIFY(m_plugin);
+}
+
+template<typename Fn>
+void PerformanceTest::checkBudget(Fn && generate, qint64 allocationBudget)
+{
+	// once untimed so that lazily-initialised state isn't charged to the batch
+	generate(0);
+
+	const auto allocationsBefore = allocationCount();
+	QElapsedTimer timer;
+	timer.start();
+
+	for(int idx = 0; idx < BatchSize; ++idx) {
+		generate(idx);
+	}
+
+	const auto elapsed = timer.elapsed();
+	const auto allocations = static_cast<qint64>(allocationCount() - allocationsBefore);
+
+	QVERIFY2(elapsed <= TimeBudgetMs, qPrintable(QStringLiteral("%1 codes took %2ms, budget is %3ms").arg(BatchSize).arg(elapsed).arg(TimeBudgetMs)));
+	QVERIFY2(allocations <= allocationBudget * BatchSize, qPrintable(QStringLiteral("%1 codes made %2 allocations, budget is %3 per code").arg(BatchSize).arg(allocations).arg(allocationBudget)));
+}
+
+void PerformanceTest::hotpBatch()
+{
+	SecureString code;
+
+	checkBudget([this, &code](int idx) {
+		code = m_plugin->codeDisplayString(Otp::hotp(Seed, static_cast<std::uint64_t>(idx)));
+	}, AllocationBudget);
+
+	QCOMPARE(code.size(), std::size_t{6});
+}
+
+void PerformanceTest::totpBatch()
+{
+	SecureString code;
+
+	checkBudget([this, &code](int idx) {
+		code = m_plugin->codeDisplayString(Otp::totpAt(Seed, static_cast<time_t>(idx) * Otp::DefaultInterval, 0, Otp::DefaultInterval));
+	}, AllocationBudget);
+
+	QCOMPARE(code.size(), std::size_t{6});
+}
+
+void PerformanceTest::formatBatch()
+{
+	using LibQonvince::OtpDisplayPlugin;
+
+	// formatting a digest into a buffer the caller provides must never allocate
+	std::vector<char> digests(BatchSize * OtpDisplayPlugin::DigestSize);
+
+	for(int idx = 0; idx < BatchSize; ++idx) {
+		const auto hmac = Otp::hotp(Seed, static_cast<std::uint64_t>(idx));
+		std::copy_n(hmac.cbegin(), OtpDisplayPlugin::DigestSize, digests.begin() + idx * static_cast<int>(OtpDisplayPlugin::DigestSize));
+	}
+
+	std::vector<char> codes(BatchSize * OtpDisplayPlugin::MaxCodeLength);
+	std::vector<std::size_t> lengths(BatchSize);
+
+	checkBudget([this, &digests, &codes, &lengths](int idx) {
+		const auto offset = static_cast<std::size_t>(idx);
+		m_plugin->writeCodes(std::span<const char>(digests).subspan(offset * OtpDisplayPlugin::DigestSize, OtpDisplayPlugin::DigestSize),
+									std::span<char>(codes).subspan(offset * OtpDisplayPlugin::MaxCodeLength, OtpDisplayPlugin::MaxCodeLength),
+									std::span<std::size_t>(lengths).subspan(offset, 1));
+	}, 0);
+
+	QCOMPARE(lengths.front(), std::size_t{6});
+	QCOMPARE(lengths.back(), std::size_t{6});
+}
+
+void PerformanceTest::base32Batch()
+{
+	// decoding a seed into a buffer the caller provides must never allocate
+	const std::string encoded = "GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ";
+	std::vector<char> plain(LibQonvince::Base32Codec::maxDecodedSize(encoded.size()));
+	bool ok = true;
+
+	checkBudget([&encoded, &plain, &ok](int) {
+		ok = LibQonvince::Base32Codec::decode(std::span<const char>(encoded), std::span<char>(plain)).has_value() && ok;
+	}, 0);
+
+	QVERIFY(ok);
+}
+
+void PerformanceTest::searchKeystrokes()
+{
+	static constexpr const std::array<const char *, 20> Issuers = {
+		"GitHub", "GitLab", "Amazon Web Services", "Google", "Microsoft", "Dropbox", "Bitbucket",
+		"Slack", "Discord", "Twitter", "Facebook", "Reddit", "DigitalOcean", "Cloudflare",
+		"Heroku", "Stripe", "PayPal", "Coinbase", "Fastmail", "Proton",
+	};
+
+	std::vector<std::unique_ptr<Otp>> otps;
+	otps.reserve(SearchSize);
+	Qonvince::OtpSearchIndex index;
+
+	// without a display plugin or an event loop each OTP complains as it's created, which would swamp the output
+	std::cerr.setstate(std::ios::failbit);
+	const auto previousHandler = qInstallMessageHandler([](QtMsgType, const QMessageLogContext &, const QString &) {});
+
+	for(int idx = 0; idx < SearchSize; ++idx) {
+		const auto issuer = QString::fromLatin1(Issuers[static_cast<std::size_t>(idx) % Issuers.size()]);
+		auto & otp = otps.emplace_back(
+			std::make_unique<Otp>(Qonvince::OtpType::Hotp, issuer, QStringLiteral("user%1").arg(idx), QByteArray()));
+		index.add(otp.get());
+	}
+
+	qInstallMessageHandler(previousHandler);
+	std::cerr.clear();
+
+	// the query as it is typed, one search per keystroke
+	const auto query = QStringLiteral("github user%1").arg(SearchSize / 2);
+	constexpr const int Repetitions = 10;
+	std::size_t matches = 0;
+	QElapsedTimer timer;
+	timer.start();
+
+	for(int repetition = 0; repetition < Repetitions; ++repetition) {
+		for(int length = 1; length <= query.size(); ++length) {
+			matches = index.search(query.left(length)).size();
+		}
+	}
+
+	const auto elapsedUs = timer.nsecsElapsed() / 1000;
+	const auto keystrokes = static_cast<qint64>(Repetitions) * query.size();
+
+	QCOMPARE(matches, std::size_t{1});
+	QVERIFY2(elapsedUs <= SearchBudgetUs * keystrokes,
+		qPrintable(QStringLiteral("%1 keystrokes against %2 OTPs took %3us, budget is %4us per keystroke")
+			.arg(keystrokes).arg(SearchSize).arg(elapsedUs).arg(SearchBudgetUs)));
+}
+
+QTEST_APPLESS_MAIN(PerformanceTest)
+#include "performance.moc"
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2015 - 2022 Darren Edale
+ *
+ * This file is part of Qonvince.
+ *
+ * Qonvince is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Qonvince is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Qonvince. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+#include <vector>
+#include <QtTest>
+#include "otp.h"
+#include "otpsearchindex.h"
+
+using Qonvince::Otp;
+using Qonvince::OtpSearchIndex;
+using Qonvince::OtpType;
+
+class SearchIndexTest
+: public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void init();
+	void cleanup();
+	void fold_data();
+	void fold();
+	void search_data();
+	void search();
+	void ranking();
+	void useRanking();
+	void rename();
+	void removal();
+
+private:
+	// adds an OTP to both the index and the set owned by the test
+	Otp * addOtp(const QString & issuer, const QString & name);
+
+	// the labels of the search results, in order
+	QStringList search(const QString & query) const;
+
+	std::unique_ptr<OtpSearchIndex> m_index;
+	std::vector<std::unique_ptr<Otp>> m_otps;
+};
+
+Otp * SearchIndexTest::addOtp(const QString & issuer, const QString & name)
+{
+	auto & otp = m_otps.emplace_back(std::make_unique<Otp>(OtpType::Hotp, issuer, name, QByteArray()));
+	m_index->add(otp.get());
+	return otp.get();
+}
+
+QStringList SearchIndexTest::search(const QString & query) const
+{
+	QStringList labels;
+
+	for(const auto * otp : m_index->search(query)) {
+		labels.append(otp->issuer() + QLatin1Char(':') + otp->name());
+	}
+
+	return labels;
+}
+
+void SearchIndexTest::init()
+{
+	m_index = std::make_unique<OtpSearchIndex>();
+	addOtp(QStringLiteral("GitHub"), QStringLiteral("darren"));
+	addOtp(QStringLiteral("Amazon Web Services"), QStringLiteral("production"));
+	addOtp(QStringLiteral("Amazon Web Services"), QStringLiteral("staging"));
+	addOtp(QStringLiteral("Société Générale"), QStringLiteral("compte"));
+	addOtp(QStringLiteral("Bitbucket"), QStringLiteral("github-mirror"));
+}
+
+void SearchIndexTest::cleanup()
+{
+	m_index.reset();
+	m_otps.clear();
+}
+
+void SearchIndexTest::fold_data()
+{
+	QTest::addColumn<QString>("text");
+	QTest::addColumn<QString>("expected");
+
+	QTest::newRow("case") << QStringLiteral("GitHub") << QStringLiteral("github");
+	QTest::newRow("accents") << QStringLiteral("Société") << QStringLiteral("societe");
+	QTest::newRow("compatibility forms") << QStringLiteral("ﬁle") << QStringLiteral("file");
+}
+
+void SearchIndexTest::fold()
+{
+	QFETCH(QString, text);
+	QFETCH(QString, expected);
+	QCOMPARE(OtpSearchIndex::fold(text), expected);
+}
+
+void SearchIndexTest::search_data()
+{
+	QTest::addColumn<QString>("query");
+	QTest::addColumn<QStringList>("expected");
+
+	QTest::newRow("empty") << QString() << QStringList();
+	QTest::newRow("whitespace") << QStringLiteral("  ") << QStringList();
+	QTest::newRow("issuer substring") << QStringLiteral("bucket") << QStringList({QStringLiteral("Bitbucket:github-mirror")});
+	QTest::newRow("name substring") << QStringLiteral("stag") << QStringList({QStringLiteral("Amazon Web Services:staging")});
+	QTest::newRow("folded") << QStringLiteral("GENERALE") << QStringList({QStringLiteral("Société Générale:compte")});
+	QTest::newRow("short term at word start") << QStringLiteral("w") << QStringList({QStringLiteral("Amazon Web Services:production"), QStringLiteral("Amazon Web Services:staging")});
+	QTest::newRow("short term not at word start") << QStringLiteral("eb") << QStringList();
+	QTest::newRow("all terms") << QStringLiteral("amazon prod") << QStringList({QStringLiteral("Amazon Web Services:production")});
+	QTest::newRow("term spanning issuer and name") << QStringLiteral("hubdarren") << QStringList();
+	QTest::newRow("no match") << QStringLiteral("gitlab") << QStringList();
+}
+
+void SearchIndexTest::search()
+{
+	QFETCH(QString, query);
+	QFETCH(QStringList, expected);
+	QCOMPARE(search(query), expected);
+}
+
+void SearchIndexTest::ranking()
+{
+	addOtp(QStringLiteral("Hub"), QStringLiteral("ops"));
+	addOtp(QStringLiteral("Backups"), QStringLiteral("s3-hub"));
+
+	// the start of the issuer or name beats the start of another word, which beats anywhere else
+	QCOMPARE(search(QStringLiteral("hub")), QStringList({QStringLiteral("Hub:ops"), QStringLiteral("Backups:s3-hub"), QStringLiteral("GitHub:darren"), QStringLiteral("Bitbucket:github-mirror")}));
+}
+
+void SearchIndexTest::useRanking()
+{
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList({QStringLiteral("Amazon Web Services:production"), QStringLiteral("Amazon Web Services:staging")}));
+
+	m_index->noteUse(m_otps[2].get());
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList({QStringLiteral("Amazon Web Services:staging"), QStringLiteral("Amazon Web Services:production")}));
+
+	m_index->noteUse(m_otps[1].get());
+	m_index->noteUse(m_otps[1].get());
+	m_index->noteUse(m_otps[1].get());
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList({QStringLiteral("Amazon Web Services:production"), QStringLiteral("Amazon Web Services:staging")}));
+
+	// used more often wins over used more recently
+	m_index->noteUse(m_otps[2].get());
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList({QStringLiteral("Amazon Web Services:production"), QStringLiteral("Amazon Web Services:staging")}));
+
+	// and used more recently wins when they've been used as often
+	m_index->noteUse(m_otps[2].get());
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList({QStringLiteral("Amazon Web Services:staging"), QStringLiteral("Amazon Web Services:production")}));
+
+	// but the quality of the match comes first
+	QCOMPARE(search(QStringLiteral("prod")), QStringList({QStringLiteral("Amazon Web Services:production")}));
+}
+
+void SearchIndexTest::rename()
+{
+	QSignalSpy changed(m_index.get(), &OtpSearchIndex::otpChanged);
+	auto * otp = m_otps[0].get();
+	otp->setIssuer(QStringLiteral("GitLab"));
+
+	QCOMPARE(changed.count(), 1);
+	QCOMPARE(search(QStringLiteral("gitlab")), QStringList({QStringLiteral("GitLab:darren")}));
+	QCOMPARE(search(QStringLiteral("github")), QStringList({QStringLiteral("Bitbucket:github-mirror")}));
+
+	otp->setName(QStringLiteral("ops"));
+	QCOMPARE(changed.count(), 2);
+	QCOMPARE(search(QStringLiteral("darren")), QStringList());
+	QCOMPARE(search(QStringLiteral("o")), QStringList({QStringLiteral("GitLab:ops")}));
+}
+
+void SearchIndexTest::removal()
+{
+	QCOMPARE(m_index->size(), m_otps.size());
+
+	m_index->remove(m_otps[1].get());
+	QVERIFY(!m_index->contains(m_otps[1].get()));
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList({QStringLiteral("Amazon Web Services:staging")}));
+
+	// destroyed OTPs leave the index by themselves
+	m_otps.erase(m_otps.begin() + 2);
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList());
+	QCOMPARE(m_index->size(), m_otps.size() - 1);
+
+	// removed entries are reused
+	addOtp(QStringLiteral("Amazon"), QStringLiteral("retail"));
+	QCOMPARE(search(QStringLiteral("amazon")), QStringList({QStringLiteral("Amazon:retail")}));
+}
+
+QTEST_GUILESS_MAIN(SearchIndexTest)
+
+#include "searchindex.moc"